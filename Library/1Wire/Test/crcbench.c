@@ -0,0 +1,151 @@
+/////////////////////////////////////////////////////////////////////////
+///	\file	crcbench.c
+///	\brief host benchmark for the ONEWIRE_CRC_METHOD variants.
+///
+///	\section CRCBenchmark CRC benchmark
+///
+///	Checks OneWire_CRCUpdate() against the bitwise Dallas CRC for every
+///	CRC and data byte pair, checks a known ROM code and then times
+///	OneWire_CalculateCRC() over a scratch pad sized block. The method is
+///	picked at compile time, so build it once per method:
+///
+///	\code
+///	cd Library/1Wire/Test
+///	for m in ONEWIRE_CRC_BITWISE ONEWIRE_CRC_NIBBLE ONEWIRE_CRC_TABLE; do
+///		gcc -std=c99 -O2 -DONEWIRE_CRC_METHOD=$m -I.. crcbench.c ../onewire.c ../uart.c ../cyclecounter.c -o crcbench && ./crcbench
+///	done
+///	\endcode
+///
+///	A count is one ns on the host and one CPU clock on Cortex-M, see
+///	cyclecounter.c.
+///
+///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
+///	Website: www.HashDefineElectronics.com
+///
+///	Licences:
+///
+///		Copyright (c) 2014 Ronald Alexander Nobrega De Sousa
+///
+///		Permission is hereby granted, free of charge, to any person obtaining a copy
+///		of this software and associated documentation files (the "Software"), to deal
+///		in the Software without restriction, including without limitation the rights
+///		to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+///		copies of the Software, and to permit persons to whom the Software is
+///		furnished to do so, subject to the following conditions:
+///
+///		The above copyright notice and this permission notice shall be included in
+///		all copies or substantial portions of the Software.
+///
+///		THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///		IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///		FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///		AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///		LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///		THE SOFTWARE.
+/////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdint.h>
+#include "common.h"
+#include "onewire.h"
+#include "cyclecounter.h"
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Block length timed, a DS18B20 scratch pad
+/////////////////////////////////////////////////////////////////////////
+#define CRCBENCH_LENGTH 9
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	How many times the block is run through the CRC
+/////////////////////////////////////////////////////////////////////////
+#define CRCBENCH_ROUNDS 200000UL
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Keeps the compiler from dropping the timed loop
+/////////////////////////////////////////////////////////////////////////
+static volatile uint8_t CRCBenchSink;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Reference Dallas CRC, one bit at a time
+/////////////////////////////////////////////////////////////////////////
+static uint8_t CRCBench_Reference(uint8_t crc, uint8_t data)
+{
+	uint8_t BitIndex;
+
+	crc = crc ^ data;
+
+	for(BitIndex = 0; BitIndex < 8; BitIndex++)
+	{
+		crc = (crc & 0x01) ? ((crc >> 1) ^ 0x8C) : (crc >> 1);
+	}
+
+	return crc;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Name of the method this was built with
+/////////////////////////////////////////////////////////////////////////
+static const char *CRCBench_Method(void)
+{
+#if ONEWIRE_CRC_METHOD == ONEWIRE_CRC_TABLE
+	return "table";
+#elif ONEWIRE_CRC_METHOD == ONEWIRE_CRC_NIBBLE
+	return "nibble";
+#else
+	return "bitwise";
+#endif
+}
+
+int main(void)
+{
+	// ROM code from the Maxim application note 27 example, CRC 0xA2
+	uint8_t Rom[8] = {0x02, 0x1C, 0xB8, 0x01, 0x00, 0x00, 0x00, 0xA2};
+	uint8_t Block[CRCBENCH_LENGTH];
+	uint32_t Start;
+	uint32_t Elapsed;
+	uint32_t Round;
+	uint32_t Errors = 0;
+	uint16_t Crc;
+	uint16_t Data;
+
+	for(Crc = 0; Crc < 256; Crc++)
+	{
+		for(Data = 0; Data < 256; Data++)
+		{
+			if(OneWire_CRCUpdate((uint8_t)Crc, (uint8_t)Data) != CRCBench_Reference((uint8_t)Crc, (uint8_t)Data))
+			{
+				Errors++;
+			}
+		}
+	}
+
+	if(OneWire_CalculateCRC(Rom, sizeof(Rom)))
+	{
+		Errors++;
+	}
+
+	for(Data = 0; Data < CRCBENCH_LENGTH; Data++)
+	{
+		Block[Data] = (uint8_t)(Data * 37 + 11);
+	}
+
+	CycleCounter_Init();
+
+	Start = CycleCounter_Read();
+
+	for(Round = 0; Round < CRCBENCH_ROUNDS; Round++)
+	{
+		Block[0] = (uint8_t)Round;
+		CRCBenchSink = OneWire_CalculateCRC(Block, CRCBENCH_LENGTH);
+	}
+
+	Elapsed = CycleCounter_Read() - Start;
+
+	printf("%-8s %6.2f counts/byte  %7.2f counts/scratchpad  %s\n",
+		CRCBench_Method(),
+		(double)Elapsed / ((double)CRCBENCH_ROUNDS * CRCBENCH_LENGTH),
+		(double)Elapsed / (double)CRCBENCH_ROUNDS,
+		Errors ? "FAIL" : "ok");
+
+	return Errors ? 1 : 0;
+}
@@ -0,0 +1,213 @@
+/////////////////////////////////////////////////////////////////////////
+///	\file	echobench.c
+///	\brief simulated bus check that the echoes of a failed transfer are
+///	not taken for the presence pulse.
+///
+///	\section EchoBenchmark Late echo check
+///
+///	The simulated UART is set to take OneWireSimType EchoPolls polls per
+///	character, so like a real UART the echo of a slot arrives some time
+///	after it was queued. A read is then made to give up on its first slot
+///	with the slot still on the line, and the bus has to recover from it:
+///
+///	- presence: the only device is taken off and the reset must report
+///	  no presence, not the echo of the abandoned read slot
+///	- blocking: reset, skip ROM and read the scratch pad with the blocking
+///	  calls, the CRC must match
+///	- engine: the same read as a transaction, it must finish with no retry
+///
+///	Every echo delay from 4 to ECHOBENCH_MAX_POLLS polls is tried, any
+///	shorter and the read gets its echo before it gives up.
+///
+///	\code
+///	cd Library/1Wire/Test
+///	gcc -std=c99 -O2 -DONEWIRE_SIMULATION -I.. echobench.c ../onewire.c ../uart.c ../onewiresim.c ../cyclecounter.c -o echobench && ./echobench
+///	\endcode
+///
+///
+///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
+///	Website: www.HashDefineElectronics.com
+///
+///	Licences:
+///
+///		Copyright (c) 2014 Ronald Alexander Nobrega De Sousa
+///
+///		Permission is hereby granted, free of charge, to any person obtaining a copy
+///		of this software and associated documentation files (the "Software"), to deal
+///		in the Software without restriction, including without limitation the rights
+///		to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+///		copies of the Software, and to permit persons to whom the Software is
+///		furnished to do so, subject to the following conditions:
+///
+///		The above copyright notice and this permission notice shall be included in
+///		all copies or substantial portions of the Software.
+///
+///		THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///		IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///		FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///		AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///		LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///		THE SOFTWARE.
+/////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdint.h>
+#include "common.h"
+#include "onewire.h"
+#include "onewiresim.h"
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Failed transfers and recoveries per echo delay
+/////////////////////////////////////////////////////////////////////////
+#define ECHOBENCH_ROUNDS 200UL
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Longest echo delay tried, in UART polls per character
+/////////////////////////////////////////////////////////////////////////
+#define ECHOBENCH_MAX_POLLS 16
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Leave a slot on the line, its echo still to come. The read
+///	gives up on the first slot because the timeout is shorter than a
+///	character.
+///
+///	\return FALSE if the read failed like it should else TRUE
+/////////////////////////////////////////////////////////////////////////
+static uint_fast8_t EchoBench_Abandon(OneWireBusType *bus)
+{
+	uint8_t Scratchpad[9];
+	uint32_t Timeout = bus->Policy.Timeout;
+	int_fast8_t Error;
+
+	bus->Policy.Timeout = 1;
+	Error = OneWireBus_ReadBlock(bus, Scratchpad, sizeof(Scratchpad));
+	bus->Policy.Timeout = Timeout;
+
+	return (OW_Timeout != Error);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read the scratch pad with the blocking calls
+///
+///	\return FALSE on success else TRUE
+/////////////////////////////////////////////////////////////////////////
+static uint_fast8_t EchoBench_Read(OneWireBusType *bus)
+{
+	uint8_t Scratchpad[9];
+
+	if(OneWireBus_Reset(bus) || OneWireBus_Write(bus, 0xCC) || OneWireBus_Write(bus, 0xBE))
+	{
+		return TRUE;
+	}
+
+	if(OneWireBus_ReadBlock(bus, Scratchpad, sizeof(Scratchpad)))
+	{
+		return TRUE;
+	}
+
+	return (OneWire_CalculateCRC(Scratchpad, sizeof(Scratchpad)) != 0);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read the scratch pad with the transaction engine
+///
+///	\return FALSE on success else TRUE
+/////////////////////////////////////////////////////////////////////////
+static uint_fast8_t EchoBench_Submit(OneWireBusType *bus)
+{
+	OneWireTransactionType Transaction = {0};
+	uint8_t Scratchpad[9];
+
+	Transaction.Flags = ONEWIRE_TRANSACTION_RESET | ONEWIRE_TRANSACTION_ROM | ONEWIRE_TRANSACTION_FUNCTION;
+	Transaction.RomCommand = 0xCC;
+	Transaction.FunctionCommand = 0xBE;
+	Transaction.RxData = Scratchpad;
+	Transaction.RxLength = sizeof(Scratchpad);
+
+	if(OneWireBus_Submit(bus, &Transaction))
+	{
+		return TRUE;
+	}
+
+	while(OneWireBus_Busy(bus))
+	{
+		OneWireBus_Poll(bus);
+	}
+
+	// No retries, the first reset has to be read right
+	if((OWT_Done != Transaction.State) || Transaction.Attempt)
+	{
+		return TRUE;
+	}
+
+	return (OneWire_CalculateCRC(Scratchpad, sizeof(Scratchpad)) != 0);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Run one mode over every echo delay and print the result
+///
+///	\param name the mode
+///	\param mode 0 reset an empty bus, 1 blocking read, 2 engine read
+///	\param sensor the only device, detached while the empty bus is reset
+///	\return the number of failures
+/////////////////////////////////////////////////////////////////////////
+static uint32_t EchoBench_Run(const char *name, uint_fast8_t mode, OneWireSimDeviceType *sensor)
+{
+	OneWireBusType *Bus = &OneWireDefaultBus;
+	uint32_t Errors = 0;
+	uint32_t Checked = 0;
+	uint32_t Polls;
+	uint32_t Round;
+
+	for(Polls = 4; Polls <= ECHOBENCH_MAX_POLLS; Polls++)
+	{
+		OneWireSimBus.EchoPolls = Polls;
+
+		for(Round = 0; Round < ECHOBENCH_ROUNDS; Round++)
+		{
+			Errors += EchoBench_Abandon(Bus);
+
+			switch(mode)
+			{
+				case 0:
+					OneWireSim_Detach(&OneWireSimBus, sensor);
+					Errors += (OW_NoPresence != OneWireBus_Reset(Bus));
+					OneWireSim_Attach(&OneWireSimBus, sensor);
+					break;
+				case 1:
+					Errors += EchoBench_Read(Bus);
+					break;
+				default:
+					Errors += EchoBench_Submit(Bus);
+					break;
+			}
+
+			Checked++;
+		}
+	}
+
+	OneWireSimBus.EchoPolls = 0;
+
+	printf("%-9s %6lu recoveries  %6lu failed  %s\n", name, (unsigned long)Checked, (unsigned long)Errors, Errors ? "FAIL" : "ok");
+
+	return Errors;
+}
+
+int main(void)
+{
+	OneWireSimDeviceType Sensor;
+	uint32_t Errors = 0;
+
+	OneWireSim_Init(&OneWireSimBus);
+	OneWireSim_DeviceInit(&Sensor, 0x28, 0x1234);
+	OneWireSim_SetTemperature(&Sensor, 21.5f);
+	OneWireSim_Attach(&OneWireSimBus, &Sensor);
+
+	OneWire_Init();
+
+	Errors += EchoBench_Run("presence", 0, &Sensor);
+	Errors += EchoBench_Run("blocking", 1, &Sensor);
+	Errors += EchoBench_Run("engine", 2, &Sensor);
+
+	return Errors ? 1 : 0;
+}
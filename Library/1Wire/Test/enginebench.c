@@ -0,0 +1,439 @@
+/////////////////////////////////////////////////////////////////////////
+///	\file	enginebench.c
+///	\brief simulated bus check of the transaction engine retries and
+///	timeouts.
+///
+///	\section EngineBenchmark Transaction engine check
+///
+///	Reads the scratch pad of a simulated sensor as a transaction, through
+///	a UART that can refuse writes and lose echoes at a random slot:
+///
+///	- clean: no fault, done with no retry
+///	- refused: 1 to ENGINEBENCH_RETRIES writes refused, done after as
+///	  many retries
+///	- refusedout: more writes refused than there are retries, OW_Timeout
+///	- lost: 1 to ENGINEBENCH_RETRIES echoes lost, done after as many
+///	  retries
+///	- lostout: more echoes lost than there are retries, OW_Timeout
+///	- gone: the sensor is taken off, OW_NoPresence after every retry
+///	- noretry: a transaction policy without retries fails on the first
+///	  refused write, without waiting out the echo timeout
+///	- fallback: the bus is left at overdrive speed, nothing answers the
+///	  overdrive reset so the bus goes back to standard and the retry is
+///	  done
+///	- blocking: a refused write fails the blocking read with OW_Timeout
+///
+///	Half the rounds reset the bus on its own before a retry. After every
+///	round a clean read has to work straight away.
+///
+///	\code
+///	cd Library/1Wire/Test
+///	gcc -std=c99 -O2 -DONEWIRE_SIMULATION -DONEWIRE_STATS=1 -I.. enginebench.c ../onewire.c ../uart.c ../onewiresim.c ../cyclecounter.c -o enginebench && ./enginebench
+///	\endcode
+///
+///
+///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
+///	Website: www.HashDefineElectronics.com
+///
+///	Licences:
+///
+///		Copyright (c) 2014 Ronald Alexander Nobrega De Sousa
+///
+///		Permission is hereby granted, free of charge, to any person obtaining a copy
+///		of this software and associated documentation files (the "Software"), to deal
+///		in the Software without restriction, including without limitation the rights
+///		to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+///		copies of the Software, and to permit persons to whom the Software is
+///		furnished to do so, subject to the following conditions:
+///
+///		The above copyright notice and this permission notice shall be included in
+///		all copies or substantial portions of the Software.
+///
+///		THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///		IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///		FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///		AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///		LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///		THE SOFTWARE.
+/////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "common.h"
+#include "onewire.h"
+#include "onewiresim.h"
+#include "uart.h"
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Transactions run in each case
+/////////////////////////////////////////////////////////////////////////
+#define ENGINEBENCH_ROUNDS 500UL
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Retries allowed by the bench policy
+/////////////////////////////////////////////////////////////////////////
+#define ENGINEBENCH_RETRIES 3
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Polls before a transaction counts as stuck
+/////////////////////////////////////////////////////////////////////////
+#define ENGINEBENCH_MAX_POLLS 100000UL
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Skip ROM and read scratch pad commands
+/////////////////////////////////////////////////////////////////////////
+#define ENGINEBENCH_SKIP_ROM 0xCC
+#define ENGINEBENCH_READ_SCRATCHPAD 0xBE
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	The cases
+/////////////////////////////////////////////////////////////////////////
+typedef enum{
+	EB_Clean = 0,		///< No fault, done first time
+	EB_Refused,			///< The UART refuses up to ENGINEBENCH_RETRIES writes, done after one retry each
+	EB_RefusedOut,		///< The UART refuses more writes than there are retries, OW_Timeout
+	EB_Lost,			///< Up to ENGINEBENCH_RETRIES echoes never arrive, done after one retry each
+	EB_LostOut,			///< More echoes are lost than there are retries, OW_Timeout
+	EB_Gone,			///< The device is taken off, OW_NoPresence after every retry
+	EB_NoRetry,			///< A transaction policy without retries, the first refused write is OW_Timeout
+	EB_Fallback,		///< The bus is left at overdrive, falls back to standard and is done after one retry
+	EB_Blocking,		///< A refused write fails the blocking calls with OW_Timeout
+	EB_Count
+} EngineBenchCaseEnum;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	A uart.c port that can refuse writes and lose echoes
+/////////////////////////////////////////////////////////////////////////
+typedef struct
+{
+	UartPortType *Port;			///< The port underneath
+	uint32_t WritesBefore;		///< Writes let through before the first refused one
+	uint32_t WriteFailures;		///< Writes refused after that
+	uint32_t EchoesBefore;		///< Echoes let through before the first lost one
+	uint32_t EchoFailures;		///< Echoes lost after that
+} EngineBenchUartType;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	xorshift state, fixed seed so a failure can be repeated
+/////////////////////////////////////////////////////////////////////////
+static uint32_t EngineBenchSeed = 0x2545F491UL;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Random number
+/////////////////////////////////////////////////////////////////////////
+static uint32_t EngineBench_Random(void)
+{
+	EngineBenchSeed ^= EngineBenchSeed << 13;
+	EngineBenchSeed ^= EngineBenchSeed >> 17;
+	EngineBenchSeed ^= EngineBenchSeed << 5;
+
+	return EngineBenchSeed;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	EngineBenchUartType adapters for EngineBenchOps
+/////////////////////////////////////////////////////////////////////////
+static uint_fast8_t EngineBench_Setbaud(void *context, uint32_t baud)
+{
+	return UartPort_Setbaud(((EngineBenchUartType *)context)->Port, baud);
+}
+
+static uint_fast8_t EngineBench_Write(void *context, const uint8_t *source, uint_fast8_t length)
+{
+	EngineBenchUartType *Uart = (EngineBenchUartType *)context;
+
+	if(Uart->WritesBefore)
+	{
+		Uart->WritesBefore--;
+	}
+	else if(Uart->WriteFailures)
+	{
+		Uart->WriteFailures--;
+		return TRUE;
+	}
+
+	return UartPort_Write(Uart->Port, source, length);
+}
+
+static uint_fast8_t EngineBench_Read(void *context, uint8_t *destination, uint_fast8_t length)
+{
+	EngineBenchUartType *Uart = (EngineBenchUartType *)context;
+	uint_fast8_t Count = UartPort_Read(Uart->Port, destination, length);
+
+	if(!Count)
+	{
+		return 0;
+	}
+
+	if(Uart->EchoesBefore)
+	{
+		Uart->EchoesBefore--;
+	}
+	else if(Uart->EchoFailures)
+	{
+		Uart->EchoFailures--;
+		return 0;
+	}
+
+	return Count;
+}
+
+static uint_fast8_t EngineBench_WriteSpace(void *context)
+{
+	return UartPort_WriteSpace(((EngineBenchUartType *)context)->Port);
+}
+
+static uint_fast8_t EngineBench_Break(void *context, uint32_t low, uint32_t idle)
+{
+	return UartPort_Break(((EngineBenchUartType *)context)->Port, low, idle);
+}
+
+static uint_fast8_t EngineBench_WriteComplete(void *context)
+{
+	return UartPort_WriteComplete(((EngineBenchUartType *)context)->Port);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	UART operations for EngineBenchUartType
+/////////////////////////////////////////////////////////////////////////
+static const OneWireUartOpsType EngineBenchOps =
+{
+	EngineBench_Setbaud,
+	EngineBench_Write,
+	EngineBench_Read,
+	EngineBench_WriteSpace,
+	EngineBench_Break,
+	EngineBench_WriteComplete
+};
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Run a scratch pad read as a transaction until it's finished
+///
+///	\param bus the bus
+///	\param policy the transaction policy or NULL for the bus one
+///	\param transaction where to return the finished transaction
+///	\param scratchpad where to read the scratch pad
+///	\param polls where to return the polls it took
+///	\return FALSE once finished else TRUE if it never finished
+/////////////////////////////////////////////////////////////////////////
+static uint_fast8_t EngineBench_Transaction(OneWireBusType *bus, const OneWirePolicyType *policy, OneWireTransactionType *transaction, uint8_t *scratchpad, uint32_t *polls)
+{
+	uint32_t Polls;
+
+	memset(transaction, 0, sizeof(OneWireTransactionType));
+	transaction->Flags = ONEWIRE_TRANSACTION_RESET | ONEWIRE_TRANSACTION_ROM | ONEWIRE_TRANSACTION_FUNCTION;
+	transaction->RomCommand = ENGINEBENCH_SKIP_ROM;
+	transaction->FunctionCommand = ENGINEBENCH_READ_SCRATCHPAD;
+	transaction->RxData = scratchpad;
+	transaction->RxLength = ONEWIRESIM_SCRATCHPAD_LENGTH;
+	transaction->Policy = policy;
+
+	if(OneWireBus_Submit(bus, transaction))
+	{
+		return TRUE;
+	}
+
+	for(Polls = 0; OneWireBus_Busy(bus); Polls++)
+	{
+		if(Polls == ENGINEBENCH_MAX_POLLS)
+		{
+			return TRUE;
+		}
+
+		OneWireBus_Poll(bus);
+	}
+
+	*polls = Polls;
+
+	return FALSE;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read the scratch pad with the blocking calls
+///
+///	\return the first error
+/////////////////////////////////////////////////////////////////////////
+static int_fast8_t EngineBench_Blocking(OneWireBusType *bus, uint8_t *scratchpad)
+{
+	int_fast8_t Result = (int_fast8_t)OneWireBus_Reset(bus);
+
+	if(!Result)
+	{
+		Result = OneWireBus_Write(bus, ENGINEBENCH_SKIP_ROM);
+	}
+
+	if(!Result)
+	{
+		Result = OneWireBus_Write(bus, ENGINEBENCH_READ_SCRATCHPAD);
+	}
+
+	if(!Result)
+	{
+		Result = OneWireBus_ReadBlock(bus, scratchpad, ONEWIRESIM_SCRATCHPAD_LENGTH);
+	}
+
+	return Result;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Run one case once
+///
+///	\return FALSE if it went as expected else TRUE
+/////////////////////////////////////////////////////////////////////////
+static uint_fast8_t EngineBench_Run(OneWireBusType *bus, EngineBenchUartType *uart, OneWireSimDeviceType *sensor, EngineBenchCaseEnum test)
+{
+	static const OneWirePolicyType NoRetry = {1000, ONEWIRE_BUSY_POLLS, 4, 0, TRUE};
+	OneWireTransactionType Transaction;
+	const OneWirePolicyType *Policy = 0;
+	uint8_t Scratchpad[ONEWIRESIM_SCRATCHPAD_LENGTH];
+	uint8_t ExpectedState = OWT_Done;
+	uint8_t ExpectedError = OW_Success;
+	uint32_t ExpectedRetries = 0;
+	uint32_t Faults = 1 + (EngineBench_Random() % ENGINEBENCH_RETRIES);
+	uint32_t Polls;
+	uint_fast8_t Failed;
+
+	// Anywhere in the transaction. Skip ROM and read scratch pad take 16
+	// slots, the scratch pad 72 more, and one more for the reset
+	uart->WritesBefore = EngineBench_Random() % (1 + 16 + 72);
+	uart->WriteFailures = 0;
+	uart->EchoesBefore = uart->WritesBefore;
+	uart->EchoFailures = 0;
+
+	bus->Policy.ResetBeforeRetry = (uint8_t)(EngineBench_Random() & 1);
+
+	OneWireBus_StatsReset(bus);
+
+	switch(test)
+	{
+		case EB_Refused:
+			uart->WriteFailures = Faults;
+			ExpectedRetries = Faults;
+			break;
+
+		case EB_RefusedOut:
+			uart->WriteFailures = ENGINEBENCH_RETRIES + 1;
+			ExpectedRetries = ENGINEBENCH_RETRIES;
+			ExpectedState = OWT_Error;
+			ExpectedError = OW_Timeout;
+			break;
+
+		case EB_Lost:
+			uart->EchoFailures = Faults;
+			ExpectedRetries = Faults;
+			break;
+
+		case EB_LostOut:
+			uart->EchoFailures = ENGINEBENCH_RETRIES + 1;
+			ExpectedRetries = ENGINEBENCH_RETRIES;
+			ExpectedState = OWT_Error;
+			ExpectedError = OW_Timeout;
+			break;
+
+		case EB_Gone:
+			OneWireSim_Detach(&OneWireSimBus, sensor);
+			ExpectedRetries = ENGINEBENCH_RETRIES;
+			ExpectedState = OWT_Error;
+			ExpectedError = OW_NoPresence;
+			break;
+
+		case EB_NoRetry:
+			uart->WriteFailures = 1;
+			Policy = &NoRetry;
+			ExpectedState = OWT_Error;
+			ExpectedError = OW_Timeout;
+			break;
+
+		case EB_Fallback:
+			uart->WritesBefore = 0;
+			bus->Speed = OWS_Overdrive;
+			ExpectedRetries = 1;
+			break;
+
+		case EB_Blocking:
+			// With ONEWIRE_BURST each byte is a single write, 12 in all
+			uart->WritesBefore = EngineBench_Random() % (1 + 2 + 9);
+			uart->WriteFailures = 1;
+			Failed = (OW_Timeout != EngineBench_Blocking(bus, Scratchpad));
+
+			// Nothing is left behind for the next read
+			uart->WriteFailures = 0;
+
+			return Failed || EngineBench_Blocking(bus, Scratchpad) || OneWire_CalculateCRC(Scratchpad, sizeof(Scratchpad));
+
+		default:
+			break;
+	}
+
+	Failed = EngineBench_Transaction(bus, Policy, &Transaction, Scratchpad, &Polls) ||
+		(Transaction.State != ExpectedState) ||
+		(Transaction.Error != ExpectedError) ||
+		(bus->Stats.Retries != ExpectedRetries) ||
+		((OWT_Done == ExpectedState) && OneWire_CalculateCRC(Scratchpad, sizeof(Scratchpad)));
+
+	if(EB_Gone == test)
+	{
+		OneWireSim_Attach(&OneWireSimBus, sensor);
+	}
+
+	// A refused write fails straight away, not once the echo wait runs out
+	if(EB_NoRetry == test)
+	{
+		Failed = Failed || (Polls >= NoRetry.Timeout);
+	}
+
+	if(EB_Fallback == test)
+	{
+		Failed = Failed || (OWS_Standard != bus->Speed) || (1 != bus->Stats.SpeedFallbacks);
+	}
+
+	// Whatever happened the bus has to work straight after
+	uart->WriteFailures = 0;
+	uart->EchoFailures = 0;
+
+	return Failed || EngineBench_Transaction(bus, 0, &Transaction, Scratchpad, &Polls) || (OWT_Done != Transaction.State) ||
+		OneWire_CalculateCRC(Scratchpad, sizeof(Scratchpad));
+}
+
+int main(void)
+{
+	static const char * const Names[EB_Count] = {"clean", "refused", "refusedout", "lost", "lostout", "gone", "noretry", "fallback", "blocking"};
+	OneWireSimDeviceType Sensor;
+	EngineBenchUartType Uart;
+	OneWireBusType Bus;
+	uint32_t Errors = 0;
+	uint32_t CaseErrors;
+	uint32_t Round;
+	uint8_t Test;
+
+	OneWireSim_Init(&OneWireSimBus);
+	OneWireSim_DeviceInit(&Sensor, 0x28, 0x1234);
+	OneWireSim_SetTemperature(&Sensor, 21.5f);
+	OneWireSim_Attach(&OneWireSimBus, &Sensor);
+
+	OneWire_Init();
+
+	memset(&Uart, 0, sizeof(Uart));
+	Uart.Port = &UartDefaultPort;
+	OneWireBus_Init(&Bus, &EngineBenchOps, &Uart);
+
+	Bus.Policy.Timeout = 100;
+	Bus.Policy.Backoff = 4;
+	Bus.Policy.Retries = ENGINEBENCH_RETRIES;
+
+	for(Test = 0; Test < EB_Count; Test++)
+	{
+		CaseErrors = 0;
+
+		for(Round = 0; Round < ENGINEBENCH_ROUNDS; Round++)
+		{
+			CaseErrors += EngineBench_Run(&Bus, &Uart, &Sensor, (EngineBenchCaseEnum)Test);
+		}
+
+		printf("%-10s %4lu transactions  %4lu failed  %s\n", Names[Test], (unsigned long)ENGINEBENCH_ROUNDS, (unsigned long)CaseErrors, CaseErrors ? "FAIL" : "ok");
+		Errors += CaseErrors;
+	}
+
+	return Errors ? 1 : 0;
+}
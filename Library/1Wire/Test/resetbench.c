@@ -0,0 +1,181 @@
+/////////////////////////////////////////////////////////////////////////
+///	\file	resetbench.c
+///	\brief simulated bus benchmark for the baudrate cache and the break
+///	reset.
+///
+///	\section ResetBenchmark Reset benchmark
+///
+///	Reads a scratch pad (reset, skip ROM, read scratch pad, 9 bytes) over
+///	and over on the simulated bus in three ways:
+///
+///	- uncached: the cached baudrate is thrown away before every call, so
+///	  the UART is reprogrammed like it was before the cache
+///	- baud: the cache with the 9600 baud reset
+///	- break: the cache with the break reset, the baudrate never changes
+///
+///	For each it prints the UART baudrate changes, the bus time and the
+///	host time per scratch pad. The simulated UART changes baudrate for
+///	free, a real one has to wait for the line to go idle and often has to
+///	be disabled. RESETBENCH_SWITCH_US is added per change to show that.
+///
+///	\code
+///	cd Library/1Wire/Test
+///	gcc -std=c99 -O2 -DONEWIRE_SIMULATION -I.. resetbench.c ../onewire.c ../uart.c ../onewiresim.c ../cyclecounter.c -o resetbench && ./resetbench
+///	\endcode
+///
+///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
+///	Website: www.HashDefineElectronics.com
+///
+///	Licences:
+///
+///		Copyright (c) 2014 Ronald Alexander Nobrega De Sousa
+///
+///		Permission is hereby granted, free of charge, to any person obtaining a copy
+///		of this software and associated documentation files (the "Software"), to deal
+///		in the Software without restriction, including without limitation the rights
+///		to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+///		copies of the Software, and to permit persons to whom the Software is
+///		furnished to do so, subject to the following conditions:
+///
+///		The above copyright notice and this permission notice shall be included in
+///		all copies or substantial portions of the Software.
+///
+///		THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///		IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///		FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///		AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///		LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///		THE SOFTWARE.
+/////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdint.h>
+#include "common.h"
+#include "onewire.h"
+#include "onewiresim.h"
+#include "cyclecounter.h"
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Scratch pads read in each mode
+/////////////////////////////////////////////////////////////////////////
+#define RESETBENCH_ROUNDS 2000UL
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Time a real UART might take to change baudrate in us. Only
+///	used for the estimate column.
+/////////////////////////////////////////////////////////////////////////
+#ifndef RESETBENCH_SWITCH_US
+	#define RESETBENCH_SWITCH_US 100
+#endif
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Forget the cached baudrate when the uncached mode is run
+/////////////////////////////////////////////////////////////////////////
+static void ResetBench_Forget(OneWireBusType *bus, uint_fast8_t uncached)
+{
+	if(uncached)
+	{
+		bus->Baud = 0;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read the scratch pad of the only device on the bus
+///
+///	\return FALSE on success else TRUE
+/////////////////////////////////////////////////////////////////////////
+static uint_fast8_t ResetBench_Read(OneWireBusType *bus, uint_fast8_t uncached)
+{
+	uint8_t Scratchpad[9];
+
+	ResetBench_Forget(bus, uncached);
+
+	if(OneWireBus_Reset(bus))
+	{
+		return TRUE;
+	}
+
+	ResetBench_Forget(bus, uncached);
+
+	if(OneWireBus_Write(bus, 0xCC))
+	{
+		return TRUE;
+	}
+
+	ResetBench_Forget(bus, uncached);
+
+	if(OneWireBus_Write(bus, 0xBE))
+	{
+		return TRUE;
+	}
+
+	ResetBench_Forget(bus, uncached);
+
+	if(OneWireBus_ReadBlock(bus, Scratchpad, sizeof(Scratchpad)))
+	{
+		return TRUE;
+	}
+
+	return (OneWire_CalculateCRC(Scratchpad, sizeof(Scratchpad)) != 0);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Run one mode and print the results
+///
+///	\return the number of failed reads
+/////////////////////////////////////////////////////////////////////////
+static uint32_t ResetBench_Run(const char *name, uint8_t resetMode, uint_fast8_t uncached)
+{
+	OneWireBusType *Bus = &OneWireDefaultBus;
+	uint32_t Round;
+	uint32_t Errors = 0;
+	uint32_t Changes = OneWireSimBus.BaudChanges;
+	uint64_t BusNs = OneWireSimBus.TimeNs;
+	uint32_t Start;
+	uint32_t Elapsed;
+	double Switches;
+
+	Bus->ResetMode = resetMode;
+
+	Start = CycleCounter_Read();
+
+	for(Round = 0; Round < RESETBENCH_ROUNDS; Round++)
+	{
+		Errors += ResetBench_Read(Bus, uncached);
+	}
+
+	Elapsed = CycleCounter_Read() - Start;
+
+	Switches = (double)(OneWireSimBus.BaudChanges - Changes) / RESETBENCH_ROUNDS;
+
+	printf("%-9s %5.2f baud changes  %8.1fus bus  %8.1fus with %uus per change  %7.0f host counts  %s\n",
+		name,
+		Switches,
+		(double)(OneWireSimBus.TimeNs - BusNs) / 1000.0 / RESETBENCH_ROUNDS,
+		(double)(OneWireSimBus.TimeNs - BusNs) / 1000.0 / RESETBENCH_ROUNDS + Switches * RESETBENCH_SWITCH_US,
+		(unsigned)RESETBENCH_SWITCH_US,
+		(double)Elapsed / RESETBENCH_ROUNDS,
+		Errors ? "FAIL" : "ok");
+
+	return Errors;
+}
+
+int main(void)
+{
+	OneWireSimDeviceType Sensor;
+	uint32_t Errors = 0;
+
+	OneWireSim_Init(&OneWireSimBus);
+	OneWireSim_DeviceInit(&Sensor, 0x28, 0x1234);
+	OneWireSim_SetTemperature(&Sensor, 21.5f);
+	OneWireSim_Attach(&OneWireSimBus, &Sensor);
+
+	CycleCounter_Init();
+	OneWire_Init();
+
+	Errors += ResetBench_Run("uncached", OWR_Baud, TRUE);
+	Errors += ResetBench_Run("baud", OWR_Baud, FALSE);
+	Errors += ResetBench_Run("break", OWR_Break, FALSE);
+
+	return Errors ? 1 : 0;
+}
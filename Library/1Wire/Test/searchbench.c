@@ -0,0 +1,333 @@
+/////////////////////////////////////////////////////////////////////////
+///	\file	searchbench.c
+///	\brief simulated bus check of the ROM search and the device check.
+///
+///	\section SearchBenchmark Search check
+///
+///	Puts a random set of devices on the simulated bus, some of them
+///	alarming, and runs OneWireBus_Verify() on each of them and on one
+///	that isn't attached:
+///
+///	- verify: with search ROM every attached device must be found and
+///	  the spare one not
+///	- alarm verify: with alarm search only the alarming ones must be found
+///
+///	For every device found the branches must be exactly the bits where
+///	another device taking part in the search leaves its path.
+///
+///	Then the whole bus is searched twice with OneWireBus_SearchRom():
+///
+///	- search: every attached device is found once
+///	- alarm search: every alarming device is found once, none when
+///	  nothing alarms
+///
+///	Half the devices are a one bit change of another one so the paths
+///	often split deep in the ROM code.
+///
+///	\code
+///	cd Library/1Wire/Test
+///	gcc -std=c99 -O2 -DONEWIRE_SIMULATION -I.. searchbench.c ../onewire.c ../uart.c ../onewiresim.c ../cyclecounter.c -o searchbench && ./searchbench
+///	\endcode
+///
+///
+///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
+///	Website: www.HashDefineElectronics.com
+///
+///	Licences:
+///
+///		Copyright (c) 2014 Ronald Alexander Nobrega De Sousa
+///
+///		Permission is hereby granted, free of charge, to any person obtaining a copy
+///		of this software and associated documentation files (the "Software"), to deal
+///		in the Software without restriction, including without limitation the rights
+///		to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+///		copies of the Software, and to permit persons to whom the Software is
+///		furnished to do so, subject to the following conditions:
+///
+///		The above copyright notice and this permission notice shall be included in
+///		all copies or substantial portions of the Software.
+///
+///		THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///		IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///		FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///		AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///		LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///		THE SOFTWARE.
+/////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "common.h"
+#include "onewire.h"
+#include "onewiresim.h"
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Random buses tried
+/////////////////////////////////////////////////////////////////////////
+#define SEARCHBENCH_ROUNDS 500UL
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Most devices on a bus
+/////////////////////////////////////////////////////////////////////////
+#define SEARCHBENCH_DEVICES 8
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Search ROM and alarm search ROM commands
+/////////////////////////////////////////////////////////////////////////
+#define SEARCHBENCH_SEARCH 0xF0
+#define SEARCHBENCH_ALARM 0xEC
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	xorshift state, fixed seed so a failure can be repeated
+/////////////////////////////////////////////////////////////////////////
+static uint32_t SearchBenchSeed = 0x2545F491UL;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Random number
+/////////////////////////////////////////////////////////////////////////
+static uint32_t SearchBench_Random(void)
+{
+	SearchBenchSeed ^= SearchBenchSeed << 13;
+	SearchBenchSeed ^= SearchBenchSeed >> 17;
+	SearchBenchSeed ^= SearchBenchSeed << 5;
+
+	return SearchBenchSeed;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	One bit of a ROM code, 0 for the LSB of the family code
+/////////////////////////////////////////////////////////////////////////
+static uint8_t SearchBench_Bit(const OneWireRomType *rom, uint8_t bit)
+{
+	return (rom->Code[bit >> 3] >> (bit & 0x07)) & 0x01;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Set up random devices. Half of them are a one bit change of
+///	an earlier one so their search paths split deep in the ROM code, the
+///	rest share the family code.
+/////////////////////////////////////////////////////////////////////////
+static void SearchBench_Devices(OneWireSimDeviceType *devices, uint8_t count)
+{
+	const OneWireSimDeviceType *Other;
+	uint32_t Serial;
+	uint8_t Index;
+
+	for(Index = 0; Index < count; Index++)
+	{
+		Serial = SearchBench_Random();
+
+		if(Index && (SearchBench_Random() & 1))
+		{
+			Other = &devices[SearchBench_Random() % Index];
+			Serial = ((uint32_t)Other->Rom.Code[4] << 24) | ((uint32_t)Other->Rom.Code[3] << 16) | ((uint32_t)Other->Rom.Code[2] << 8) | Other->Rom.Code[1];
+			Serial ^= 1UL << (SearchBench_Random() % 32);
+		}
+
+		OneWireSim_DeviceInit(&devices[Index], 0x28, Serial);
+
+		// Two with the same ROM code are one device to the search
+		for(Other = devices; Other < &devices[Index]; Other++)
+		{
+			if(!memcmp(&Other->Rom, &devices[Index].Rom, sizeof(OneWireRomType)))
+			{
+				Index--;
+				break;
+			}
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Work out the branches on the path of a device from the ROM
+///	codes of the devices that take part in the search
+///
+///	\param devices the devices on the bus
+///	\param count how many
+///	\param alarm TRUE if only the alarming devices take part
+///	\param rom the path
+///	\param branches where to store the branches
+/////////////////////////////////////////////////////////////////////////
+static void SearchBench_Branches(const OneWireSimDeviceType *devices, uint8_t count, uint_fast8_t alarm, const OneWireRomType *rom, OneWireRomType *branches)
+{
+	uint8_t Index;
+	uint8_t Bit;
+
+	memset(branches, 0, sizeof(OneWireRomType));
+
+	for(Index = 0; Index < count; Index++)
+	{
+		if(alarm && !devices[Index].Alarm)
+		{
+			continue;
+		}
+
+		// The first bit that differs is where this one leaves the path
+		for(Bit = 0; (Bit < (ONEWIRE_ROM_LENGTH * 8)) && (SearchBench_Bit(&devices[Index].Rom, Bit) == SearchBench_Bit(rom, Bit)); Bit++)
+		{
+		}
+
+		if(Bit < (ONEWIRE_ROM_LENGTH * 8))
+		{
+			branches->Code[Bit >> 3] |= (uint8_t)(1 << (Bit & 0x07));
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Check OneWireBus_Verify() on every device and on one that
+///	isn't on the bus
+///
+///	\return the number of wrong answers
+/////////////////////////////////////////////////////////////////////////
+static uint32_t SearchBench_Verify(OneWireSimDeviceType *devices, uint8_t count, uint_fast8_t alarm)
+{
+	OneWireBusType *Bus = &OneWireDefaultBus;
+	OneWireRomType Branches;
+	OneWireRomType Expected;
+	uint32_t Errors = 0;
+	uint8_t Present;
+	uint8_t Index;
+
+	// The spare device after the attached ones is never found
+	for(Index = 0; Index <= count; Index++)
+	{
+		Present = (Index < count) && (!alarm || devices[Index].Alarm);
+
+		memset(&Branches, 0xA5, sizeof(Branches));
+
+		if(OneWireBus_Verify(Bus, &devices[Index].Rom, alarm ? SEARCHBENCH_ALARM : SEARCHBENCH_SEARCH, &Branches) == Present)
+		{
+			Errors++;
+			continue;
+		}
+
+		if(Present)
+		{
+			SearchBench_Branches(devices, count, alarm, &devices[Index].Rom, &Expected);
+
+			if(memcmp(&Branches, &Expected, sizeof(OneWireRomType)))
+			{
+				Errors++;
+			}
+		}
+	}
+
+	return Errors;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Search the bus twice with OneWireBus_SearchRom(), the second
+///	time with the search state the first left behind. Each time exactly
+///	the devices that take part must be found.
+///
+///	\return the number of wrong searches
+/////////////////////////////////////////////////////////////////////////
+static uint32_t SearchBench_Search(const OneWireSimDeviceType *devices, uint8_t count, uint_fast8_t alarm)
+{
+	OneWireRomType Table[SEARCHBENCH_DEVICES + 1];
+	OneWireSearchType Search;
+	uint32_t Errors = 0;
+	uint8_t Expected = 0;
+	uint8_t Found;
+	uint8_t Scan;
+	uint8_t Index;
+	uint8_t Other;
+
+	for(Index = 0; Index < count; Index++)
+	{
+		Expected += (!alarm || devices[Index].Alarm);
+	}
+
+	OneWire_SearchInit(&Search, alarm ? SEARCHBENCH_ALARM : SEARCHBENCH_SEARCH);
+
+	for(Scan = 0; Scan < 2; Scan++)
+	{
+		Found = OneWireBus_SearchRom(&OneWireDefaultBus, &Search, Table, SEARCHBENCH_DEVICES + 1);
+
+		if(Found != Expected)
+		{
+			Errors++;
+			continue;
+		}
+
+		// Every one found is a device taking part, and none twice
+		for(Index = 0; Index < Found; Index++)
+		{
+			for(Other = 0; Other < count; Other++)
+			{
+				if((!alarm || devices[Other].Alarm) && !memcmp(&Table[Index], &devices[Other].Rom, sizeof(OneWireRomType)))
+				{
+					break;
+				}
+			}
+
+			if(Other == count)
+			{
+				Errors++;
+				break;
+			}
+
+			for(Other = 0; (Other < Index) && memcmp(&Table[Index], &Table[Other], sizeof(OneWireRomType)); Other++)
+			{
+			}
+
+			if(Other != Index)
+			{
+				Errors++;
+				break;
+			}
+		}
+	}
+
+	return Errors;
+}
+
+int main(void)
+{
+	OneWireSimDeviceType Devices[SEARCHBENCH_DEVICES + 1];
+	uint32_t Errors = 0;
+	uint32_t AlarmErrors = 0;
+	uint32_t SearchErrors = 0;
+	uint32_t AlarmSearchErrors = 0;
+	uint32_t Checks = 0;
+	uint32_t Round;
+	uint8_t Count;
+	uint8_t Index;
+
+	OneWireSim_Init(&OneWireSimBus);
+	OneWire_Init();
+
+	for(Round = 0; Round < SEARCHBENCH_ROUNDS; Round++)
+	{
+		while(OneWireSimBus.Devices)
+		{
+			OneWireSim_Detach(&OneWireSimBus, OneWireSimBus.Devices);
+		}
+
+		Count = 1 + (uint8_t)(SearchBench_Random() % SEARCHBENCH_DEVICES);
+
+		SearchBench_Devices(Devices, Count + 1);
+
+		for(Index = 0; Index < Count; Index++)
+		{
+			Devices[Index].Alarm = (uint8_t)(SearchBench_Random() & 1);
+			OneWireSim_Attach(&OneWireSimBus, &Devices[Index]);
+		}
+
+		Errors += SearchBench_Verify(Devices, Count, FALSE);
+		AlarmErrors += SearchBench_Verify(Devices, Count, TRUE);
+		Checks += Count + 1;
+
+		SearchErrors += SearchBench_Search(Devices, Count, FALSE);
+		AlarmSearchErrors += SearchBench_Search(Devices, Count, TRUE);
+	}
+
+	printf("verify        %5lu devices  %4lu wrong  %s\n", (unsigned long)Checks, (unsigned long)Errors, Errors ? "FAIL" : "ok");
+	printf("alarm verify  %5lu devices  %4lu wrong  %s\n", (unsigned long)Checks, (unsigned long)AlarmErrors, AlarmErrors ? "FAIL" : "ok");
+	printf("search        %5lu buses    %4lu wrong  %s\n", (unsigned long)SEARCHBENCH_ROUNDS * 2, (unsigned long)SearchErrors, SearchErrors ? "FAIL" : "ok");
+	printf("alarm search  %5lu buses    %4lu wrong  %s\n", (unsigned long)SEARCHBENCH_ROUNDS * 2, (unsigned long)AlarmSearchErrors, AlarmSearchErrors ? "FAIL" : "ok");
+
+	return (Errors || AlarmErrors || SearchErrors || AlarmSearchErrors) ? 1 : 0;
+}
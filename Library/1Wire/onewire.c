@@ -33,11 +33,16 @@
 #include <stdint.h>
 #include "common.h"
 #include "uart.h"
-
-/////////////////////////////////////////////////////////////////////////
-///	\brief	This is the data used to reset the 1 wire node
-/////////////////////////////////////////////////////////////////////////
-static const uint_fast8_t ResetData = 0xF0;
+#include "onewire.h"
+#if ONEWIRE_STATS
+	#include "cyclecounter.h"
+	
+	#define ONEWIRE_STATS_TIME(start) uint32_t start = CycleCounter_Read()
+	#define ONEWIRE_STATS_LATENCY(bus, histogram, start) OneWire_StatsLatency((bus)->Stats.histogram, start)
+#else
+	#define ONEWIRE_STATS_TIME(start)
+	#define ONEWIRE_STATS_LATENCY(bus, histogram, start) ((void)0)
+#endif
 
 /////////////////////////////////////////////////////////////////////////
 ///	\brief	Define the true state
@@ -52,12 +57,19 @@ static const uint_fast8_t OneWireFalse = 0X00;
 /////////////////////////////////////////////////////////////////////////
 ///	\brief	Baudrate for 9600
 /////////////////////////////////////////////////////////////////////////
-static const uint_fast16_t Baudrate9600 = 9600;
+static const uint32_t Baudrate9600 = 9600;
 
 /////////////////////////////////////////////////////////////////////////
-///	\brief	Baudrate for 115200
+///	\brief	Overdrive skip ROM command. Puts every overdrive capable 
+///	device in overdrive
 /////////////////////////////////////////////////////////////////////////
-static const uint_fast16_t Baudrate115200 = 115200;
+static const uint8_t OverdriveSkipRom = 0x3C;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Overdrive match ROM command. The ROM code that follows is 
+///	sent at overdrive speed
+/////////////////////////////////////////////////////////////////////////
+static const uint8_t OverdriveMatchRom = 0x69;
 
 /////////////////////////////////////////////////////////////////////////
 ///	\brief	Defines how many bytes in the bit state
@@ -70,160 +82,1809 @@ static const uint_fast8_t OneWireBitLength = 0x08;
 static const uint_fast8_t OneWireBitMask = 0x01;
 
 /////////////////////////////////////////////////////////////////////////
-///	\brief	Read one byte from device
+///	\brief	Standard speed resets with 0xF0 at 9600 baud and sends its
+///	slots at 115200 baud. See ONEWIRE_OVERDRIVE_BAUD for overdrive. A
+///	busy poll is a byte of slots so it gets shorter with the slot baud.
+/////////////////////////////////////////////////////////////////////////
+const OneWireTimingType OneWireTiming[OWS_Count] =
+{
+	{9600, 115200, 0xF0, 1},
+	{ONEWIRE_OVERDRIVE_RESET_BAUD, ONEWIRE_OVERDRIVE_BAUD, 0xF8, (ONEWIRE_OVERDRIVE_BAUD + 115200UL - 1) / 115200UL}
+};
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	The bus behind the OneWire_* calls
+/////////////////////////////////////////////////////////////////////////
+OneWireBusType OneWireDefaultBus;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	UartPort_* adapters for OneWireUartPortOps
+/////////////////////////////////////////////////////////////////////////
+static uint_fast8_t OneWire_PortSetbaud(void *context, uint32_t baud)
+{
+	return UartPort_Setbaud((UartPortType *)context, baud);
+}
+
+static uint_fast8_t OneWire_PortWrite(void *context, const uint8_t *source, uint_fast8_t length)
+{
+	return UartPort_Write((UartPortType *)context, source, length);
+}
+
+static uint_fast8_t OneWire_PortRead(void *context, uint8_t *destination, uint_fast8_t length)
+{
+	return UartPort_Read((UartPortType *)context, destination, length);
+}
+
+static uint_fast8_t OneWire_PortWriteSpace(void *context)
+{
+	return UartPort_WriteSpace((UartPortType *)context);
+}
+
+static uint_fast8_t OneWire_PortBreak(void *context, uint32_t low, uint32_t idle)
+{
+	return UartPort_Break((UartPortType *)context, low, idle);
+}
+
+static uint_fast8_t OneWire_PortWriteComplete(void *context)
+{
+	return UartPort_WriteComplete((UartPortType *)context);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	UART operations for the uart.c ports. The context is the
+///	UartPortType.
+/////////////////////////////////////////////////////////////////////////
+const OneWireUartOpsType OneWireUartPortOps =
+{
+	OneWire_PortSetbaud,
+	OneWire_PortWrite,
+	OneWire_PortRead,
+	OneWire_PortWriteSpace,
+	OneWire_PortBreak,
+	OneWire_PortWriteComplete
+};
+
+#if ONEWIRE_STATS
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Add a time to a latency histogram
 ///
-///	\param data pointer to return the read byte
-///	\return false on success else true
+///	\param histogram the ONEWIRE_STATS_BINS bins
+///	\param start CycleCounter_Read() when the operation started
 /////////////////////////////////////////////////////////////////////////
-int_fast8_t OneWire_Read(uint8_t *data)
+static void OneWire_StatsLatency(uint32_t *histogram, uint32_t start)
 {
-    uint8_t Index = OneWireBitLength;
-    uint8_t ReturnValue = 0;
-    uint8_t Temp;
-    
-		Uart_Setbaud(Baudrate115200);
-	
-    while(Index)
-    {
-        //write a true
-        Uart_WriteByte(OneWireTrue);
-
-        //Dummy Read
-        if(Uart_ReadByte(&Temp))
-        {
-					// Error while waiting for data to be received
-					return TRUE;
-				}
+	uint32_t Elapsed = CycleCounter_Read() - start;
+	uint_fast8_t Bin = 0;
+	
+	while((Elapsed >>= 1) && (Bin < (ONEWIRE_STATS_BINS - 1)))
+	{
+		Bin++;
+	}
+	
+	histogram[Bin]++;
+}
+#endif
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Change the bus baudrate. Reprogramming the UART usually means
+///	waiting for the line to go idle, so it's only done when the baudrate
+///	really changes.
+///
+///	\param bus the bus
+///	\param baud the desire baudrate
+///	\return OW_Success or OW_Timeout if the transmit buffer never drained
+/////////////////////////////////////////////////////////////////////////
+static int_fast8_t OneWire_Setbaud(OneWireBusType *bus, uint32_t baud)
+{
+	if(bus->Baud == baud)
+	{
+		return OW_Success;
+	}
+	
+	if(bus->Uart->Setbaud(bus->UartContext, baud))
+	{
+		ONEWIRE_STATS_ADD(bus, Timeouts, 1);
+		return OW_Timeout;
+	}
+	
+	bus->Baud = baud;
+	ONEWIRE_STATS_ADD(bus, BaudSwitches, 1);
+	
+	return OW_Success;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Wait for room in the UART transmit buffer
+///
+///	\param bus the bus
+///	\param count how many bytes need to fit
+///	\return OW_Success or OW_Timeout
+/////////////////////////////////////////////////////////////////////////
+static int_fast8_t OneWire_WaitSpace(OneWireBusType *bus, uint_fast8_t count)
+{
+	uint32_t Timeout = bus->Policy.Timeout;
+	
+	while(bus->Uart->WriteSpace(bus->UartContext) < count)
+	{
+		if(!Timeout)
+		{
+			ONEWIRE_STATS_ADD(bus, Timeouts, 1);
+			return OW_Timeout;
+		}
 		
-        ReturnValue = ReturnValue >> 1; //ShiftData
-				
-        if( Temp == OneWireTrue)
-        {
-            ReturnValue += 0x80;
-        }
+		Timeout--;
+	}
+	
+	return OW_Success;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Throw away the echoes left behind by a failed transfer. The
+///	slots still in the UART are let out first, otherwise their echoes
+///	arrive after the flush and are taken for the echo of the next slot.
+///
+///	\param bus the bus
+///	\return OW_Success or OW_Timeout if the UART never finished sending
+/////////////////////////////////////////////////////////////////////////
+static int_fast8_t OneWire_Flush(OneWireBusType *bus)
+{
+	uint32_t Timeout = bus->Policy.Timeout;
+	uint8_t Data;
+	
+	while(!bus->Uart->WriteComplete(bus->UartContext))
+	{
+		if(!Timeout)
+		{
+			ONEWIRE_STATS_ADD(bus, Timeouts, 1);
+			return OW_Timeout;
+		}
 		
-        //Count Away
-        Index--;
-    }
+		Timeout--;
+	}
+	
+	while(bus->Uart->Read(bus->UartContext, &Data, 1)) ;
+	
+	return OW_Success;
+}
 
-    *data = ReturnValue;
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Queue a single slot. Waits for space in the UART buffer.
+///
+///	\param bus the bus
+///	\param slot the UART character that makes the slot
+///	\return OW_Success or OW_Timeout
+/////////////////////////////////////////////////////////////////////////
+static int_fast8_t OneWire_WriteSlot(OneWireBusType *bus, const uint8_t slot)
+{
+	if(OneWire_WaitSpace(bus, 1))
+	{
+		return OW_Timeout;
+	}
 	
-    return FALSE;
+	if(bus->Uart->Write(bus->UartContext, &slot, 1))
+	{
+		ONEWIRE_STATS_ADD(bus, Timeouts, 1);
+		return OW_Timeout;
+	}
+	
+	return OW_Success;
 }
 
 /////////////////////////////////////////////////////////////////////////
-///	\brief	Writes one byte
+///	\brief	Wait for the echo of a slot. Gives up once the policy
+///	timeout runs out.
 ///
-/// \param source byte to write
+///	\param bus the bus
+///	\param destination pointer to return the echo
+///	\return OW_Success or OW_Timeout
 /////////////////////////////////////////////////////////////////////////
-int_fast8_t OneWire_Write(const uint8_t source)
+static int_fast8_t OneWire_ReadEcho(OneWireBusType *bus, uint8_t *destination)
 {
-	uint8_t Index = OneWireBitLength;
-	uint8_t Temp = source;
-	uint8_t Dummy = 0;
+	uint32_t Timeout = bus->Policy.Timeout;
 	
-	Uart_Setbaud(Baudrate115200);
+	while(!bus->Uart->Read(bus->UartContext, destination, 1))
+	{
+		if(!Timeout)
+		{
+			ONEWIRE_STATS_ADD(bus, Timeouts, 1);
+			return OW_Timeout; // Nothing arrived
+		}
+		
+		Timeout--;
+	}
 	
-    while(Index) // Read one byte
-    {
-				//Wait here until there space to send the next bit of data
-				while(!Uart_WriteBusy()) ;
-			
-        if(Temp & OneWireBitMask)
-        {
-            //write a true
-            Uart_WriteByte(OneWireTrue);
-        }
-        else
-        {
-            //write a false
-            Uart_WriteByte(OneWireFalse);
-        }
-        
-        //Dummy Read
-        if(Uart_ReadByte(&Dummy))
-        {
-					// Error no data was received
-					return TRUE;
-				}
+	return OW_Success;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Break length for a reset pulse in us
+/////////////////////////////////////////////////////////////////////////
+static const uint32_t ResetBreakUs = 480;
 
-        Temp = Temp >> 1; //Shift over to next byte
-        Index--; //decrement count
-    }
-    
-    return FALSE;    
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Idle time in us still needed after the presence read slot so
+///	the reset high time is 480us
+/////////////////////////////////////////////////////////////////////////
+static const uint32_t ResetRecoveryUs = 400;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Get the timing profile of the bus speed
+/////////////////////////////////////////////////////////////////////////
+static const OneWireTimingType *OneWire_Timing(const OneWireBusType *bus)
+{
+	return &OneWireTiming[bus->Speed];
 }
 
 /////////////////////////////////////////////////////////////////////////
-///	\brief	Reset the connected 1 wire device
+///	\brief	Check if the reset is made with a break. That is only a
+///	standard speed reset so overdrive always uses the baudrate.
 /////////////////////////////////////////////////////////////////////////
-uint8_t OneWire_Reset(void)
+static uint_fast8_t OneWire_BreakReset(const OneWireBusType *bus)
 {
-	uint8_t Data = 0;
-	Uart_Setbaud(Baudrate9600);
+	return (OWR_Break == bus->ResetMode) && bus->Uart->Break && (OWS_Standard == bus->Speed);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Put the reset pulse on the bus. The echo tells if there was a
+///	presence pulse, see OneWire_ResetDone().
+///
+///	\param bus the bus
+///	\param useBreak TRUE to make the reset with a break, see 
+///		OneWire_BreakReset(). The break holds the line for the whole reset
+///		so only the blocking calls use it.
+///	\return OW_Success or OW_Timeout
+/////////////////////////////////////////////////////////////////////////
+static int_fast8_t OneWire_SendReset(OneWireBusType *bus, uint_fast8_t useBreak)
+{
+	const OneWireTimingType *Timing = OneWire_Timing(bus);
+	uint8_t Data = Timing->ResetData;
 	
-	Uart_WriteByte(ResetData); //Send the reset command
+	// Counted even if it fails, a reset that may have reached the devices
+	// has to count as bus use
+	bus->ResetCount++;
 	
-	//wait for data to be received
-	if(Uart_ReadByte(&Data))
+	if(useBreak)
 	{
-		return TRUE; // Error while waiting for data to be received
+		// The read slot straight after the break overlaps the presence pulse
+		if(OneWire_Setbaud(bus, Timing->SlotBaud) || bus->Uart->Break(bus->UartContext, ResetBreakUs, 0))
+		{
+			return OW_Timeout;
+		}
+		
+		Data = OneWireTrue;
+	}
+	else if(OneWire_Setbaud(bus, Timing->ResetBaud))
+	{
+		return OW_Timeout;
 	}
 	
-	// check if device is in the network
-	if(Data == ResetData)
+	if(OneWire_WriteSlot(bus, Data))
 	{
-		return TRUE; //Error device not found
+		return OW_Timeout;
 	}
 	
-	return FALSE; // Device is available
+	ONEWIRE_STATS_ADD(bus, Resets, 1);
+	
+	return OW_Success;
 }
 
 /////////////////////////////////////////////////////////////////////////
-///	\brief	initialize one wire interface
+///	\brief	Finish a reset once its echo is back. The echo only comes 
+///	back unchanged when no device pulled the bus low. After a break the 
+///	rest of the reset high time is waited out before any slot is sent.
+///	When nothing answers an overdrive reset the bus drops back to 
+///	standard speed, the standard reset that follows takes every device
+///	back to standard speed too.
+///
+///	\param bus the bus
+///	\param echo the echo of the character sent by OneWire_SendReset()
+///	\param useBreak the same as given to OneWire_SendReset()
+///	\return OW_Success, OW_NoPresence or OW_Timeout
 /////////////////////////////////////////////////////////////////////////
-void OneWire_Init(void)
+static int_fast8_t OneWire_ResetDone(OneWireBusType *bus, uint8_t echo, uint_fast8_t useBreak)
 {
-	Uart_Init(Baudrate9600);
-	OneWire_Reset();
+	if(useBreak)
+	{
+		if(bus->Uart->Break(bus->UartContext, 0, ResetRecoveryUs))
+		{
+			return OW_Timeout;
+		}
+		
+		if(echo == OneWireTrue)
+		{
+			ONEWIRE_STATS_ADD(bus, PresenceFailures, 1);
+			return OW_NoPresence;
+		}
+	}
+	else if(echo == OneWire_Timing(bus)->ResetData)
+	{
+		ONEWIRE_STATS_ADD(bus, PresenceFailures, 1);
+		
+		if(OWS_Standard != bus->Speed)
+		{
+			ONEWIRE_STATS_ADD(bus, SpeedFallbacks, 1);
+			bus->Speed = OWS_Standard;
+		}
+		
+		return OW_NoPresence;
+	}
+	
+	return OW_Success;
 }
 
 /////////////////////////////////////////////////////////////////////////
-///	\brief	Calculates 1-wire CRC with the from the given array.
-/// 	If source array contains the CRC then expect the calculated CRC 
-///		to be zero.
-///
-///	\param source pointer to the byte array
-///	\param length how many byte to process
+///	\brief	Send the slots for the low bits of source and collect the 
+///	echo. A one bit generates a read slot.
 ///
-///	\return returned the calculated CRC
+///	\param bus the bus
+///	\param source bits to write. LSB goes first
+///	\param count how many bits to transfer, 1 to 8
+///	\param destination pointer to return the bits read back from the bus
+///	\return OW_Success or OW_Timeout
+/////////////////////////////////////////////////////////////////////////
+static int_fast8_t OneWire_TransferBits(OneWireBusType *bus, const uint8_t source, uint8_t count, uint8_t *destination);
+
+#if ONEWIRE_BURST
+#if UART_BUFFER_SIZE < 8
+	#error ONEWIRE_BURST needs a UART buffer of at least 8 bytes
+#endif
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	How many bytes worth of slots can be in flight at once.
+///	Keeping it to the buffer size means the receive buffer can't overflow.
+/////////////////////////////////////////////////////////////////////////
+static const uint_fast8_t OneWireBurstDepth = UART_BUFFER_SIZE / 8;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Queue the slots of up to one byte in a single burst. Waits
+///	for enough room in the UART buffer.
 ///
-///	\note the original source was made 
-///		by clawson @ http://www.avrfreaks.net/index.php?name=PNphpBB2&file=printview&t=85318
+///	\param bus the bus
+///	\param source bits to write. 0xFF generates eight read slots
+///	\param count how many bits to queue, 1 to 8
+///	\return OW_Success or OW_Timeout
 /////////////////////////////////////////////////////////////////////////
-uint8_t OneWire_CalculateCRC(uint8_t * source, uint8_t length) 
-{ 
-	uint8_t BitIndex;
-	uint8_t CRC = 0;
+static int_fast8_t OneWire_QueueBits(OneWireBusType *bus, const uint8_t source, uint8_t count)
+{
+	uint8_t Slots[8]; // one slot per bit
+	uint8_t Index;
+	uint8_t Temp = source;
+	
+	// Build the slot for each bit. LSB goes first
+	for(Index = 0; Index < count; Index++)
+	{
+		Slots[Index] = (Temp & OneWireBitMask) ? OneWireTrue : OneWireFalse;
+		Temp = Temp >> 1;
+	}
+	
+	// Wait here until there is space to queue all the slots
+	if(OneWire_WaitSpace(bus, count))
+	{
+		return OW_Timeout;
+	}
+	
+	if(bus->Uart->Write(bus->UartContext, &Slots[0], count))
+	{
+		ONEWIRE_STATS_ADD(bus, Timeouts, 1);
+		return OW_Timeout;
+	}
+	
+	ONEWIRE_STATS_ADD(bus, Slots, count);
+	
+	return OW_Success;
+}
 
-	while(length)
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Collect the echoes of the queued slots
+///
+///	\param bus the bus
+///	\param destination pointer to return the bits read back from the bus
+///	\param count how many echoes to collect, 1 to 8
+///	\return OW_Success or OW_Timeout
+/////////////////////////////////////////////////////////////////////////
+static int_fast8_t OneWire_DecodeBits(OneWireBusType *bus, uint8_t *destination, uint8_t count)
+{
+	uint8_t Index;
+	uint8_t ReturnValue = 0;
+	uint8_t Echo;
+	
+	for(Index = 0; Index < count; Index++)
 	{
-		CRC = CRC ^ *source;
+		if(OneWire_ReadEcho(bus, &Echo))
+		{
+			// Error while waiting for data to be received
+			return OW_Timeout;
+		}
 		
-		for (BitIndex = 0; BitIndex < 8; BitIndex++) 
-		{ 
-			if (CRC & 0x01) 
-			{
-				CRC = (CRC >> 1) ^ 0x8C; 
-			}
-			else
+		ReturnValue = ReturnValue >> 1; //ShiftData
+		
+		if(Echo == OneWireTrue)
+		{
+			ReturnValue += 0x80;
+		}
+	}
+	
+	// Line up the first bit with bit 0
+	*destination = ReturnValue >> (OneWireBitLength - count);
+	
+	return OW_Success;
+}
+
+static int_fast8_t OneWire_TransferBits(OneWireBusType *bus, const uint8_t source, uint8_t count, uint8_t *destination)
+{
+	if(OneWire_QueueBits(bus, source, count))
+	{
+		return OW_Timeout;
+	}
+	
+	return OneWire_DecodeBits(bus, destination, count);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Stream a block of bytes. The slots of the next bytes are 
+///	queued before the echoes of the current byte are decoded so that
+///	the UART never runs dry between bytes.
+///
+///	\param bus the bus
+///	\param source bytes to write or NULL to generate read slots
+///	\param destination where to store the bytes read back or NULL
+///	\param length how many bytes to process
+///	\param crc running CRC to add the bytes read back to or NULL
+///	\return OW_Success or OW_Timeout
+/////////////////////////////////////////////////////////////////////////
+static int_fast8_t OneWire_TransferBlock(OneWireBusType *bus, const uint8_t *source, uint8_t *destination, uint8_t length, uint8_t *crc)
+{
+	uint8_t Queued = 0;
+	uint8_t Done = 0;
+	uint8_t Data;
+	
+	while(Done < length)
+	{
+		// Keep the transmit buffer topped up
+		while((Queued < length) && ((uint8_t)(Queued - Done) < OneWireBurstDepth))
+		{
+			if(OneWire_QueueBits(bus, source ? source[Queued] : OneWireTrue, OneWireBitLength))
 			{
-				CRC >>= 1; 
+				return OW_Timeout;
 			}
-		} 
+			
+			Queued++;
+		}
 		
-		source++;
-		length--;
+		if(OneWire_DecodeBits(bus, &Data, OneWireBitLength))
+		{
+			return OW_Timeout;
+		}
+		
+		if(destination)
+		{
+			destination[Done] = Data;
+		}
+		
+		// Runs while the slots of the next bytes are on the bus
+		if(crc)
+		{
+			*crc = OneWire_CRCUpdate(*crc, Data);
+		}
+		
+		ONEWIRE_STATS_ADD(bus, Bytes, 1);
+		Done++;
+	}
+	
+	return OW_Success;
+}
+#else
+static int_fast8_t OneWire_TransferBits(OneWireBusType *bus, const uint8_t source, uint8_t count, uint8_t *destination)
+{
+	uint8_t Index = count;
+	uint8_t Temp = source;
+	uint8_t ReturnValue = 0;
+	uint8_t Echo;
+	
+	while(Index)
+	{
+		//write a true or a false
+		if(OneWire_WriteSlot(bus, (Temp & OneWireBitMask) ? OneWireTrue : OneWireFalse))
+		{
+			return OW_Timeout;
+		}
+		
+		ONEWIRE_STATS_ADD(bus, Slots, 1);
+		
+		if(OneWire_ReadEcho(bus, &Echo))
+		{
+			// Error no data was received
+			return OW_Timeout;
+		}
+		
+		ReturnValue = ReturnValue >> 1; //ShiftData
+		
+		if(Echo == OneWireTrue)
+		{
+			ReturnValue += 0x80;
+		}
+		
+		Temp = Temp >> 1; //Shift over to next byte
+		Index--; //decrement count
+	}
+	
+	// Line up the first bit with bit 0
+	*destination = ReturnValue >> (OneWireBitLength - count);
+	
+	return OW_Success;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Process a block of bytes one slot at a time
+///
+///	\param bus the bus
+///	\param source bytes to write or NULL to generate read slots
+///	\param destination where to store the bytes read back or NULL
+///	\param length how many bytes to process
+///	\param crc running CRC to add the bytes read back to or NULL
+///	\return OW_Success or OW_Timeout
+/////////////////////////////////////////////////////////////////////////
+static int_fast8_t OneWire_TransferBlock(OneWireBusType *bus, const uint8_t *source, uint8_t *destination, uint8_t length, uint8_t *crc)
+{
+	uint8_t Index;
+	uint8_t Data;
+	
+	for(Index = 0; Index < length; Index++)
+	{
+		if(OneWire_TransferBits(bus, source ? source[Index] : OneWireTrue, OneWireBitLength, &Data))
+		{
+			return OW_Timeout;
+		}
+		
+		if(destination)
+		{
+			destination[Index] = Data;
+		}
+		
+		if(crc)
+		{
+			*crc = OneWire_CRCUpdate(*crc, Data);
+		}
+		
+		ONEWIRE_STATS_ADD(bus, Bytes, 1);
+	}
+	
+	return OW_Success;
+}
+#endif
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read one byte from device
+///
+///	\param bus the bus
+///	\param data pointer to return the read byte
+///	\return OW_Success or OW_Timeout
+/////////////////////////////////////////////////////////////////////////
+int_fast8_t OneWireBus_Read(OneWireBusType *bus, uint8_t *data)
+{
+	if(OneWire_Setbaud(bus, OneWire_Timing(bus)->SlotBaud))
+	{
+		return OW_Timeout;
+	}
+	
+	ONEWIRE_STATS_ADD(bus, Bytes, 1);
+	
+	return OneWire_TransferBits(bus, OneWireTrue, OneWireBitLength, data);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Writes one byte
+///
+///	\param bus the bus
+/// \param source byte to write
+///	\return OW_Success or OW_Timeout
+/////////////////////////////////////////////////////////////////////////
+int_fast8_t OneWireBus_Write(OneWireBusType *bus, const uint8_t source)
+{
+	uint8_t Dummy;
+	
+	if(OneWire_Setbaud(bus, OneWire_Timing(bus)->SlotBaud))
+	{
+		return OW_Timeout;
 	}
-	return CRC; 
+	
+	ONEWIRE_STATS_ADD(bus, Bytes, 1);
+	
+	return OneWire_TransferBits(bus, source, OneWireBitLength, &Dummy);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read a single bit from the device
+///
+///	\param bus the bus
+///	\param data pointer to return the bit. 0 or 1
+///	\return OW_Success or OW_Timeout
+/////////////////////////////////////////////////////////////////////////
+int_fast8_t OneWireBus_ReadBit(OneWireBusType *bus, uint8_t *data)
+{
+	if(OneWire_Setbaud(bus, OneWire_Timing(bus)->SlotBaud))
+	{
+		return OW_Timeout;
+	}
+	
+	return OneWire_TransferBits(bus, OneWireTrue, 1, data);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Writes a single bit
+///
+///	\param bus the bus
+///	\param source bit to write. 0 or 1
+///	\return OW_Success or OW_Timeout
+/////////////////////////////////////////////////////////////////////////
+int_fast8_t OneWireBus_WriteBit(OneWireBusType *bus, const uint8_t source)
+{
+	uint8_t Dummy;
+	
+	if(OneWire_Setbaud(bus, OneWire_Timing(bus)->SlotBaud))
+	{
+		return OW_Timeout;
+	}
+	
+	return OneWire_TransferBits(bus, source, 1, &Dummy);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read a block of bytes from the device straight in to the 
+///	caller buffer. The slots are streamed back to back.
+///
+///	\param bus the bus
+///	\param destination pointer to return the read bytes
+///	\param length how many bytes to read
+///	\return OW_Success or OW_Timeout
+/////////////////////////////////////////////////////////////////////////
+int_fast8_t OneWireBus_ReadBlock(OneWireBusType *bus, uint8_t *destination, uint8_t length)
+{
+	int_fast8_t Error = OW_Timeout;
+	ONEWIRE_STATS_TIME(Start);
+	
+	if(!OneWire_Setbaud(bus, OneWire_Timing(bus)->SlotBaud))
+	{
+		Error = OneWire_TransferBlock(bus, 0, destination, length, 0);
+	}
+	
+	ONEWIRE_STATS_LATENCY(bus, BlockLatency, Start);
+	
+	return Error;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Same as OneWireBus_ReadBlock() but each byte is added to a
+///	running CRC as it arrives, so the check is done by the time the last
+///	byte is in.
+///
+///	\param bus the bus
+///	\param destination pointer to return the read bytes
+///	\param length how many bytes to read
+///	\param crc the running CRC. Start it with OneWire_CRCInit()
+///	\return OW_Success or OW_Timeout
+/////////////////////////////////////////////////////////////////////////
+int_fast8_t OneWireBus_ReadBlockCRC(OneWireBusType *bus, uint8_t *destination, uint8_t length, uint8_t *crc)
+{
+	int_fast8_t Error = OW_Timeout;
+	ONEWIRE_STATS_TIME(Start);
+	
+	if(!OneWire_Setbaud(bus, OneWire_Timing(bus)->SlotBaud))
+	{
+		Error = OneWire_TransferBlock(bus, 0, destination, length, crc);
+	}
+	
+	ONEWIRE_STATS_LATENCY(bus, BlockLatency, Start);
+	
+	return Error;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Writes a block of bytes. The slots are streamed back to back.
+///
+///	\param bus the bus
+///	\param source pointer to the bytes to write
+///	\param length how many bytes to write
+///	\return OW_Success or OW_Timeout
+/////////////////////////////////////////////////////////////////////////
+int_fast8_t OneWireBus_WriteBlock(OneWireBusType *bus, const uint8_t *source, uint8_t length)
+{
+	int_fast8_t Error = OW_Timeout;
+	ONEWIRE_STATS_TIME(Start);
+	
+	if(!OneWire_Setbaud(bus, OneWire_Timing(bus)->SlotBaud))
+	{
+		Error = OneWire_TransferBlock(bus, source, 0, length, 0);
+	}
+	
+	ONEWIRE_STATS_LATENCY(bus, BlockLatency, Start);
+	
+	return Error;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Reset the connected 1 wire device
+///
+///	\param bus the bus
+///	\return OW_Success, OW_NoPresence or OW_Timeout
+/////////////////////////////////////////////////////////////////////////
+uint8_t OneWireBus_Reset(OneWireBusType *bus)
+{
+	uint8_t Data = 0;
+	uint8_t Speed = bus->Speed;
+	uint_fast8_t UseBreak = OneWire_BreakReset(bus);
+	int_fast8_t Result;
+	
+	// Throw away any echo left behind by a failed transfer
+	if(OneWire_Flush(bus) || OneWire_SendReset(bus, UseBreak)) //Send the reset command
+	{
+		return OW_Timeout;
+	}
+	
+	//wait for data to be received
+	if(OneWire_ReadEcho(bus, &Data))
+	{
+		return OW_Timeout; // Error while waiting for data to be received
+	}
+	
+	// check if device is in the network
+	Result = OneWire_ResetDone(bus, Data, UseBreak);
+	
+	if(Result && (Speed != bus->Speed))
+	{
+		return OneWireBus_Reset(bus); // Try again at standard speed
+	}
+	
+	return Result;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	initialize a one wire bus. The UART behind it must already
+///	be set up.
+///
+///	\param bus the bus
+///	\param uart the UART operations
+///	\param context passed to the UART operations. ie. the UartPortType
+/////////////////////////////////////////////////////////////////////////
+void OneWireBus_Init(OneWireBusType *bus, const OneWireUartOpsType *uart, void *context)
+{
+	bus->Uart = uart;
+	bus->UartContext = context;
+	bus->Baud = 0;
+	bus->ResetMode = OWR_Baud;
+	bus->Speed = OWS_Standard;
+	bus->Policy.Timeout = ONEWIRE_TIMEOUT;
+	bus->Policy.BusyPolls = ONEWIRE_BUSY_POLLS;
+	bus->Policy.Backoff = ONEWIRE_BACKOFF;
+	bus->Policy.Retries = ONEWIRE_RETRIES;
+	bus->Policy.ResetBeforeRetry = TRUE;
+	bus->ResetCount = 0;
+#if ONEWIRE_STATS
+	CycleCounter_Init();
+	OneWireBus_StatsReset(bus);
+#endif
+	bus->TransactionHead = 0;
+	bus->TransactionTail = 0;
+	bus->EngineForceReset = FALSE;
+	bus->EngineWait = 0;
+	bus->EngineBackoff = 0;
+	
+	OneWireBus_Reset(bus);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Start a new search. Also use this to force a full rescan.
+///
+///	\param search the search state
+///	\param command the ROM command to search with. ie. search ROM (0xF0)
+///		or alarm search (0xEC)
+/////////////////////////////////////////////////////////////////////////
+void OneWire_SearchInit(OneWireSearchType *search, uint8_t command)
+{
+	uint8_t Index;
+	
+	for(Index = 0; Index < ONEWIRE_ROM_LENGTH; Index++)
+	{
+		search->Rom.Code[Index] = 0;
+		search->Branches.Code[Index] = 0;
+	}
+	
+	search->Command = command;
+	search->LastDiscrepancy = 0;
+	search->LastFamilyDiscrepancy = 0;
+	search->LastDevice = FALSE;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Find the next device on the bus with the binary tree search
+///	described in the Maxim application note AN187. The search carries
+///	on from the last discrepancy kept in the search state.
+///
+///	\param bus the bus
+///	\param search the search state
+///	\param rom pointer to return the ROM code found
+///	\return FALSE when a device was found. TRUE when there are no more 
+///		devices or on error. The search is restarted in both cases.
+/////////////////////////////////////////////////////////////////////////
+int_fast8_t OneWireBus_SearchNext(OneWireBusType *bus, OneWireSearchType *search, OneWireRomType *rom)
+{
+	uint8_t BitNumber = 1;
+	uint8_t LastZero = 0;
+	uint8_t ByteNumber = 0;
+	uint8_t ByteMask = 1;
+	uint8_t CRC = OneWire_CRCInit();
+	uint8_t Bits;
+	uint8_t Direction;
+	uint8_t Found = FALSE;
+	uint8_t Index;
+	
+	for(Index = 0; Index < ONEWIRE_ROM_LENGTH; Index++)
+	{
+		search->Branches.Code[Index] = 0;
+	}
+	
+	if(!search->LastDevice && !OneWireBus_Reset(bus) && !OneWireBus_Write(bus, search->Command))
+	{
+		do
+		{
+			// Read the bit and its complement
+			if(OneWire_TransferBits(bus, OneWireTrue, 2, &Bits))
+			{
+				break;
+			}
+			
+			if(Bits == 0x03)
+			{
+				// No device took part
+				break;
+			}
+			
+			if(!Bits)
+			{
+				// Devices on both branches
+				search->Branches.Code[ByteNumber] |= ByteMask;
+			}
+			
+			if(Bits)
+			{
+				// All the devices agree on this bit
+				Direction = Bits & OneWireBitMask;
+			}
+			else if(BitNumber < search->LastDiscrepancy)
+			{
+				// Take the same path as last time
+				Direction = (search->Rom.Code[ByteNumber] & ByteMask) ? 1 : 0;
+			}
+			else
+			{
+				// Take the 1 branch only at the last discrepancy
+				Direction = (BitNumber == search->LastDiscrepancy) ? 1 : 0;
+			}
+			
+			if(!Bits && !Direction)
+			{
+				LastZero = BitNumber;
+				
+				if(LastZero < 9)
+				{
+					search->LastFamilyDiscrepancy = LastZero;
+				}
+			}
+			
+			if(Direction)
+			{
+				search->Rom.Code[ByteNumber] |= ByteMask;
+			}
+			else
+			{
+				search->Rom.Code[ByteNumber] &= ~ByteMask;
+			}
+			
+			// Drop the devices that don't match
+			if(OneWire_TransferBits(bus, Direction, 1, &Bits))
+			{
+				break;
+			}
+			
+			BitNumber++;
+			ByteMask = ByteMask << 1;
+			
+			if(!ByteMask)
+			{
+				CRC = OneWire_CRCUpdate(CRC, search->Rom.Code[ByteNumber]);
+				ByteNumber++;
+				ByteMask = 1;
+			}
+		}
+		while(ByteNumber < ONEWIRE_ROM_LENGTH);
+		
+		if((ByteNumber == ONEWIRE_ROM_LENGTH) && OneWire_CRCFinal(CRC))
+		{
+			ONEWIRE_STATS_ADD(bus, CRCFailures, 1);
+		}
+		else if((ByteNumber == ONEWIRE_ROM_LENGTH) && search->Rom.Code[0])
+		{
+			search->LastDiscrepancy = LastZero;
+			search->LastDevice = LastZero ? FALSE : TRUE;
+			Found = TRUE;
+		}
+	}
+	
+	if(!Found)
+	{
+		OneWire_SearchInit(search, search->Command);
+		return TRUE;
+	}
+	
+	*rom = search->Rom;
+	
+	return FALSE;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Fill a ROM table with the devices on the bus. If the table
+///	fills up call it again with the same search state to get the rest.
+///
+///	\param bus the bus
+///	\param search the search state
+///	\param table where to store the ROM codes found
+///	\param tableSize how many entries the table can hold
+///	\return how many ROM codes were stored in the table
+/////////////////////////////////////////////////////////////////////////
+uint8_t OneWireBus_SearchRom(OneWireBusType *bus, OneWireSearchType *search, OneWireRomType *table, uint8_t tableSize)
+{
+	uint8_t Count = 0;
+	
+	while(Count < tableSize)
+	{
+		if(OneWireBus_SearchNext(bus, search, &table[Count]))
+		{
+			break;
+		}
+		
+		Count++;
+		
+		if(search->LastDevice)
+		{
+			// Get ready for the next scan
+			OneWire_SearchInit(search, search->Command);
+			break;
+		}
+	}
+	
+	return Count;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Check that a known device is still on the bus. This is a
+///	single search pass down the device ROM path so it's much cheaper
+///	than a full search.
+///
+///	The branches tell what else is on the bus. A bit is set where other
+///	devices share the ROM code up to that bit and differ at it, so with
+///	the branches of every known device an unknown one shows up as a
+///	branch that none of the others explain.
+///
+///	\param bus the bus
+///	\param rom the ROM code to look for
+///	\param command the search ROM command
+///	\param branches pointer to return the branches on the path or NULL,
+///		see OneWireSearchType Branches. Only valid when the device is
+///		present
+///	\return FALSE if the device is present else TRUE
+/////////////////////////////////////////////////////////////////////////
+int_fast8_t OneWireBus_Verify(OneWireBusType *bus, const OneWireRomType *rom, uint8_t command, OneWireRomType *branches)
+{
+	OneWireSearchType Search;
+	OneWireRomType Found;
+	uint8_t Index;
+	
+	OneWire_SearchInit(&Search, command);
+	
+	// Follow the ROM path at every discrepancy
+	Search.Rom = *rom;
+	Search.LastDiscrepancy = 64;
+	
+	if(OneWireBus_SearchNext(bus, &Search, &Found))
+	{
+		return TRUE;
+	}
+	
+	for(Index = 0; Index < ONEWIRE_ROM_LENGTH; Index++)
+	{
+		if(Found.Code[Index] != rom->Code[Index])
+		{
+			return TRUE;
+		}
+	}
+	
+	if(branches)
+	{
+		*branches = Search.Branches;
+	}
+	
+	return FALSE;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Put devices in overdrive and switch the bus to overdrive 
+///	speed. Starts with a standard speed reset so every device is back at
+///	standard speed first. With a ROM code only that device is selected,
+///	without one every overdrive capable device is. Either way the 
+///	selected devices wait for a function command. Devices that don't
+///	support overdrive ignore the bus until the next standard reset.
+///
+///	From here on the bus resets and transfers at overdrive speed until 
+///	nothing answers an overdrive reset, then it falls back to standard
+///	speed.
+///
+///	\param bus the bus
+///	\param rom the ROM code of the device or NULL for all devices
+///	\return OW_Success, OW_NoPresence or OW_Timeout
+/////////////////////////////////////////////////////////////////////////
+int_fast8_t OneWireBus_Overdrive(OneWireBusType *bus, const OneWireRomType *rom)
+{
+	int_fast8_t Result;
+	
+	bus->Speed = OWS_Standard;
+	
+	Result = OneWireBus_Reset(bus);
+	
+	if(!Result)
+	{
+		Result = OneWireBus_Write(bus, rom ? OverdriveMatchRom : OverdriveSkipRom);
+	}
+	
+	if(Result)
+	{
+		return Result;
+	}
+	
+	bus->Speed = OWS_Overdrive;
+	
+	if(rom)
+	{
+		Result = OneWireBus_WriteBlock(bus, &rom->Code[0], ONEWIRE_ROM_LENGTH);
+	}
+	
+	return Result;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Length of the command part of the transaction
+/////////////////////////////////////////////////////////////////////////
+static uint8_t OneWire_CommandLength(const OneWireTransactionType *transaction)
+{
+	uint8_t Length = 0;
+	
+	if(transaction->Flags & ONEWIRE_TRANSACTION_ROM)
+	{
+		Length += transaction->Rom ? 9 : 1;
+	}
+	
+	if(transaction->Flags & ONEWIRE_TRANSACTION_FUNCTION)
+	{
+		Length++;
+	}
+	
+	return Length;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Get the byte to put on the bus at the given position
+///
+///	\param transaction the active transaction
+///	\param position byte position in the transaction
+///	\return the byte to send. 0xFF while reading
+/////////////////////////////////////////////////////////////////////////
+static uint8_t OneWire_TransactionByte(const OneWireTransactionType *transaction, uint8_t position)
+{
+	if(transaction->Flags & ONEWIRE_TRANSACTION_ROM)
+	{
+		if(!position)
+		{
+			return transaction->RomCommand;
+		}
+		
+		position--;
+		
+		if(transaction->Rom)
+		{
+			if(position < 8)
+			{
+				return transaction->Rom[position];
+			}
+			
+			position -= 8;
+		}
+	}
+	
+	if(transaction->Flags & ONEWIRE_TRANSACTION_FUNCTION)
+	{
+		if(!position)
+		{
+			return transaction->FunctionCommand;
+		}
+		
+		position--;
+	}
+	
+	if(position < transaction->TxLength)
+	{
+		return transaction->TxData[position];
+	}
+	
+	return OneWireTrue;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Put the next slot of the active transaction on the bus. The
+///	poll never waits for room, a full transmit buffer fails the slot
+///	straight away rather than waiting out the echo timeout for a slot
+///	that was never sent.
+///
+///	\param bus the bus
+///	\return OW_Success or OW_Timeout if the UART didn't take the slot
+/////////////////////////////////////////////////////////////////////////
+static int_fast8_t OneWire_SendSlot(OneWireBusType *bus)
+{
+	uint8_t Source = OneWire_TransactionByte(bus->TransactionHead, bus->EnginePosition);
+	uint8_t Slot = ((Source >> bus->EngineBit) & OneWireBitMask) ? OneWireTrue : OneWireFalse;
+	
+	if(bus->Uart->Write(bus->UartContext, &Slot, 1))
+	{
+		ONEWIRE_STATS_ADD(bus, Timeouts, 1);
+		return OW_Timeout;
+	}
+	
+	ONEWIRE_STATS_ADD(bus, Slots, 1);
+	
+	return OW_Success;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Take the active transaction off the queue and tell the owner
+///
+///	\param bus the bus
+///	\param state the final transaction state
+/////////////////////////////////////////////////////////////////////////
+static void OneWire_Complete(OneWireBusType *bus, OneWireTransactionStateEnum state)
+{
+	OneWireTransactionType *Transaction = bus->TransactionHead;
+	
+	{
+		ONEWIRE_ENTER_CRITICAL();
+		
+		bus->TransactionHead = Transaction->Next;
+		
+		if(!bus->TransactionHead)
+		{
+			bus->TransactionTail = 0;
+		}
+		
+		Transaction->Next = 0;
+		Transaction->State = state;
+		
+		ONEWIRE_EXIT_CRITICAL();
+	}
+	
+	ONEWIRE_STATS_LATENCY(bus, TransactionLatency, bus->EngineStart);
+	
+	if(Transaction->Callback)
+	{
+		Transaction->Callback(Transaction);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	The active transaction failed. Queue it up again if the retry
+///	policy allows it, otherwise complete it with the error.
+///
+///	\param bus the bus
+///	\param error the OneWireErrorEnum reason
+/////////////////////////////////////////////////////////////////////////
+static void OneWire_Fail(OneWireBusType *bus, uint8_t error)
+{
+	OneWireTransactionType *Transaction = bus->TransactionHead;
+	const OneWirePolicyType *Policy = Transaction->Policy ? Transaction->Policy : &bus->Policy;
+	
+	bus->EngineWait = 0;
+	
+	if(Transaction->Attempt < Policy->Retries)
+	{
+		bus->EngineBackoff = Policy->Backoff << Transaction->Attempt;
+		bus->EngineForceReset = Policy->ResetBeforeRetry;
+		ONEWIRE_STATS_ADD(bus, Retries, 1);
+		Transaction->Attempt++;
+		Transaction->State = OWT_Queued;
+		return;
+	}
+	
+	Transaction->Error = error;
+	OneWire_Complete(bus, OWT_Error);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Start the transaction at the head of the queue
+///
+///	\param bus the bus
+/////////////////////////////////////////////////////////////////////////
+static void OneWire_Start(OneWireBusType *bus)
+{
+	OneWireTransactionType *Transaction = bus->TransactionHead;
+	uint8_t Data;
+	
+	// Let the slots of a failed attempt go out before the stale echoes are
+	// thrown away. One check per poll so the poll still never blocks
+	if(!bus->Uart->WriteComplete(bus->UartContext))
+	{
+		bus->EngineWait++;
+		
+		if(bus->EngineWait > (Transaction->Policy ? Transaction->Policy : &bus->Policy)->Timeout)
+		{
+			ONEWIRE_STATS_ADD(bus, Timeouts, 1);
+			OneWire_Fail(bus, OW_Timeout);
+		}
+		
+		return;
+	}
+	
+	while(bus->Uart->Read(bus->UartContext, &Data, 1)) ;
+	
+#if ONEWIRE_STATS
+	if(!Transaction->Attempt)
+	{
+		bus->EngineStart = CycleCounter_Read();
+	}
+#endif
+	
+	Transaction->State = OWT_Active;
+	bus->EnginePosition = 0;
+	bus->EngineBit = 0;
+	bus->EngineData = 0;
+	bus->EngineWait = 0;
+	bus->EngineLength = OneWire_CommandLength(Transaction) + Transaction->TxLength + Transaction->RxLength;
+	bus->EngineResetting = (bus->EngineForceReset || (Transaction->Flags & ONEWIRE_TRANSACTION_RESET)) ? TRUE : FALSE;
+	
+	// Always the baudrate reset, the break one would block the poll
+	if(bus->EngineResetting)
+	{
+		if(OneWire_SendReset(bus, FALSE))
+		{
+			OneWire_Fail(bus, OW_Timeout);
+			return;
+		}
+	}
+	else if(bus->EngineLength)
+	{
+		if(OneWire_Setbaud(bus, OneWire_Timing(bus)->SlotBaud))
+		{
+			OneWire_Fail(bus, OW_Timeout);
+			return;
+		}
+		
+		if(OneWire_SendSlot(bus))
+		{
+			OneWire_Fail(bus, OW_Timeout);
+		}
+	}
+	else
+	{
+		OneWire_Complete(bus, OWT_Done);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Queue a transaction. Non-Blocking, the transaction is carried
+///	out by OneWire_Poll(). Safe against a poll from an interrupt once
+///	ONEWIRE_ENTER_CRITICAL() and ONEWIRE_EXIT_CRITICAL() are defined.
+///
+///	\param bus the bus
+///	\param transaction the transaction descriptor
+///	\return FALSE on success else TRUE if the transaction is already queued
+///		or is longer than ONEWIRE_TRANSACTION_MAX_LENGTH bytes
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t OneWireBus_Submit(OneWireBusType *bus, OneWireTransactionType *transaction)
+{
+	ONEWIRE_ENTER_CRITICAL();
+	
+	if((OWT_Queued == transaction->State) || (OWT_Active == transaction->State) ||
+		(((uint16_t)OneWire_CommandLength(transaction) + transaction->TxLength + transaction->RxLength) > ONEWIRE_TRANSACTION_MAX_LENGTH))
+	{
+		ONEWIRE_EXIT_CRITICAL();
+		return TRUE;
+	}
+	
+	transaction->State = OWT_Queued;
+	transaction->Error = OW_Success;
+	transaction->Attempt = 0;
+	transaction->Next = 0;
+	
+	if(bus->TransactionTail)
+	{
+		bus->TransactionTail->Next = transaction;
+	}
+	else
+	{
+		bus->TransactionHead = transaction;
+	}
+	
+	bus->TransactionTail = transaction;
+	
+	ONEWIRE_EXIT_CRITICAL();
+	
+	return FALSE;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Move the transaction engine on. Call this from the main loop
+///	or the UART receive interrupt. Each call handles at most one echo
+///	and puts at most one slot on the bus, so it never blocks. When it
+///	runs from an interrupt define ONEWIRE_ENTER_CRITICAL() and
+///	ONEWIRE_EXIT_CRITICAL() so OneWireBus_Submit() can't race it.
+///
+///	\param bus the bus
+/////////////////////////////////////////////////////////////////////////
+void OneWireBus_Poll(OneWireBusType *bus)
+{
+	OneWireTransactionType *Transaction = bus->TransactionHead;
+	uint8_t Echo;
+	uint8_t Position;
+	int_fast8_t Result;
+	
+	if(!Transaction)
+	{
+		return;
+	}
+	
+	if(OWT_Queued == Transaction->State)
+	{
+		// Back off before a retry
+		if(bus->EngineBackoff)
+		{
+			bus->EngineBackoff--;
+			return;
+		}
+		
+		OneWire_Start(bus);
+		return;
+	}
+	
+	// Wait for the echo of the last slot
+	if(!bus->Uart->Read(bus->UartContext, &Echo, 1))
+	{
+		bus->EngineWait++;
+		
+		if(bus->EngineWait > (Transaction->Policy ? Transaction->Policy : &bus->Policy)->Timeout)
+		{
+			ONEWIRE_STATS_ADD(bus, Timeouts, 1);
+			OneWire_Fail(bus, OW_Timeout);
+		}
+		
+		return;
+	}
+	
+	bus->EngineWait = 0;
+	
+	if(bus->EngineResetting)
+	{
+		bus->EngineResetting = FALSE;
+		
+		// A reset on its own before a retry. Now start the retry proper
+		if(bus->EngineForceReset)
+		{
+			bus->EngineForceReset = FALSE;
+			Transaction->State = OWT_Queued;
+			return;
+		}
+		
+		// check if device is in the network
+		Result = OneWire_ResetDone(bus, Echo, FALSE);
+		
+		if(Result)
+		{
+			OneWire_Fail(bus, Result);
+			return;
+		}
+		
+		if(!bus->EngineLength)
+		{
+			OneWire_Complete(bus, OWT_Done);
+			return;
+		}
+		
+		if(OneWire_Setbaud(bus, OneWire_Timing(bus)->SlotBaud))
+		{
+			OneWire_Fail(bus, OW_Timeout);
+			return;
+		}
+		
+		if(OneWire_SendSlot(bus))
+		{
+			OneWire_Fail(bus, OW_Timeout);
+		}
+		
+		return;
+	}
+	
+	bus->EngineData = bus->EngineData >> 1; //ShiftData
+	
+	if(Echo == OneWireTrue)
+	{
+		bus->EngineData += 0x80;
+	}
+	
+	bus->EngineBit++;
+	
+	if(bus->EngineBit == OneWireBitLength)
+	{
+		// Store the byte if it's part of the read
+		Position = bus->EngineLength - Transaction->RxLength;
+		
+		if(bus->EnginePosition >= Position)
+		{
+			Transaction->RxData[bus->EnginePosition - Position] = bus->EngineData;
+		}
+		
+		bus->EngineBit = 0;
+		bus->EngineData = 0;
+		bus->EnginePosition++;
+		ONEWIRE_STATS_ADD(bus, Bytes, 1);
+		
+		if(bus->EnginePosition == bus->EngineLength)
+		{
+			OneWire_Complete(bus, OWT_Done);
+			return;
+		}
+	}
+	
+	if(OneWire_SendSlot(bus))
+	{
+		OneWire_Fail(bus, OW_Timeout);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Check if the transaction engine has work to do. Don't use the
+///	blocking calls while it's busy.
+///
+///	\param bus the bus
+///	\return TRUE if there are transactions queued or active
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t OneWireBus_Busy(OneWireBusType *bus)
+{
+	return (bus->TransactionHead != 0);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Apply the bus retry policy after a failed blocking transaction.
+///	Waits out the back-off and sends the lone reset if the policy asks
+///	for it.
+///
+///	\param bus the bus
+///	\param attempt retries so far. Start at zero, updated by the call
+///	\return FALSE if the transaction should be tried again else TRUE
+///		once the retries are used up
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t OneWireBus_Retry(OneWireBusType *bus, uint8_t *attempt)
+{
+	volatile uint32_t Backoff;
+	
+	if(*attempt >= bus->Policy.Retries)
+	{
+		return TRUE;
+	}
+	
+	for(Backoff = bus->Policy.Backoff << *attempt; Backoff; Backoff--) ;
+	
+	if(bus->Policy.ResetBeforeRetry)
+	{
+		OneWireBus_Reset(bus);
+	}
+	
+	ONEWIRE_STATS_ADD(bus, Retries, 1);
+	(*attempt)++;
+	
+	return FALSE;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	How many times a busy device is polled before giving up at
+///	the current bus speed. The policy BusyPolls is counted at standard
+///	speed, the faster polls at overdrive get as much time in all.
+///
+///	\param bus the bus
+///	\return the poll budget
+/////////////////////////////////////////////////////////////////////////
+uint32_t OneWireBus_BusyPolls(const OneWireBusType *bus)
+{
+	return bus->Policy.BusyPolls * OneWire_Timing(bus)->BusyPollScale;
+}
+
+#if ONEWIRE_STATS
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Clear the bus statistics
+///
+///	\param bus the bus
+/////////////////////////////////////////////////////////////////////////
+void OneWireBus_StatsReset(OneWireBusType *bus)
+{
+	OneWireStatsType EmptyStats = {0};
+	
+	bus->Stats = EmptyStats;
+}
+#endif
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	initialize one wire interface on the default UART
+/////////////////////////////////////////////////////////////////////////
+void OneWire_Init(void)
+{
+	Uart_Init(Baudrate9600);
+	OneWireBus_Init(&OneWireDefaultBus, &OneWireUartPortOps, &UartDefaultPort);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Reset the connected 1 wire device
+///	\sa OneWireBus_Reset
+/////////////////////////////////////////////////////////////////////////
+uint8_t OneWire_Reset(void)
+{
+	return OneWireBus_Reset(&OneWireDefaultBus);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read one byte from device
+///	\sa OneWireBus_Read
+/////////////////////////////////////////////////////////////////////////
+int_fast8_t OneWire_Read(uint8_t *data)
+{
+	return OneWireBus_Read(&OneWireDefaultBus, data);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Writes one byte
+///	\sa OneWireBus_Write
+/////////////////////////////////////////////////////////////////////////
+int_fast8_t OneWire_Write(const uint8_t source)
+{
+	return OneWireBus_Write(&OneWireDefaultBus, source);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read a single bit from the device
+///	\sa OneWireBus_ReadBit
+/////////////////////////////////////////////////////////////////////////
+int_fast8_t OneWire_ReadBit(uint8_t *data)
+{
+	return OneWireBus_ReadBit(&OneWireDefaultBus, data);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Writes a single bit
+///	\sa OneWireBus_WriteBit
+/////////////////////////////////////////////////////////////////////////
+int_fast8_t OneWire_WriteBit(const uint8_t source)
+{
+	return OneWireBus_WriteBit(&OneWireDefaultBus, source);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read a block of bytes from the device
+///	\sa OneWireBus_ReadBlock
+/////////////////////////////////////////////////////////////////////////
+int_fast8_t OneWire_ReadBlock(uint8_t *destination, uint8_t length)
+{
+	return OneWireBus_ReadBlock(&OneWireDefaultBus, destination, length);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read a block of bytes and add them to a running CRC
+///	\sa OneWireBus_ReadBlockCRC
+/////////////////////////////////////////////////////////////////////////
+int_fast8_t OneWire_ReadBlockCRC(uint8_t *destination, uint8_t length, uint8_t *crc)
+{
+	return OneWireBus_ReadBlockCRC(&OneWireDefaultBus, destination, length, crc);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Writes a block of bytes
+///	\sa OneWireBus_WriteBlock
+/////////////////////////////////////////////////////////////////////////
+int_fast8_t OneWire_WriteBlock(const uint8_t *source, uint8_t length)
+{
+	return OneWireBus_WriteBlock(&OneWireDefaultBus, source, length);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Find the next device on the bus
+///	\sa OneWireBus_SearchNext
+/////////////////////////////////////////////////////////////////////////
+int_fast8_t OneWire_SearchNext(OneWireSearchType *search, OneWireRomType *rom)
+{
+	return OneWireBus_SearchNext(&OneWireDefaultBus, search, rom);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Fill a ROM table with the devices on the bus
+///	\sa OneWireBus_SearchRom
+/////////////////////////////////////////////////////////////////////////
+uint8_t OneWire_SearchRom(OneWireSearchType *search, OneWireRomType *table, uint8_t tableSize)
+{
+	return OneWireBus_SearchRom(&OneWireDefaultBus, search, table, tableSize);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Check that a known device is still on the bus
+///	\sa OneWireBus_Verify
+/////////////////////////////////////////////////////////////////////////
+int_fast8_t OneWire_Verify(const OneWireRomType *rom, uint8_t command)
+{
+	return OneWireBus_Verify(&OneWireDefaultBus, rom, command, 0);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Switch the default bus to overdrive speed
+///	\sa OneWireBus_Overdrive
+/////////////////////////////////////////////////////////////////////////
+int_fast8_t OneWire_Overdrive(const OneWireRomType *rom)
+{
+	return OneWireBus_Overdrive(&OneWireDefaultBus, rom);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Queue a transaction
+///	\sa OneWireBus_Submit
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t OneWire_Submit(OneWireTransactionType *transaction)
+{
+	return OneWireBus_Submit(&OneWireDefaultBus, transaction);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Move the transaction engine on
+///	\sa OneWireBus_Poll
+/////////////////////////////////////////////////////////////////////////
+void OneWire_Poll(void)
+{
+	OneWireBus_Poll(&OneWireDefaultBus);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Check if the transaction engine has work to do
+///	\sa OneWireBus_Busy
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t OneWire_Busy(void)
+{
+	return OneWireBus_Busy(&OneWireDefaultBus);
+}
+
+#if ONEWIRE_CRC_METHOD == ONEWIRE_CRC_TABLE
+/////////////////////////////////////////////////////////////////////////
+///	\brief	CRC of every possible byte value with the Dallas polynomial.
+/////////////////////////////////////////////////////////////////////////
+static const uint8_t CRCTable[256] = {
+	0x00, 0x5E, 0xBC, 0xE2, 0x61, 0x3F, 0xDD, 0x83, 0xC2, 0x9C, 0x7E, 0x20, 0xA3, 0xFD, 0x1F, 0x41,
+	0x9D, 0xC3, 0x21, 0x7F, 0xFC, 0xA2, 0x40, 0x1E, 0x5F, 0x01, 0xE3, 0xBD, 0x3E, 0x60, 0x82, 0xDC,
+	0x23, 0x7D, 0x9F, 0xC1, 0x42, 0x1C, 0xFE, 0xA0, 0xE1, 0xBF, 0x5D, 0x03, 0x80, 0xDE, 0x3C, 0x62,
+	0xBE, 0xE0, 0x02, 0x5C, 0xDF, 0x81, 0x63, 0x3D, 0x7C, 0x22, 0xC0, 0x9E, 0x1D, 0x43, 0xA1, 0xFF,
+	0x46, 0x18, 0xFA, 0xA4, 0x27, 0x79, 0x9B, 0xC5, 0x84, 0xDA, 0x38, 0x66, 0xE5, 0xBB, 0x59, 0x07,
+	0xDB, 0x85, 0x67, 0x39, 0xBA, 0xE4, 0x06, 0x58, 0x19, 0x47, 0xA5, 0xFB, 0x78, 0x26, 0xC4, 0x9A,
+	0x65, 0x3B, 0xD9, 0x87, 0x04, 0x5A, 0xB8, 0xE6, 0xA7, 0xF9, 0x1B, 0x45, 0xC6, 0x98, 0x7A, 0x24,
+	0xF8, 0xA6, 0x44, 0x1A, 0x99, 0xC7, 0x25, 0x7B, 0x3A, 0x64, 0x86, 0xD8, 0x5B, 0x05, 0xE7, 0xB9,
+	0x8C, 0xD2, 0x30, 0x6E, 0xED, 0xB3, 0x51, 0x0F, 0x4E, 0x10, 0xF2, 0xAC, 0x2F, 0x71, 0x93, 0xCD,
+	0x11, 0x4F, 0xAD, 0xF3, 0x70, 0x2E, 0xCC, 0x92, 0xD3, 0x8D, 0x6F, 0x31, 0xB2, 0xEC, 0x0E, 0x50,
+	0xAF, 0xF1, 0x13, 0x4D, 0xCE, 0x90, 0x72, 0x2C, 0x6D, 0x33, 0xD1, 0x8F, 0x0C, 0x52, 0xB0, 0xEE,
+	0x32, 0x6C, 0x8E, 0xD0, 0x53, 0x0D, 0xEF, 0xB1, 0xF0, 0xAE, 0x4C, 0x12, 0x91, 0xCF, 0x2D, 0x73,
+	0xCA, 0x94, 0x76, 0x28, 0xAB, 0xF5, 0x17, 0x49, 0x08, 0x56, 0xB4, 0xEA, 0x69, 0x37, 0xD5, 0x8B,
+	0x57, 0x09, 0xEB, 0xB5, 0x36, 0x68, 0x8A, 0xD4, 0x95, 0xCB, 0x29, 0x77, 0xF4, 0xAA, 0x48, 0x16,
+	0xE9, 0xB7, 0x55, 0x0B, 0x88, 0xD6, 0x34, 0x6A, 0x2B, 0x75, 0x97, 0xC9, 0x4A, 0x14, 0xF6, 0xA8,
+	0x74, 0x2A, 0xC8, 0x96, 0x15, 0x4B, 0xA9, 0xF7, 0xB6, 0xE8, 0x0A, 0x54, 0xD7, 0x89, 0x6B, 0x35
+};
+#elif ONEWIRE_CRC_METHOD == ONEWIRE_CRC_NIBBLE
+/////////////////////////////////////////////////////////////////////////
+///	\brief	CRC of the low nibble values with the Dallas polynomial.
+/////////////////////////////////////////////////////////////////////////
+static const uint8_t CRCTableLow[16] = {
+	0x00, 0x5E, 0xBC, 0xE2, 0x61, 0x3F, 0xDD, 0x83, 0xC2, 0x9C, 0x7E, 0x20, 0xA3, 0xFD, 0x1F, 0x41
+};
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	CRC of the high nibble values with the Dallas polynomial.
+/////////////////////////////////////////////////////////////////////////
+static const uint8_t CRCTableHigh[16] = {
+	0x00, 0x9D, 0x23, 0xBE, 0x46, 0xDB, 0x65, 0xF8, 0x8C, 0x11, 0xAF, 0x32, 0xCA, 0x57, 0xE9, 0x74
+};
+#endif
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Start a new CRC calculation
+///
+///	\return the initial CRC value
+/////////////////////////////////////////////////////////////////////////
+uint8_t OneWire_CRCInit(void)
+{
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Add one byte to a running CRC. Handy to check the data as
+///	it arrives instead of in a separate pass afterwards.
+///
+///	\param crc the running CRC
+///	\param data the next byte
+///
+///	\return the updated CRC
+/////////////////////////////////////////////////////////////////////////
+uint8_t OneWire_CRCUpdate(uint8_t crc, const uint8_t data)
+{
+#if ONEWIRE_CRC_METHOD == ONEWIRE_CRC_TABLE
+	return CRCTable[crc ^ data];
+#elif ONEWIRE_CRC_METHOD == ONEWIRE_CRC_NIBBLE
+	crc = crc ^ data;
+	
+	return CRCTableLow[crc & 0x0F] ^ CRCTableHigh[crc >> 4];
+#else
+	uint8_t BitIndex;
+	
+	crc = crc ^ data;
+	
+	for (BitIndex = 0; BitIndex < 8; BitIndex++) 
+	{ 
+		if (crc & 0x01) 
+		{
+			crc = (crc >> 1) ^ 0x8C; 
+		}
+		else
+		{
+			crc >>= 1; 
+		}
+	} 
+	
+	return crc;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Finish a running CRC
+///
+///	\param crc the running CRC
+///
+///	\return the final CRC. If the data included the CRC byte then this
+///		is zero when the data is good.
+/////////////////////////////////////////////////////////////////////////
+uint8_t OneWire_CRCFinal(uint8_t crc)
+{
+	// The Dallas CRC has no final XOR
+	return crc;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Calculates 1-wire CRC with the from the given array.
+/// 	If source array contains the CRC then expect the calculated CRC 
+///		to be zero.
+///
+///	\param source pointer to the byte array
+///	\param length how many byte to process
+///
+///	\return returned the calculated CRC
+///
+///	\note the original bitwise source was made 
+///		by clawson @ http://www.avrfreaks.net/index.php?name=PNphpBB2&file=printview&t=85318
+///		Set ONEWIRE_CRC_METHOD to pick the bitwise, nibble or byte table
+///		version.
+/////////////////////////////////////////////////////////////////////////
+uint8_t OneWire_CalculateCRC(uint8_t * source, uint8_t length) 
+{ 
+	uint8_t CRC = OneWire_CRCInit();
+
+	while(length)
+	{
+		CRC = OneWire_CRCUpdate(CRC, *source);
+		
+		source++;
+		length--;
+	}
+	
+	return OneWire_CRCFinal(CRC); 
 }
@@ -27,15 +27,490 @@
 ///		LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 ///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 ///		THE SOFTWARE.
+///
+///
+///	Non-Blocking Transaction Code Example:
+///	\code
+///	#include "onewire.h"
+///
+///	static uint8_t Scratchpad[9];
+///	static OneWireTransactionType ReadScratchpad;
+///
+///	void ScratchpadDone(OneWireTransactionType *transaction)
+///	{
+///		if(OWT_Done == transaction->State)
+///			{
+///				// Scratchpad holds the data
+///			}
+///	}
+///
+///	void main(void)
+///	{
+///		OneWire_Init();
+///
+///		ReadScratchpad.Flags = ONEWIRE_TRANSACTION_RESET | ONEWIRE_TRANSACTION_ROM | ONEWIRE_TRANSACTION_FUNCTION;
+///		ReadScratchpad.RomCommand = 0xCC; // Skip ROM
+///		ReadScratchpad.FunctionCommand = 0xBE; // Read scratchpad
+///		ReadScratchpad.RxData = &Scratchpad[0];
+///		ReadScratchpad.RxLength = sizeof(Scratchpad);
+///		ReadScratchpad.Callback = ScratchpadDone;
+///
+///		OneWire_Submit(&ReadScratchpad);
+///
+///		for( ;; ) // program loop
+///		{
+///			OneWire_Poll(); // moves the bus on by at most one slot
+///
+///			// Process something else
+///			YourProcess();
+///		}
+///	}
+///	\endcode
+///
+///
+///	Two Buses Code Example:
+///	\code
+///	#include "uart.h"
+///	#include "onewire.h"
+///
+///	static UartPortType Port1;
+///	static UartPortType Port2;
+///	static OneWireBusType Bus1;
+///	static OneWireBusType Bus2;
+///
+///	void main(void)
+///	{
+///		UartPort_Init(&Port1, USART1, 9600);
+///		UartPort_Init(&Port2, USART2, 9600);
+///		OneWireBus_Init(&Bus1, &OneWireUartPortOps, &Port1);
+///		OneWireBus_Init(&Bus2, &OneWireUartPortOps, &Port2);
+///
+///		OneWireBus_Submit(&Bus1, &ReadScratchpad1);
+///		OneWireBus_Submit(&Bus2, &ReadScratchpad2);
+///
+///		for( ;; ) // program loop
+///		{
+///			OneWireBus_Poll(&Bus1);
+///			OneWireBus_Poll(&Bus2);
+///		}
+///	}
+///	\endcode
+///
+///
+///	Overdrive Code Example:
+///	\code
+///	#include "onewire.h"
+///
+///	void main(void)
+///	{
+///		uint8_t Scratchpad[9];
+///
+///		OneWire_Init();
+///
+///		// Every overdrive capable device switches to overdrive
+///		if(!OneWire_Overdrive(0))
+///		{
+///			OneWire_Write(0xBE); // Read scratchpad at overdrive speed
+///			OneWire_ReadBlock(&Scratchpad[0], sizeof(Scratchpad));
+///		}
+///
+///		// Resets are now overdrive resets. When no device answers one the
+///		// bus goes back to standard speed on its own.
+///		OneWire_Reset();
+///	}
+///	\endcode
 ////////////////////////////////////////////////////////////////////////////////
 #ifndef __ONE_WIRE_LAYER_MCU_H__
 #define __ONE_WIRE_LAYER_MCU_H__
 	#include <stdint.h>
 	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	When set to 1 the eight slots of a byte are queued in the
+	///	UART as one burst and the echoes are decoded afterwards. Set it to 0
+	///	for UARTs that can't buffer a full byte of slots.
+	/////////////////////////////////////////////////////////////////////////
+	#ifndef ONEWIRE_BURST
+		#define ONEWIRE_BURST 1
+	#endif
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	ONEWIRE_CRC_METHOD values. The bitwise version needs no
+	///	table, the nibble version 32 bytes and the byte version 256 bytes.
+	/////////////////////////////////////////////////////////////////////////
+	#define ONEWIRE_CRC_BITWISE	0
+	#define ONEWIRE_CRC_NIBBLE	1
+	#define ONEWIRE_CRC_TABLE	2
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Selects how the CRC is calculated
+	/////////////////////////////////////////////////////////////////////////
+	#ifndef ONEWIRE_CRC_METHOD
+		#define ONEWIRE_CRC_METHOD ONEWIRE_CRC_TABLE
+	#endif
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Default number of polls to wait for room in the UART buffer
+	///	or for an echo before giving up with OW_Timeout
+	/////////////////////////////////////////////////////////////////////////
+	#ifndef ONEWIRE_TIMEOUT
+		#define ONEWIRE_TIMEOUT 100000UL
+	#endif
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Default number of times a busy device is polled before
+	///	giving up. Each poll is a read slot byte, about 0.7ms, so this 
+	///	covers a 750ms temperature conversion with room to spare. At 
+	///	overdrive speed a poll is about ten times shorter, so 
+	///	OneWireBus_BusyPolls() scales the count up to match.
+	/////////////////////////////////////////////////////////////////////////
+	#ifndef ONEWIRE_BUSY_POLLS
+		#define ONEWIRE_BUSY_POLLS 2000UL
+	#endif
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Default number of extra attempts after a failed transaction
+	/////////////////////////////////////////////////////////////////////////
+	#ifndef ONEWIRE_RETRIES
+		#define ONEWIRE_RETRIES 2
+	#endif
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Default polls to wait before the first retry
+	/////////////////////////////////////////////////////////////////////////
+	#ifndef ONEWIRE_BACKOFF
+		#define ONEWIRE_BACKOFF 1000UL
+	#endif
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Guard the transaction queue. Only needed when 
+	///	OneWireBus_Poll() runs from an interrupt while OneWireBus_Submit()
+	///	is called from the main loop, or the other way round. The pair has
+	///	to nest, because the callback can submit from inside the poll. ie.
+	///	on Cortex-M:
+	///
+	///	\code
+	///	#define ONEWIRE_ENTER_CRITICAL() uint32_t OneWirePrimask = __get_PRIMASK(); __disable_irq()
+	///	#define ONEWIRE_EXIT_CRITICAL() __set_PRIMASK(OneWirePrimask)
+	///	\endcode
+	///
+	///	ONEWIRE_ENTER_CRITICAL() is always the first statement of its block
+	///	so it can declare a variable.
+	/////////////////////////////////////////////////////////////////////////
+	#ifndef ONEWIRE_ENTER_CRITICAL
+		#define ONEWIRE_ENTER_CRITICAL()
+	#endif
+	
+	#ifndef ONEWIRE_EXIT_CRITICAL
+		#define ONEWIRE_EXIT_CRITICAL()
+	#endif
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Longest transaction in bytes, commands included. The 
+	///	engine counts the bytes in 8 bits
+	/////////////////////////////////////////////////////////////////////////
+	#define ONEWIRE_TRANSACTION_MAX_LENGTH 255
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Set to 1 to keep bus statistics and latency histograms in
+	///	OneWireBusType. Needs cyclecounter.c. When 0 the counters and
+	///	the timing code are left out altogether.
+	/////////////////////////////////////////////////////////////////////////
+	#ifndef ONEWIRE_STATS
+		#define ONEWIRE_STATS 0
+	#endif
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Number of log2 bins in each latency histogram
+	/////////////////////////////////////////////////////////////////////////
+	#ifndef ONEWIRE_STATS_BINS
+		#define ONEWIRE_STATS_BINS 24
+	#endif
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	UART baudrate for the overdrive reset. 0xF8 at 57600 baud 
+	///	holds the bus low for 69us and samples the presence pulse 9us 
+	///	after it's released.
+	/////////////////////////////////////////////////////////////////////////
+	#ifndef ONEWIRE_OVERDRIVE_RESET_BAUD
+		#define ONEWIRE_OVERDRIVE_RESET_BAUD 57600UL
+	#endif
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	UART baudrate for the overdrive slots. At 1Mbit a write 1
+	///	is 1us low, a write 0 is 9us low and a slot takes 10us. 921600 
+	///	works too for UARTs that can't do 1Mbit.
+	/////////////////////////////////////////////////////////////////////////
+	#ifndef ONEWIRE_OVERDRIVE_BAUD
+		#define ONEWIRE_OVERDRIVE_BAUD 1000000UL
+	#endif
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Length of the device 64bit ROM code in bytes
+	/////////////////////////////////////////////////////////////////////////
+	#define ONEWIRE_ROM_LENGTH 8
+	
+	////////////////////////////////////////////////////////////////////////////////
+	///	\brief Error codes. Zero is success so the result can still be used
+	///	as a FALSE/TRUE error flag.
+	////////////////////////////////////////////////////////////////////////////////
+	typedef enum{
+		OW_Success = 0,		///< No error
+		OW_Timeout,			///< The UART didn't take the data or the echo never arrived
+		OW_NoPresence,		///< No device answered the reset pulse
+		OW_CRCError			///< The data read back failed its CRC
+	} OneWireErrorEnum;
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Timeout and retry policy. The budgets are counted in polls
+	///	so they don't need a timer.
+	/////////////////////////////////////////////////////////////////////////
+	typedef struct
+	{
+		uint32_t Timeout;				///< Polls to wait for UART space or an echo
+		uint32_t BusyPolls;				///< Times a busy device is polled at standard speed before giving up. See OneWireBus_BusyPolls()
+		uint32_t Backoff;				///< Polls to wait before the first retry. Doubles on each retry
+		uint8_t Retries;				///< Extra attempts after a failed transaction
+		uint8_t ResetBeforeRetry;		///< TRUE to reset the bus on its own before a retry
+	} OneWirePolicyType;
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Device ROM code.
+	///
+	///		format: <BYTE 0> device family code
+	///				<BYTE 1 - 6> Serial Num.
+	///				<BYTE 7> CheckSum.
+	/////////////////////////////////////////////////////////////////////////
+	typedef struct
+	{
+		uint8_t Code[ONEWIRE_ROM_LENGTH];	///< ROM code. Byte 0 goes on the bus first
+	} OneWireRomType;
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Search ROM state. Keep it between calls so the search can
+	///	carry on from the last discrepancy.
+	/////////////////////////////////////////////////////////////////////////
+	typedef struct
+	{
+		OneWireRomType Rom;				///< Last ROM found. Internal use only
+		uint8_t Command;				///< Search or alarm search ROM command
+		uint8_t LastDiscrepancy;		///< Bit where the last search took the 0 branch. Internal use only
+		uint8_t LastFamilyDiscrepancy;	///< Same as LastDiscrepancy but within the family code. Internal use only
+		uint8_t LastDevice;				///< TRUE once the last device was found. Internal use only
+		OneWireRomType Branches;		///< Bits of the last pass where devices answered on both branches
+	} OneWireSearchType;
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Transaction flags. Select which parts of the transaction
+	///	descriptor are sent on the bus.
+	/////////////////////////////////////////////////////////////////////////
+	#define ONEWIRE_TRANSACTION_RESET		0x01	///< Reset the bus first
+	#define ONEWIRE_TRANSACTION_ROM			0x02	///< Send RomCommand (and Rom when it's set)
+	#define ONEWIRE_TRANSACTION_FUNCTION	0x04	///< Send FunctionCommand
+	
+	////////////////////////////////////////////////////////////////////////////////
+	///	\brief Transaction states
+	////////////////////////////////////////////////////////////////////////////////
+	typedef enum{
+		OWT_Idle = 0,		///< Not submitted
+		OWT_Queued,			///< Waiting for the bus
+		OWT_Active,			///< Currently on the bus
+		OWT_Done,			///< Completed with success
+		OWT_Error			///< Completed with an error. ie. no presence pulse or missing echo
+	} OneWireTransactionStateEnum;
+	
+	typedef struct OneWireTransactionStruct OneWireTransactionType;
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Completion callback. Called from OneWire_Poll() once the
+	///	transaction is finished. It's safe to submit from the callback.
+	/////////////////////////////////////////////////////////////////////////
+	typedef void (*OneWireCallbackType)(OneWireTransactionType *transaction);
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Transaction descriptor. The descriptor and its buffers must
+	///	stay valid until the transaction completes.
+	/////////////////////////////////////////////////////////////////////////
+	struct OneWireTransactionStruct
+	{
+		uint8_t Flags;						///< ONEWIRE_TRANSACTION_ flags
+		uint8_t RomCommand;					///< ROM command. ie skip or match ROM
+		const uint8_t *Rom;					///< 8 byte ROM code sent after the ROM command or NULL
+		uint8_t FunctionCommand;			///< Function command
+		const uint8_t *TxData;				///< Data written after the commands
+		uint8_t TxLength;					///< How many bytes to write
+		uint8_t *RxData;					///< Where to store the data read after TxData
+		uint8_t RxLength;					///< How many bytes to read
+		OneWireCallbackType Callback;		///< Called on completion. Can be NULL
+		void *Context;						///< Free for the caller to use
+		const OneWirePolicyType *Policy;	///< Retry policy or NULL for the bus policy
+		volatile OneWireTransactionStateEnum State;	///< Current state. Internal use only
+		uint8_t Error;						///< OneWireErrorEnum reason once the state is OWT_Error
+		uint8_t Attempt;					///< Retries so far. Internal use only
+		OneWireTransactionType *Next;		///< Queue link. Internal use only
+	};
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	UART operations used by a bus. Every call gets the bus 
+	///	UartContext. Write is all-or-nothing and returns TRUE when there
+	///	isn't room, Read returns how many bytes it read.
+	/////////////////////////////////////////////////////////////////////////
+	typedef struct
+	{
+		uint_fast8_t (*Setbaud)(void *context, uint32_t baud);							///< Change the baudrate once the transmit buffer is empty. TRUE on timeout
+		uint_fast8_t (*Write)(void *context, const uint8_t *source, uint_fast8_t length);	///< Queue data, non-blocking
+		uint_fast8_t (*Read)(void *context, uint8_t *destination, uint_fast8_t length);	///< Take received data, non-blocking
+		uint_fast8_t (*WriteSpace)(void *context);										///< Bytes that can be queued
+		uint_fast8_t (*Break)(void *context, uint32_t low, uint32_t idle);				///< Once the transmit buffer is empty hold the line low then idle, both in us. TRUE on timeout. NULL if not supported
+		uint_fast8_t (*WriteComplete)(void *context);									///< TRUE once every queued byte is out and its echo received
+	} OneWireUartOpsType;
+	
+	////////////////////////////////////////////////////////////////////////////////
+	///	\brief How the reset pulse is made
+	////////////////////////////////////////////////////////////////////////////////
+	typedef enum{
+		OWR_Baud = 0,		///< Send 0xF0 at 9600 baud. Works with any UART but changes the baudrate twice per reset
+		OWR_Break			///< Send a break and look for the presence pulse in the echo of a read slot. Stays at 115200 baud, needs the Break operation. The break holds the line for the whole reset, so only the blocking calls use it and the transaction engine keeps to OWR_Baud
+	} OneWireResetEnum;
+	
+	////////////////////////////////////////////////////////////////////////////////
+	///	\brief Bus speeds. Index of the bus timing profile in OneWireTiming
+	////////////////////////////////////////////////////////////////////////////////
+	typedef enum{
+		OWS_Standard = 0,	///< Standard speed. Every device supports it
+		OWS_Overdrive,		///< Overdrive speed. Only devices put in overdrive with OneWireBus_Overdrive() take part
+		OWS_Count			///< Number of timing profiles
+	} OneWireSpeedEnum;
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	How a bus speed maps on to the UART
+	/////////////////////////////////////////////////////////////////////////
+	typedef struct
+	{
+		uint32_t ResetBaud;					///< Baudrate for the reset pulse
+		uint32_t SlotBaud;					///< Baudrate for the read and write slots
+		uint8_t ResetData;					///< Character that makes the reset pulse. The echo is unchanged when nothing answered
+		uint8_t BusyPollScale;				///< Polls that take as long as one at standard speed. Scales the policy BusyPolls
+	} OneWireTimingType;
+	
+#if ONEWIRE_STATS
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Bus statistics. Counts since OneWireBus_Init() or
+	///	OneWireBus_StatsReset(). The latency histograms are counted in
+	///	CycleCounter_Read() ticks, bin n holds the times from 2^n up to
+	///	2^(n+1) - 1 and the last bin everything longer.
+	/////////////////////////////////////////////////////////////////////////
+	typedef struct
+	{
+		uint32_t Slots;						///< Read and write slots sent
+		uint32_t Bytes;						///< Bytes transferred
+		uint32_t Resets;					///< Reset pulses sent
+		uint32_t PresenceFailures;			///< Resets without a presence pulse
+		uint32_t CRCFailures;				///< Data that failed its CRC
+		uint32_t Timeouts;					///< Waits that ran out of budget
+		uint32_t Retries;					///< Transactions tried again
+		uint32_t BaudSwitches;				///< UART baudrate changes
+		uint32_t SpeedFallbacks;			///< Times the bus went back to standard speed because nothing answered an overdrive reset
+		uint32_t TransactionLatency[ONEWIRE_STATS_BINS];	///< Transaction engine, first start to completion
+		uint32_t BlockLatency[ONEWIRE_STATS_BINS];			///< Blocking block reads and writes
+	} OneWireStatsType;
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Count a bus event. Compiles to nothing without ONEWIRE_STATS.
+	/////////////////////////////////////////////////////////////////////////
+	#define ONEWIRE_STATS_ADD(bus, field, count) ((bus)->Stats.field += (count))
+#else
+	#define ONEWIRE_STATS_ADD(bus, field, count) ((void)0)
+#endif
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	One 1-Wire bus. Each bus has its own UART and transaction
+	///	queue so several can run at the same time. Set it up with 
+	///	OneWireBus_Init().
+	/////////////////////////////////////////////////////////////////////////
+	typedef struct
+	{
+		const OneWireUartOpsType *Uart;		///< UART operations
+		void *UartContext;					///< Passed to the UART operations
+		uint32_t Baud;						///< Current UART baudrate. 0 forces the next change
+		uint8_t ResetMode;					///< OneWireResetEnum. OWR_Baud after OneWireBus_Init()
+		uint8_t Speed;						///< OneWireSpeedEnum. Set by OneWireBus_Overdrive() and back to OWS_Standard when nothing answers an overdrive reset
+		OneWirePolicyType Policy;			///< Timeout and retry policy. Set to the defaults by OneWireBus_Init()
+		uint32_t ResetCount;				///< Resets put on the bus, wraps. Lets a device driver tell if the bus was used since its last command
+	#if ONEWIRE_STATS
+		OneWireStatsType Stats;				///< Bus statistics
+		uint32_t EngineStart;				///< Cycle count when the active transaction started. Internal use only
+	#endif
+		OneWireTransactionType *TransactionHead;	///< Transaction on the bus. Internal use only
+		OneWireTransactionType *TransactionTail;	///< Last queued transaction. Internal use only
+		uint8_t EnginePosition;				///< Position of the byte on the bus. Internal use only
+		uint8_t EngineLength;				///< Bytes in the active transaction. Internal use only
+		uint8_t EngineBit;					///< Slot waiting for its echo. Internal use only
+		uint8_t EngineData;					///< Bits collected for the current byte. Internal use only
+		uint8_t EngineResetting;			///< TRUE while the reset pulse is on the bus. Internal use only
+		uint8_t EngineForceReset;			///< TRUE to reset before the retry. Internal use only
+		uint32_t EngineWait;				///< Polls spent waiting for the echo or for the UART to finish sending. Internal use only
+		uint32_t EngineBackoff;				///< Polls left before the retry starts. Internal use only
+	} OneWireBusType;
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	UART operations for the uart.c ports. Pass the UartPortType
+	///	as the context.
+	/////////////////////////////////////////////////////////////////////////
+	extern const OneWireUartOpsType OneWireUartPortOps;
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Timing profile of each OneWireSpeedEnum
+	/////////////////////////////////////////////////////////////////////////
+	extern const OneWireTimingType OneWireTiming[OWS_Count];
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	The bus behind the OneWire_* calls. Set up by OneWire_Init()
+	///	on the uart.c default port.
+	/////////////////////////////////////////////////////////////////////////
+	extern OneWireBusType OneWireDefaultBus;
+	
+	void OneWireBus_Init(OneWireBusType *bus, const OneWireUartOpsType *uart, void *context);
+	uint8_t OneWireBus_Reset(OneWireBusType *bus);
+	int_fast8_t OneWireBus_Write(OneWireBusType *bus, const uint8_t source);
+	int_fast8_t OneWireBus_Read(OneWireBusType *bus, uint8_t *data);
+	int_fast8_t OneWireBus_WriteBlock(OneWireBusType *bus, const uint8_t *source, uint8_t length);
+	int_fast8_t OneWireBus_ReadBlock(OneWireBusType *bus, uint8_t *destination, uint8_t length);
+	int_fast8_t OneWireBus_ReadBlockCRC(OneWireBusType *bus, uint8_t *destination, uint8_t length, uint8_t *crc);
+	int_fast8_t OneWireBus_WriteBit(OneWireBusType *bus, const uint8_t source);
+	int_fast8_t OneWireBus_ReadBit(OneWireBusType *bus, uint8_t *data);
+	int_fast8_t OneWireBus_SearchNext(OneWireBusType *bus, OneWireSearchType *search, OneWireRomType *rom);
+	uint8_t OneWireBus_SearchRom(OneWireBusType *bus, OneWireSearchType *search, OneWireRomType *table, uint8_t tableSize);
+	int_fast8_t OneWireBus_Verify(OneWireBusType *bus, const OneWireRomType *rom, uint8_t command, OneWireRomType *branches);
+	int_fast8_t OneWireBus_Overdrive(OneWireBusType *bus, const OneWireRomType *rom);
+	uint_fast8_t OneWireBus_Submit(OneWireBusType *bus, OneWireTransactionType *transaction);
+	void OneWireBus_Poll(OneWireBusType *bus);
+	uint_fast8_t OneWireBus_Busy(OneWireBusType *bus);
+	uint_fast8_t OneWireBus_Retry(OneWireBusType *bus, uint8_t *attempt);
+	uint32_t OneWireBus_BusyPolls(const OneWireBusType *bus);
+#if ONEWIRE_STATS
+	void OneWireBus_StatsReset(OneWireBusType *bus);
+#endif
+	
 	void OneWire_Init(void);
 	uint8_t OneWire_Reset(void);
 	int_fast8_t OneWire_Write(const uint8_t inputData);
 	int_fast8_t OneWire_Read(uint8_t *data);
+	int_fast8_t OneWire_WriteBlock(const uint8_t *source, uint8_t length);
+	int_fast8_t OneWire_ReadBlock(uint8_t *destination, uint8_t length);
+	int_fast8_t OneWire_ReadBlockCRC(uint8_t *destination, uint8_t length, uint8_t *crc);
+	int_fast8_t OneWire_WriteBit(const uint8_t source);
+	int_fast8_t OneWire_ReadBit(uint8_t *data);
+	void OneWire_SearchInit(OneWireSearchType *search, uint8_t command);
+	int_fast8_t OneWire_SearchNext(OneWireSearchType *search, OneWireRomType *rom);
+	uint8_t OneWire_SearchRom(OneWireSearchType *search, OneWireRomType *table, uint8_t tableSize);
+	int_fast8_t OneWire_Verify(const OneWireRomType *rom, uint8_t command);
+	int_fast8_t OneWire_Overdrive(const OneWireRomType *rom);
+	uint_fast8_t OneWire_Submit(OneWireTransactionType *transaction);
+	void OneWire_Poll(void);
+	uint_fast8_t OneWire_Busy(void);
 	uint8_t OneWire_CalculateCRC(uint8_t * source, uint8_t length);
+	uint8_t OneWire_CRCInit(void);
+	uint8_t OneWire_CRCUpdate(uint8_t crc, const uint8_t data);
+	uint8_t OneWire_CRCFinal(uint8_t crc);
 
 #endif
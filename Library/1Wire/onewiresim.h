@@ -0,0 +1,125 @@
+////////////////////////////////////////////////////////////////////////////////
+/// \file	onewiresim.h
+///	\brief host side simulation of a 1 wire bus with DS18S20/DS18B20
+///			sensors. Lets the 1 wire and temperature layers run, and be
+///			timed, on a PC.
+///
+///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
+///	Website: www.HashDefineElectronics.com
+///
+///	Licences:
+///
+///		Copyright (c) 2014 Ronald Alexander Nobrega De Sousa
+///
+///		Permission is hereby granted, free of charge, to any person obtaining a copy
+///		of this software and associated documentation files (the "Software"), to deal
+///		in the Software without restriction, including without limitation the rights
+///		to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+///		copies of the Software, and to permit persons to whom the Software is
+///		furnished to do so, subject to the following conditions:
+///
+///		The above copyright notice and this permission notice shall be included in
+///		all copies or substantial portions of the Software.
+///	
+///		THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///		IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///		FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///		AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///		LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///		THE SOFTWARE.
+///
+///
+///	Simulated Bus Code Example:
+///	\code
+///	#include "onewiresim.h"
+///	#include "temperature.h"
+///
+///	// build with -DONEWIRE_SIMULATION so uart.c talks to OneWireSimBus
+///	void main(void)
+///	{
+///		OneWireSimDeviceType Sensor;
+///		float Temperature;
+///
+///		OneWireSim_Init(&OneWireSimBus);
+///		OneWireSim_DeviceInit(&Sensor, 0x10, 0x1234);
+///		OneWireSim_SetTemperature(&Sensor, 21.5f);
+///		OneWireSim_Attach(&OneWireSimBus, &Sensor);
+///
+///		Temperature_Init();
+///		Temperature_BlockingRead(&Temperature);
+///
+///		printf("%0.4f after %luus\r\n", Temperature, OneWireSim_Time(&OneWireSimBus));
+///	}
+///	\endcode
+////////////////////////////////////////////////////////////////////////////////
+#ifndef __ONE_WIRE_SIMULATION_H__
+#define __ONE_WIRE_SIMULATION_H__
+	#include <stdint.h>
+	#include "onewire.h"
+
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Number of bytes in the simulated scratch pad
+	/////////////////////////////////////////////////////////////////////////
+	#define ONEWIRESIM_SCRATCHPAD_LENGTH 9
+
+	typedef struct OneWireSimDeviceStruct OneWireSimDeviceType;
+
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Simulated temperature sensor. Use OneWireSim_DeviceInit()
+	///	to set it up.
+	/////////////////////////////////////////////////////////////////////////
+	struct OneWireSimDeviceStruct
+	{
+		OneWireRomType Rom;					///< Device ROM code
+		float Temperature;					///< Temperature the next conversion will read
+		uint8_t Scratchpad[ONEWIRESIM_SCRATCHPAD_LENGTH];	///< Device scratch pad
+		uint8_t Eeprom[3];					///< TH, TL and configuration kept in EEPROM
+		uint8_t Alarm;						///< TRUE if the last conversion was out of the TH/TL range
+		uint8_t OverdriveSupport;			///< TRUE if the device takes the overdrive ROM commands. FALSE after OneWireSim_DeviceInit()
+		uint8_t Overdrive;					///< TRUE while the device is at overdrive speed
+		uint8_t Converting;					///< TRUE while a conversion is in progress
+		uint32_t ConvertionEnd;				///< Bus time in us when the conversion finishes
+		uint8_t State;						///< Protocol state. Internal use only
+		uint8_t NextState;					///< State once the data has been sent. Internal use only
+		uint8_t Data;						///< Receive shift register. Internal use only
+		uint8_t BitCount;					///< Bits sent or received. Internal use only
+		uint8_t SearchStep;					///< Search triplet step. Internal use only
+		const uint8_t *SendData;			///< Data being sent. Internal use only
+		uint8_t SendLength;					///< Bytes to send. Internal use only
+		OneWireSimDeviceType *Next;			///< Next device on the bus. Internal use only
+	};
+
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Simulated bus. The bus time only moves on when data is sent
+	///	or OneWireSim_Delay() is called.
+	/////////////////////////////////////////////////////////////////////////
+	typedef struct
+	{
+		OneWireSimDeviceType *Devices;		///< Devices attached to the bus
+		uint32_t Baud;						///< Current UART baudrate
+		uint32_t BaudChanges;				///< How many times the UART baudrate was programmed
+		uint64_t TimeNs;					///< Bus time in ns
+		uint64_t PresenceStartNs;			///< Start of the presence pulse after a break. Internal use only
+		uint64_t PresenceEndNs;				///< End of the presence pulse after a break. Internal use only
+		uint32_t EchoPolls;					///< UART polls each character takes to go out, so the echoes arrive late like on a real UART. 0 echoes straight away
+		uint32_t EchoWait;					///< Polls the character on the line has taken so far. Internal use only
+	} OneWireSimType;
+
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	The bus uart.c talks to when ONEWIRE_SIMULATION is defined
+	/////////////////////////////////////////////////////////////////////////
+	extern OneWireSimType OneWireSimBus;
+
+	void OneWireSim_Init(OneWireSimType *sim);
+	void OneWireSim_DeviceInit(OneWireSimDeviceType *device, uint8_t family, uint32_t serial);
+	void OneWireSim_SetTemperature(OneWireSimDeviceType *device, float temperature);
+	void OneWireSim_Attach(OneWireSimType *sim, OneWireSimDeviceType *device);
+	void OneWireSim_Detach(OneWireSimType *sim, OneWireSimDeviceType *device);
+	void OneWireSim_SetBaud(OneWireSimType *sim, uint32_t baud);
+	void OneWireSim_Break(OneWireSimType *sim, uint32_t low, uint32_t idle);
+	uint8_t OneWireSim_Transfer(OneWireSimType *sim, uint8_t data);
+	void OneWireSim_Delay(OneWireSimType *sim, uint32_t us);
+	uint32_t OneWireSim_Time(const OneWireSimType *sim);
+
+#endif
@@ -0,0 +1,212 @@
+/////////////////////////////////////////////////////////////////////////
+///	\file	convertbench.c
+///	\brief simulated bus check of the non-blocking conversion with other
+///	traffic on the bus.
+///
+///	\section ConvertBenchmark Conversion check
+///
+///	Two DS18B20 share the simulated bus. One is converted and read with
+///	Temperature_RequestConvertion() and Temperature_NonBlockingReadAll(),
+///	sleeping Temperature_ConvertionWait() between the polls, while the
+///	other one is read in between:
+///
+///	- alone: nothing else uses the bus, the read slot tells when it's done
+///	- early: the other sensor is read straight after the request
+///	- polling: the other sensor is read after the first busy poll
+///	- all: both get a new temperature and are read with
+///	  Temperature_BlockingReadAll()
+///
+///	Once the other sensor has been read the read slot reads done whether
+///	the conversion is or not. Every round must still read the new
+///	temperature and take at least the full 750ms.
+///
+///	\code
+///	cd "Library/DS18S20 Temperature/Test"
+///	gcc -std=c99 -O2 -DONEWIRE_SIMULATION -I.. convertbench.c ../temperature.c ../onewire.c ../uart.c ../onewiresim.c ../cyclecounter.c -o convertbench && ./convertbench
+///	\endcode
+///
+///
+///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
+///	Website: www.HashDefineElectronics.com
+///
+///	Licences:
+///
+///		Copyright (c) 2014 Ronald Alexander Nobrega De Sousa
+///
+///		Permission is hereby granted, free of charge, to any person obtaining a copy
+///		of this software and associated documentation files (the "Software"), to deal
+///		in the Software without restriction, including without limitation the rights
+///		to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+///		copies of the Software, and to permit persons to whom the Software is
+///		furnished to do so, subject to the following conditions:
+///
+///		The above copyright notice and this permission notice shall be included in
+///		all copies or substantial portions of the Software.
+///
+///		THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///		IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///		FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///		AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///		LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///		THE SOFTWARE.
+/////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdint.h>
+#include "common.h"
+#include "temperature.h"
+#include "onewiresim.h"
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Conversions run in each mode
+/////////////////////////////////////////////////////////////////////////
+#define CONVERTBENCH_ROUNDS 50UL
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Full conversion time of the 12 bit sensors in us
+/////////////////////////////////////////////////////////////////////////
+#define CONVERTBENCH_FULL_US 750000UL
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	When the other sensor is read
+/////////////////////////////////////////////////////////////////////////
+typedef enum{
+	CB_Alone = 0,		///< Never, only the read slot polls use the bus
+	CB_Early,			///< Straight after the conversion request
+	CB_Polling,			///< After the first busy poll
+	CB_All				///< Never, both are read with Temperature_BlockingReadAll()
+} ConvertBenchModeEnum;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Sleep until the conversion is worth polling again
+/////////////////////////////////////////////////////////////////////////
+static void ConvertBench_Sleep(void)
+{
+	uint32_t Wait = Temperature_ConvertionWait();
+
+	OneWireSim_Delay(&OneWireSimBus, Wait ? (Wait * 1000UL) : 1000UL);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Run one mode and print the results. Each round converts a
+///	new temperature, so a reading taken before the conversion finished
+///	is the last round's one and doesn't match.
+///
+///	\param name the mode
+///	\param mode ConvertBenchModeEnum
+///	\param sensor the sensor that is read once converted
+///	\param other the sensor that shares the bus
+///	\return the number of failed rounds
+/////////////////////////////////////////////////////////////////////////
+static uint32_t ConvertBench_Run(const char *name, uint8_t mode, OneWireSimDeviceType *sensor, OneWireSimDeviceType *other)
+{
+	TemperatureRespoceEnum ReturnState;
+	OneWireRomType Table[2];
+	TemperatureRespoceEnum Results[2];
+	float Temperatures[2];
+	float Expected;
+	float Temperature;
+	float Other;
+	uint32_t Errors = 0;
+	uint32_t Round;
+	uint32_t Start;
+	uint32_t Elapsed;
+	uint32_t Longest = 0;
+	uint32_t Shortest = UINT32_MAX;
+	uint8_t Busy;
+
+	for(Round = 0; Round < CONVERTBENCH_ROUNDS; Round++)
+	{
+		Expected = 20.0f + (float)Round * 0.0625f;
+		OneWireSim_SetTemperature(sensor, Expected);
+
+		// The blocking read requests the conversion itself
+		if(CB_All == mode)
+		{
+			Start = OneWireSim_Time(&OneWireSimBus);
+			OneWireSim_SetTemperature(other, -Expected);
+			Table[0] = sensor->Rom;
+			Table[1] = other->Rom;
+
+			ReturnState = Temperature_BlockingReadAll(Table, 2, Temperatures, Results);
+			Elapsed = OneWireSim_Time(&OneWireSimBus) - Start;
+			Longest = (Elapsed > Longest) ? Elapsed : Longest;
+			Shortest = (Elapsed < Shortest) ? Elapsed : Shortest;
+
+			if((TMP_Success != ReturnState) || Results[0] || Results[1] || (Temperatures[0] != Expected) || (Temperatures[1] != -Expected) || (Elapsed < CONVERTBENCH_FULL_US))
+			{
+				Errors++;
+			}
+
+			continue;
+		}
+
+		if(Temperature_RequestConvertion())
+		{
+			Errors++;
+			continue;
+		}
+
+		Start = OneWireSim_Time(&OneWireSimBus);
+		Busy = 0;
+
+		if(CB_Early == mode)
+		{
+			Errors += (TMP_Success != Temperature_ReadDevice(&other->Rom, &Other));
+		}
+
+		for( ;; )
+		{
+			ReturnState = Temperature_NonBlockingReadAll(&sensor->Rom, 1, &Temperature, 0);
+
+			if(TMP_Busy != ReturnState)
+			{
+				break;
+			}
+
+			// The sensor has been polled once, now the other one uses the bus
+			if((CB_Polling == mode) && !Busy++)
+			{
+				Errors += (TMP_Success != Temperature_ReadDevice(&other->Rom, &Other));
+			}
+
+			ConvertBench_Sleep();
+		}
+
+		Elapsed = OneWireSim_Time(&OneWireSimBus) - Start;
+		Longest = (Elapsed > Longest) ? Elapsed : Longest;
+		Shortest = (Elapsed < Shortest) ? Elapsed : Shortest;
+
+		if((TMP_Success != ReturnState) || (Temperature != Expected) || (Elapsed < CONVERTBENCH_FULL_US))
+		{
+			Errors++;
+		}
+	}
+
+	printf("%-8s done after %7.1f to %7.1fms  %s\n", name, Shortest / 1000.0, Longest / 1000.0, Errors ? "FAIL" : "ok");
+
+	return Errors;
+}
+
+int main(void)
+{
+	OneWireSimDeviceType Sensor;
+	OneWireSimDeviceType Other;
+	uint32_t Errors = 0;
+
+	OneWireSim_Init(&OneWireSimBus);
+	OneWireSim_DeviceInit(&Sensor, TMP_FAMILY_DS18B20, 0x1234);
+	OneWireSim_DeviceInit(&Other, TMP_FAMILY_DS18B20, 0x5678);
+	OneWireSim_SetTemperature(&Other, -10.0f);
+	OneWireSim_Attach(&OneWireSimBus, &Sensor);
+	OneWireSim_Attach(&OneWireSimBus, &Other);
+
+	Temperature_Init();
+
+	Errors += ConvertBench_Run("alone", CB_Alone, &Sensor, &Other);
+	Errors += ConvertBench_Run("early", CB_Early, &Sensor, &Other);
+	Errors += ConvertBench_Run("polling", CB_Polling, &Sensor, &Other);
+	Errors += ConvertBench_Run("all", CB_All, &Sensor, &Other);
+
+	return Errors ? 1 : 0;
+}
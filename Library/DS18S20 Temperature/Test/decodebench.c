@@ -0,0 +1,237 @@
+/////////////////////////////////////////////////////////////////////////
+///	\file	decodebench.c
+///	\brief host check and benchmark of the fixed point temperature
+///	decode.
+///
+///	\section DecodeBenchmark Decode benchmark
+///
+///	Runs Temperature_DecodeFixed() and Temperature_Decode() over the
+///	scratch pad bytes they read and compares the fixed point result with
+///	the float one times 256, saturated to int16_t:
+///
+///	- DS18B20 and DS1822: every temperature register at every
+///	  resolution. Must match exactly.
+///	- DS18S20 with the 16 counts per degree it really has: every
+///	  temperature register, sign and count remain. Must match exactly.
+///	- DS18S20 with any other count per degree: must be within 1/256
+///	  degree, the float rounding can land either side of a half.
+///	- DS18S20 with an unusable count remain: must give the 1/2 degree
+///	  reading, the float decode has nothing sensible to compare with.
+///
+///	Then it times both decodes on a DS18S20 scratch pad.
+///
+///	\code
+///	cd "Library/DS18S20 Temperature/Test"
+///	gcc -std=c99 -O2 -I.. decodebench.c ../temperature.c ../onewire.c ../uart.c ../cyclecounter.c -o decodebench && ./decodebench
+///	\endcode
+///
+///	A count is one ns on the host and one CPU clock on Cortex-M, see
+///	cyclecounter.c.
+///
+///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
+///	Website: www.HashDefineElectronics.com
+///
+///	Licences:
+///
+///		Copyright (c) 2014 Ronald Alexander Nobrega De Sousa
+///
+///		Permission is hereby granted, free of charge, to any person obtaining a copy
+///		of this software and associated documentation files (the "Software"), to deal
+///		in the Software without restriction, including without limitation the rights
+///		to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+///		copies of the Software, and to permit persons to whom the Software is
+///		furnished to do so, subject to the following conditions:
+///
+///		The above copyright notice and this permission notice shall be included in
+///		all copies or substantial portions of the Software.
+///
+///		THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///		IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///		FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///		AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///		LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///		THE SOFTWARE.
+/////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdint.h>
+#include "common.h"
+#include "temperature.h"
+#include "cyclecounter.h"
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	How many times each decode is timed
+/////////////////////////////////////////////////////////////////////////
+#define DECODEBENCH_ROUNDS 1000000UL
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Counts per degree of a real DS18S20
+/////////////////////////////////////////////////////////////////////////
+#define DECODEBENCH_COUNT_PER_C 16
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Keep the compiler from dropping the timed loops
+/////////////////////////////////////////////////////////////////////////
+static volatile int16_t DecodeBenchFixedSink;
+static volatile float DecodeBenchFloatSink;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	The float decode in 1/256 degree, rounded half away from
+///	zero and saturated like Temperature_DecodeFixed()
+/////////////////////////////////////////////////////////////////////////
+static int32_t DecodeBench_Expected(uint8_t family, const uint8_t *scratchpad)
+{
+	float Scaled = Temperature_Decode(family, scratchpad) * (1 << TMP_FIXED_SHIFT);
+
+	if(Scaled >= INT16_MAX)
+	{
+		return INT16_MAX;
+	}
+
+	if(Scaled <= INT16_MIN)
+	{
+		return INT16_MIN;
+	}
+
+	return (int32_t)(Scaled + ((Scaled < 0) ? -0.5f : 0.5f));
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Compare one scratch pad and count the mismatches
+///
+///	\param family the sensor family code
+///	\param scratchpad the scratch pad
+///	\param tolerance largest difference allowed in 1/256 degree
+///	\param errors the mismatch count to update
+/////////////////////////////////////////////////////////////////////////
+static void DecodeBench_Check(uint8_t family, const uint8_t *scratchpad, int32_t tolerance, uint32_t *errors)
+{
+	int32_t Difference = Temperature_DecodeFixed(family, scratchpad) - DecodeBench_Expected(family, scratchpad);
+
+	if((Difference > tolerance) || (Difference < -tolerance))
+	{
+		if(*errors < 10)
+		{
+			printf("family 0x%02X scratch pad %02X %02X %02X %02X %02X: fixed %d, float %ld\n",
+				family, scratchpad[0], scratchpad[1], scratchpad[4], scratchpad[6], scratchpad[7],
+				Temperature_DecodeFixed(family, scratchpad), (long)DecodeBench_Expected(family, scratchpad));
+		}
+
+		(*errors)++;
+	}
+}
+
+int main(void)
+{
+	static const uint8_t Families[] = {TMP_FAMILY_DS18B20, TMP_FAMILY_DS1822};
+	uint8_t Scratchpad[TMP_SCRATCHPAD_LENGTH] = {0};
+	uint32_t Errors = 0;
+	uint32_t Checked = 0;
+	uint32_t Start;
+	uint32_t FixedElapsed;
+	uint32_t FloatElapsed;
+	uint32_t Round;
+	uint16_t Register;
+	uint16_t CountPerC;
+	uint16_t CountRemain;
+	uint8_t Family;
+	uint8_t Resolution;
+	uint8_t Negative;
+	int16_t HalfDegree;
+
+	// DS18B20 class. Exact at every resolution
+	for(Family = 0; Family < sizeof(Families); Family++)
+	{
+		for(Resolution = 0; Resolution < 4; Resolution++)
+		{
+			Scratchpad[4] = (uint8_t)((Resolution << 5) | 0x1F);
+
+			for(Register = 0; Register < 0x100; Register++)
+			{
+				Scratchpad[0] = (uint8_t)Register;
+				Scratchpad[1] = 0;
+
+				do
+				{
+					DecodeBench_Check(Families[Family], Scratchpad, 0, &Errors);
+					Checked++;
+				}
+				while(++Scratchpad[1]);
+			}
+		}
+	}
+
+	// DS18S20. The sign byte is 0x00 or 0xFF
+	Scratchpad[4] = 0xFF;
+
+	for(Register = 0; Register < 0x100; Register++)
+	{
+		for(Negative = 0; Negative < 2; Negative++)
+		{
+			Scratchpad[0] = (uint8_t)Register;
+			Scratchpad[1] = Negative ? 0xFF : 0x00;
+
+			for(CountPerC = 0; CountPerC < 0x100; CountPerC++)
+			{
+				Scratchpad[7] = (uint8_t)CountPerC;
+
+				for(CountRemain = 0; CountRemain < 0x100; CountRemain++)
+				{
+					Scratchpad[6] = (uint8_t)CountRemain;
+					Checked++;
+
+					if(!CountPerC || (CountRemain > CountPerC))
+					{
+						// No count remain to use, the 1/2 degree reading
+						HalfDegree = (int16_t)(((uint16_t)Scratchpad[1] << 8) | Scratchpad[0]);
+
+						if(Temperature_DecodeFixed(TMP_FAMILY_DS18S20, Scratchpad) != HalfDegree * 128)
+						{
+							Errors++;
+						}
+
+						continue;
+					}
+
+					DecodeBench_Check(TMP_FAMILY_DS18S20, Scratchpad, (DECODEBENCH_COUNT_PER_C == CountPerC) ? 0 : 1, &Errors);
+				}
+			}
+		}
+	}
+
+	// 25.5625 degree C on a DS18S20
+	Scratchpad[0] = 0x33;
+	Scratchpad[1] = 0x00;
+	Scratchpad[6] = 0x05;
+	Scratchpad[7] = DECODEBENCH_COUNT_PER_C;
+
+	CycleCounter_Init();
+
+	Start = CycleCounter_Read();
+
+	for(Round = 0; Round < DECODEBENCH_ROUNDS; Round++)
+	{
+		Scratchpad[6] = (uint8_t)(Round & 0x0F);
+		DecodeBenchFixedSink = Temperature_DecodeFixed(TMP_FAMILY_DS18S20, Scratchpad);
+	}
+
+	FixedElapsed = CycleCounter_Read() - Start;
+
+	Start = CycleCounter_Read();
+
+	for(Round = 0; Round < DECODEBENCH_ROUNDS; Round++)
+	{
+		Scratchpad[6] = (uint8_t)(Round & 0x0F);
+		DecodeBenchFloatSink = Temperature_Decode(TMP_FAMILY_DS18S20, Scratchpad);
+	}
+
+	FloatElapsed = CycleCounter_Read() - Start;
+
+	printf("%lu scratch pads checked, %lu mismatches\n", (unsigned long)Checked, (unsigned long)Errors);
+	printf("fixed %6.2f counts/decode  float %6.2f counts/decode  %s\n",
+		(double)FixedElapsed / (double)DECODEBENCH_ROUNDS,
+		(double)FloatElapsed / (double)DECODEBENCH_ROUNDS,
+		Errors ? "FAIL" : "ok");
+
+	return Errors ? 1 : 0;
+}
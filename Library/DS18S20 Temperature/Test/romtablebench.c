@@ -0,0 +1,333 @@
+/////////////////////////////////////////////////////////////////////////
+///	\file	romtablebench.c
+///	\brief simulated bus check of the saved ROM table warm start.
+///
+///	\section RomTableBenchmark ROM table check
+///
+///	Puts a random set of sensors on the simulated bus, starts the table
+///	with RomTableBus_Start() so the bus is searched and saved, then
+///	restarts it after one of:
+///
+///	- same: nothing changed, the saved table must be used
+///	- reloaded: a sensor went back to its EEPROM thresholds, the saved
+///	  table must be used and put the table thresholds back
+///	- added: one more sensor, the bus must be searched
+///	- removed: one sensor less, the bus must be searched
+///
+///	Either way the table must end up with exactly the sensors on the bus.
+///	Half the sensors are a one bit change of another one so the added
+///	sensor is often only told apart deep in the ROM code.
+///
+///	\code
+///	cd "Library/DS18S20 Temperature/Test"
+///	gcc -std=c99 -O2 -DONEWIRE_SIMULATION -I.. romtablebench.c ../romtable.c ../temperature.c ../onewire.c ../uart.c ../onewiresim.c ../cyclecounter.c -o romtablebench && ./romtablebench
+///	\endcode
+///
+///
+///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
+///	Website: www.HashDefineElectronics.com
+///
+///	Licences:
+///
+///		Copyright (c) 2014 Ronald Alexander Nobrega De Sousa
+///
+///		Permission is hereby granted, free of charge, to any person obtaining a copy
+///		of this software and associated documentation files (the "Software"), to deal
+///		in the Software without restriction, including without limitation the rights
+///		to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+///		copies of the Software, and to permit persons to whom the Software is
+///		furnished to do so, subject to the following conditions:
+///
+///		The above copyright notice and this permission notice shall be included in
+///		all copies or substantial portions of the Software.
+///
+///		THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///		IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///		FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///		AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///		LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///		THE SOFTWARE.
+/////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "common.h"
+#include "romtable.h"
+#include "onewiresim.h"
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Random buses tried
+/////////////////////////////////////////////////////////////////////////
+#define ROMTABLEBENCH_ROUNDS 300UL
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Most sensors on a bus, one more can be added
+/////////////////////////////////////////////////////////////////////////
+#define ROMTABLEBENCH_SENSORS 8
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	What happens to the bus between the two restarts
+/////////////////////////////////////////////////////////////////////////
+typedef enum{
+	RTB_Same = 0,		///< Nothing, the saved table must be used
+	RTB_Reloaded,		///< A sensor reloads its power up configuration, the saved table must put it back
+	RTB_Added,			///< A sensor is added, the bus must be searched
+	RTB_Removed,		///< A sensor is taken off, the bus must be searched
+	RTB_Count
+} RomTableBenchChangeEnum;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	RAM storage for the saved table
+/////////////////////////////////////////////////////////////////////////
+typedef struct
+{
+	uint8_t Data[ROMTABLE_MAX_LENGTH];	///< Saved bytes
+	uint_fast16_t Length;				///< How many are saved, 0 for none
+} RomTableBenchStorageType;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	xorshift state, fixed seed so a failure can be repeated
+/////////////////////////////////////////////////////////////////////////
+static uint32_t RomTableBenchSeed = 0x2545F491UL;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Random number
+/////////////////////////////////////////////////////////////////////////
+static uint32_t RomTableBench_Random(void)
+{
+	RomTableBenchSeed ^= RomTableBenchSeed << 13;
+	RomTableBenchSeed ^= RomTableBenchSeed >> 17;
+	RomTableBenchSeed ^= RomTableBenchSeed << 5;
+
+	return RomTableBenchSeed;
+}
+
+static uint_fast16_t RomTableBench_Load(void *context, uint8_t *destination, uint_fast16_t length)
+{
+	RomTableBenchStorageType *Storage = (RomTableBenchStorageType *)context;
+
+	if(Storage->Length < length)
+	{
+		length = Storage->Length;
+	}
+
+	memcpy(destination, Storage->Data, length);
+
+	return length;
+}
+
+static uint_fast8_t RomTableBench_Save(void *context, const uint8_t *source, uint_fast16_t length)
+{
+	RomTableBenchStorageType *Storage = (RomTableBenchStorageType *)context;
+
+	if(length > sizeof(Storage->Data))
+	{
+		return TRUE;
+	}
+
+	memcpy(Storage->Data, source, length);
+	Storage->Length = length;
+
+	return FALSE;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Storage operations for RomTableBenchStorageType
+/////////////////////////////////////////////////////////////////////////
+static const RomTableStorageOpsType RomTableBenchOps =
+{
+	RomTableBench_Load,
+	RomTableBench_Save
+};
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Set up a random sensor. Half of them are a one bit change of
+///	another so their search paths split deep in the ROM code.
+/////////////////////////////////////////////////////////////////////////
+static void RomTableBench_Sensor(OneWireSimDeviceType *sensors, uint8_t index)
+{
+	static const uint8_t Families[] = {TMP_FAMILY_DS18S20, TMP_FAMILY_DS1822, TMP_FAMILY_DS18B20};
+	uint32_t Serial = RomTableBench_Random();
+	uint8_t Family = Families[RomTableBench_Random() % 3];
+	const OneWireSimDeviceType *Other;
+
+	if(index && (RomTableBench_Random() & 1))
+	{
+		Other = &sensors[RomTableBench_Random() % index];
+		Family = Other->Rom.Code[0];
+		Serial = ((uint32_t)Other->Rom.Code[4] << 24) | ((uint32_t)Other->Rom.Code[3] << 16) | ((uint32_t)Other->Rom.Code[2] << 8) | Other->Rom.Code[1];
+		Serial ^= 1UL << (RomTableBench_Random() % 32);
+	}
+
+	OneWireSim_DeviceInit(&sensors[index], Family, Serial);
+
+	// Two with the same ROM code are one sensor to the search
+	for(Other = sensors; Other < &sensors[index]; Other++)
+	{
+		if(!memcmp(&Other->Rom, &sensors[index].Rom, sizeof(OneWireRomType)))
+		{
+			RomTableBench_Sensor(sensors, index);
+			break;
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Find a sensor in the table
+///	\return its index or the table count if it isn't there
+/////////////////////////////////////////////////////////////////////////
+static uint8_t RomTableBench_Find(const RomTableType *table, const OneWireRomType *rom)
+{
+	uint8_t Index;
+
+	for(Index = 0; Index < table->Count; Index++)
+	{
+		if(!memcmp(rom, &table->Device[Index].Rom, sizeof(OneWireRomType)))
+		{
+			break;
+		}
+	}
+
+	return Index;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Check the table has exactly the sensors on the bus
+/////////////////////////////////////////////////////////////////////////
+static uint_fast8_t RomTableBench_Match(const RomTableType *table)
+{
+	const OneWireSimDeviceType *Device;
+	uint8_t Count = 0;
+
+	for(Device = OneWireSimBus.Devices; Device; Device = Device->Next)
+	{
+		if(RomTableBench_Find(table, &Device->Rom) == table->Count)
+		{
+			return FALSE;
+		}
+
+		Count++;
+	}
+
+	return (Count == table->Count);
+}
+
+int main(void)
+{
+	static const RomTableStartEnum Expected[RTB_Count] = {RT_Verified, RT_Verified, RT_Searched, RT_Searched};
+	RomTableStartEnum Start;
+	static const char * const Names[RTB_Count] = {"same", "reloaded", "added", "removed"};
+	OneWireSimDeviceType Sensors[ROMTABLEBENCH_SENSORS + 1];
+	RomTableBenchStorageType Storage;
+	RomTableType Table;
+	uint32_t Errors[RTB_Count] = {0};
+	uint32_t Tried[RTB_Count] = {0};
+	uint32_t Failed = 0;
+	uint32_t Round;
+	uint8_t Count;
+	uint8_t Index;
+	uint8_t Change;
+	uint8_t Device;
+	int8_t High;
+	int8_t Low;
+	uint8_t Resolution;
+
+	OneWireSim_Init(&OneWireSimBus);
+	Temperature_Init();
+
+	for(Round = 0; Round < ROMTABLEBENCH_ROUNDS; Round++)
+	{
+		while(OneWireSimBus.Devices)
+		{
+			OneWireSim_Detach(&OneWireSimBus, OneWireSimBus.Devices);
+		}
+
+		Count = 1 + (uint8_t)(RomTableBench_Random() % ROMTABLEBENCH_SENSORS);
+
+		for(Index = 0; Index <= Count; Index++)
+		{
+			RomTableBench_Sensor(Sensors, Index);
+
+			// The spare one is only attached when a sensor is added
+			if(Index < Count)
+			{
+				OneWireSim_Attach(&OneWireSimBus, &Sensors[Index]);
+			}
+		}
+
+		Change = (uint8_t)(RomTableBench_Random() % RTB_Count);
+		Tried[Change]++;
+
+		// First start, nothing saved yet
+		Storage.Length = 0;
+
+		if((RT_Searched != RomTableBus_Start(&TemperatureDefaultBus, &Table, &RomTableBenchOps, &Storage)) || !RomTableBench_Match(&Table))
+		{
+			Errors[Change]++;
+			continue;
+		}
+
+		// Thresholds of its own on every sensor and in the table, the
+		// EEPROM keeps the power up ones
+		for(Index = 0; Index < Table.Count; Index++)
+		{
+			Table.Device[Index].High = (int8_t)(30 + Index);
+			Table.Device[Index].Low = (int8_t)(-5 - Index);
+
+			if(TemperatureBus_SetAlarm(&TemperatureDefaultBus, &Table.Device[Index].Rom, Table.Device[Index].High, Table.Device[Index].Low))
+			{
+				break;
+			}
+		}
+
+		if((Index != Table.Count) || RomTable_Save(&Table, &RomTableBenchOps, &Storage))
+		{
+			Errors[Change]++;
+			continue;
+		}
+
+		Index = (uint8_t)(RomTableBench_Random() % Count);
+
+		switch(Change)
+		{
+			case RTB_Reloaded:
+				TemperatureBus_RecallAlarm(&TemperatureDefaultBus, &Sensors[Index].Rom);
+				break;
+			case RTB_Added:
+				OneWireSim_Attach(&OneWireSimBus, &Sensors[Count]);
+				break;
+			case RTB_Removed:
+				OneWireSim_Detach(&OneWireSimBus, &Sensors[Index]);
+				break;
+			default:
+				break;
+		}
+
+		// Taking off the only sensor leaves nothing to find
+		Start = ((RTB_Removed == Change) && (1 == Count)) ? RT_NoDevices : Expected[Change];
+
+		if((Start != RomTableBus_Start(&TemperatureDefaultBus, &Table, &RomTableBenchOps, &Storage)) || !RomTableBench_Match(&Table))
+		{
+			Errors[Change]++;
+			continue;
+		}
+
+		// A reloaded sensor has the table thresholds back
+		Device = RomTableBench_Find(&Table, &Sensors[Index].Rom);
+
+		if((RTB_Reloaded == Change) &&
+			(TemperatureBus_GetConfig(&TemperatureDefaultBus, &Sensors[Index].Rom, &High, &Low, &Resolution) || (High != Table.Device[Device].High) || (Low != Table.Device[Device].Low)))
+		{
+			Errors[Change]++;
+		}
+	}
+
+	for(Change = 0; Change < RTB_Count; Change++)
+	{
+		printf("%-9s %4lu restarts  %4lu failed  %s\n", Names[Change], (unsigned long)Tried[Change], (unsigned long)Errors[Change], Errors[Change] ? "FAIL" : "ok");
+		Failed += Errors[Change];
+	}
+
+	return Failed ? 1 : 0;
+}
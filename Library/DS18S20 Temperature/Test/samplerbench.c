@@ -0,0 +1,199 @@
+/////////////////////////////////////////////////////////////////////////
+///	\file	samplerbench.c
+///	\brief simulated bus check of the background sampler.
+///
+///	\section SamplerBenchmark Sampler check
+///
+///	Ticks a TemperatureSampler on the simulated clock for a few tick and
+///	period settings and resolutions. The ticks keep to the clock, the
+///	bus time of a step doesn't push the next tick back, like a timer
+///	interrupt counting the ticks for the main loop. In the last mode the
+///	main loop is held up now and then and catches up on the ticks it
+///	missed all at once. Each conversion gets
+///	a new sensor temperature, so every reading must:
+///
+///	- be the temperature of its own conversion, a scratch pad read before
+///	  the conversion is done has the last one
+///	- be a period after the reading before, or at least a period when
+///	  the period is 0 and the next conversion waits for the read
+///
+///	and no sample may fail.
+///
+///	\code
+///	cd "Library/DS18S20 Temperature/Test"
+///	gcc -std=c99 -O2 -DONEWIRE_SIMULATION -I.. samplerbench.c ../tempsampler.c ../temperature.c ../onewire.c ../uart.c ../onewiresim.c ../cyclecounter.c -o samplerbench && ./samplerbench
+///	\endcode
+///
+///
+///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
+///	Website: www.HashDefineElectronics.com
+///
+///	Licences:
+///
+///		Copyright (c) 2014 Ronald Alexander Nobrega De Sousa
+///
+///		Permission is hereby granted, free of charge, to any person obtaining a copy
+///		of this software and associated documentation files (the "Software"), to deal
+///		in the Software without restriction, including without limitation the rights
+///		to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+///		copies of the Software, and to permit persons to whom the Software is
+///		furnished to do so, subject to the following conditions:
+///
+///		The above copyright notice and this permission notice shall be included in
+///		all copies or substantial portions of the Software.
+///
+///		THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///		IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///		FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///		AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///		LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///		THE SOFTWARE.
+/////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdint.h>
+#include "common.h"
+#include "tempsampler.h"
+#include "onewiresim.h"
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Readings checked in each mode
+/////////////////////////////////////////////////////////////////////////
+#define SAMPLERBENCH_READINGS 40UL
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	xorshift state, fixed seed so a failure can be repeated
+/////////////////////////////////////////////////////////////////////////
+static uint32_t SamplerBenchSeed = 0x2545F491UL;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Random number
+/////////////////////////////////////////////////////////////////////////
+static uint32_t SamplerBench_Random(void)
+{
+	SamplerBenchSeed ^= SamplerBenchSeed << 13;
+	SamplerBenchSeed ^= SamplerBenchSeed >> 17;
+	SamplerBenchSeed ^= SamplerBenchSeed << 5;
+
+	return SamplerBenchSeed;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Random temperature in 1/2 degree C steps, so every sensor
+///	resolution reads it back exactly
+/////////////////////////////////////////////////////////////////////////
+static float SamplerBench_Temperature(void)
+{
+	return -40.0f + (float)(SamplerBench_Random() % (125 * 2)) * 0.5f;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Run one mode and print the results
+///
+///	\param sensor the only sensor on the bus
+///	\param tickMs sampler tick
+///	\param periodMs sampler period
+///	\param resolution sensor resolution in bits
+///	\param stallMs how long the main loop is held up now and then, 0
+///		for never
+///	\return the number of wrong readings
+/////////////////////////////////////////////////////////////////////////
+static uint32_t SamplerBench_Run(OneWireSimDeviceType *sensor, uint32_t tickMs, uint32_t periodMs, uint8_t resolution, uint32_t stallMs)
+{
+	static TemperatureSamplerType Sampler;
+	TemperatureReadingType Reading;
+	uint32_t Errors = 0;
+	uint32_t Readings = 0;
+	uint32_t Sequence = 0;
+	uint32_t Start = OneWireSim_Time(&OneWireSimBus);
+	uint32_t Tick = 0;
+	uint32_t LastTimestamp = 0;
+	uint32_t Due;
+	float Expected = 0;
+	uint8_t Converting = FALSE;
+
+	// Skip ROM so the bus conversion time follows the resolution down
+	if(TemperatureBus_SetResolution(&TemperatureDefaultBus, 0, resolution))
+	{
+		printf("%2lums tick  %4lums period  %2u bit  %3lums stalls  resolution not set  FAIL\n", (unsigned long)tickMs, (unsigned long)periodMs, resolution, (unsigned long)stallMs);
+		return 1;
+	}
+
+	TemperatureSampler_Init(&Sampler, &TemperatureDefaultBus, &sensor->Rom, tickMs, periodMs, resolution);
+
+	while(Readings < SAMPLERBENCH_READINGS)
+	{
+		// The ticks keep to the clock whatever time the bus takes, a late
+		// one is caught up on straight away
+		Tick++;
+		Due = Start + (Tick * tickMs * 1000UL);
+
+		if((int32_t)(Due - OneWireSim_Time(&OneWireSimBus)) > 0)
+		{
+			OneWireSim_Delay(&OneWireSimBus, Due - OneWireSim_Time(&OneWireSimBus));
+		}
+
+		if(stallMs && !(SamplerBench_Random() % 32))
+		{
+			OneWireSim_Delay(&OneWireSimBus, stallMs * 1000UL);
+		}
+
+		TemperatureSampler_Tick(&Sampler);
+
+		// A new conversion, it must read this
+		if(Sampler.Converting && !Converting)
+		{
+			Expected = SamplerBench_Temperature();
+			OneWireSim_SetTemperature(sensor, Expected);
+		}
+
+		Converting = Sampler.Converting;
+
+		if(Sampler.Sequence == Sequence)
+		{
+			continue;
+		}
+
+		Sequence = Sampler.Sequence;
+		Readings++;
+
+		// A read before the conversion is done gets the last temperature,
+		// and every reading is a period after the one before. With no
+		// room in the period the next conversion waits for the read
+		if(TemperatureSampler_Latest(&Sampler, &Reading) || (Reading.Temperature != Expected) ||
+			(LastTimestamp && ((Reading.Timestamp - LastTimestamp) < Sampler.Period)) ||
+			(LastTimestamp && periodMs && ((Reading.Timestamp - LastTimestamp) != Sampler.Period)))
+		{
+			Errors++;
+		}
+
+		LastTimestamp = Reading.Timestamp;
+	}
+
+	Errors += Sampler.Errors;
+
+	printf("%2lums tick  %4lums period  %2u bit  %3lums stalls  %4lu readings  %2lu wrong  %s\n",
+		(unsigned long)tickMs, (unsigned long)periodMs, resolution, (unsigned long)stallMs, (unsigned long)Readings, (unsigned long)Errors, Errors ? "FAIL" : "ok");
+
+	return Errors;
+}
+
+int main(void)
+{
+	OneWireSimDeviceType Sensor;
+	uint32_t Errors = 0;
+
+	OneWireSim_Init(&OneWireSimBus);
+	OneWireSim_DeviceInit(&Sensor, TMP_FAMILY_DS18B20, 0x1234);
+	OneWireSim_Attach(&OneWireSimBus, &Sensor);
+
+	Temperature_Init();
+
+	Errors += SamplerBench_Run(&Sensor, 10, 1000, 12, 0);
+	Errors += SamplerBench_Run(&Sensor, 1, 0, 12, 0);
+	Errors += SamplerBench_Run(&Sensor, 7, 500, 11, 0);
+	Errors += SamplerBench_Run(&Sensor, 5, 0, 9, 0);
+	Errors += SamplerBench_Run(&Sensor, 10, 1000, 12, 30);
+
+	return Errors ? 1 : 0;
+}
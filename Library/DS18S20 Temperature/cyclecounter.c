@@ -0,0 +1,93 @@
+/////////////////////////////////////////////////////////////////////////
+///	\file	cyclecounter.c
+///	\brief portable free running cycle counter used to time the bus.
+///
+///	\section CycleCounter Cycle counter
+///
+///	On Cortex-M3 and up this is the DWT cycle counter, so a count is one
+///	CPU clock. On the host it is CLOCK_MONOTONIC, so a count is one ns.
+///	Only the difference between two reads means anything, the counter
+///	wraps at 2^32.
+///
+///	Define CYCLECOUNTER_READ() to supply your own counter, ie. a free
+///	running timer on parts without a DWT.
+///
+///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
+///	Website: www.HashDefineElectronics.com
+///
+///	Licences:
+///
+///		Copyright (c) 2014 Ronald Alexander Nobrega De Sousa
+///
+///		Permission is hereby granted, free of charge, to any person obtaining a copy
+///		of this software and associated documentation files (the "Software"), to deal
+///		in the Software without restriction, including without limitation the rights
+///		to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+///		copies of the Software, and to permit persons to whom the Software is
+///		furnished to do so, subject to the following conditions:
+///
+///		The above copyright notice and this permission notice shall be included in
+///		all copies or substantial portions of the Software.
+///	
+///		THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///		IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///		FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///		AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///		LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///		THE SOFTWARE.
+/////////////////////////////////////////////////////////////////////////
+#if !defined(CYCLECOUNTER_READ) && !defined(__arm__)
+	#define _POSIX_C_SOURCE 199309L
+	#include <time.h>
+#endif
+#include <stdint.h>
+#include "cyclecounter.h"
+
+#if !defined(CYCLECOUNTER_READ) && defined(__arm__) && (defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__))
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Core debug and DWT registers
+/////////////////////////////////////////////////////////////////////////
+#define CYCLECOUNTER_DEMCR		(*(volatile uint32_t *)0xE000EDFCUL)	///< Debug exception and monitor control
+#define CYCLECOUNTER_DWT_CTRL	(*(volatile uint32_t *)0xE0001000UL)	///< DWT control
+#define CYCLECOUNTER_DWT_CYCCNT	(*(volatile uint32_t *)0xE0001004UL)	///< DWT cycle count
+
+#define CYCLECOUNTER_TRCENA		0x01000000UL	///< DEMCR trace enable
+#define CYCLECOUNTER_CYCCNTENA	0x00000001UL	///< DWT_CTRL cycle counter enable
+
+#define CYCLECOUNTER_DWT
+#endif
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Start the counter. Safe to call more than once.
+/////////////////////////////////////////////////////////////////////////
+void CycleCounter_Init(void)
+{
+#ifdef CYCLECOUNTER_DWT
+	CYCLECOUNTER_DEMCR |= CYCLECOUNTER_TRCENA;
+	CYCLECOUNTER_DWT_CTRL |= CYCLECOUNTER_CYCCNTENA;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read the counter
+///
+///	\return CPU cycles on Cortex-M, ns on the host
+/////////////////////////////////////////////////////////////////////////
+uint32_t CycleCounter_Read(void)
+{
+#if defined(CYCLECOUNTER_READ)
+	return CYCLECOUNTER_READ();
+#elif defined(CYCLECOUNTER_DWT)
+	return CYCLECOUNTER_DWT_CYCCNT;
+#elif !defined(__arm__)
+	struct timespec Now;
+	
+	clock_gettime(CLOCK_MONOTONIC, &Now);
+	
+	return (uint32_t)((uint64_t)Now.tv_sec * 1000000000ULL + (uint64_t)Now.tv_nsec);
+#else
+	// \todo Cortex-M0 has no DWT counter. define CYCLECOUNTER_READ()
+	return 0;
+#endif
+}
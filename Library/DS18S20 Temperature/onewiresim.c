@@ -0,0 +1,752 @@
+/////////////////////////////////////////////////////////////////////////
+///	\file	onewiresim.c
+///	\brief host side simulation of a 1 wire bus with DS18S20/DS18B20
+///			sensors.
+///
+///	\section OneWireSimulation One wire bus simulation
+///
+///	The simulation stands in for the UART hardware. Every character sent
+///	is turned in to a reset pulse or a time slot depending on how long it
+///	holds the bus low, the devices act on it and the echo is the wired AND
+///	of the character and the devices. The bus keeps its own time so
+///	transfers and conversions can be timed.
+///
+///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
+///	Website: www.HashDefineElectronics.com
+///
+///	Licences:
+///
+///		Copyright (c) 2014 Ronald Alexander Nobrega De Sousa
+///
+///		Permission is hereby granted, free of charge, to any person obtaining a copy
+///		of this software and associated documentation files (the "Software"), to deal
+///		in the Software without restriction, including without limitation the rights
+///		to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+///		copies of the Software, and to permit persons to whom the Software is
+///		furnished to do so, subject to the following conditions:
+///
+///		The above copyright notice and this permission notice shall be included in
+///		all copies or substantial portions of the Software.
+///	
+///		THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///		IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///		FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///		AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///		LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///		THE SOFTWARE.
+/////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <math.h>
+#include "common.h"
+#include "onewire.h"
+#include "onewiresim.h"
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Device protocol states
+/////////////////////////////////////////////////////////////////////////
+enum OneWireSimStateEnum{
+	SIM_IDLE = 0,				///< Not selected. Waits for the next reset
+	SIM_ROM_COMMAND,			///< Receiving the ROM command
+	SIM_MATCH_ROM,				///< Receiving the ROM code to match
+	SIM_SEARCH_ROM,				///< Taking part in a search
+	SIM_FUNCTION_COMMAND,		///< Receiving the function command
+	SIM_SEND,					///< Sending data on read slots
+	SIM_RECEIVE,				///< Receiving the scratch pad data
+	SIM_STATUS					///< Answering read slots with the conversion status
+};
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	ROM and function commands understood by the devices
+/////////////////////////////////////////////////////////////////////////
+enum OneWireSimCommandEnum{
+	SIM_SEARCH = 0xF0,
+	SIM_READ_ROM = 0x33,
+	SIM_MATCH = 0x55,
+	SIM_SKIP = 0xCC,
+	SIM_OVERDRIVE_MATCH = 0x69,
+	SIM_OVERDRIVE_SKIP = 0x3C,
+	SIM_ALARM_SEARCH = 0xEC,
+	SIM_CONVERT_T = 0x44,
+	SIM_WRITE_SCRATCHPAD = 0x4E,
+	SIM_READ_SCRATCHPAD = 0xBE,
+	SIM_COPY_SCRATCHPAD = 0x48,
+	SIM_RECALL_E2 = 0xB8,
+	SIM_READ_POWER_SUPPLY = 0xB4
+};
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Family code of the DS18S20, the only fixed resolution device
+/////////////////////////////////////////////////////////////////////////
+static const uint8_t FamilyDS18S20 = 0x10;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Device timing at one speed, all in ns
+/////////////////////////////////////////////////////////////////////////
+typedef struct
+{
+	uint32_t ResetLowNs;				///< A low pulse at least this long resets the device
+	uint32_t WriteZeroLowNs;			///< A slot held low at least this long is a write 0
+	uint32_t PresenceDelayNs;			///< Delay from the end of reset to the presence pulse
+	uint32_t PresenceLowNs;				///< Presence pulse length
+	uint32_t ReadZeroLowNs;				///< How long the device holds the bus low to send a 0
+} OneWireSimTimingType;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Device timing at standard and at overdrive speed. A
+///	standard reset also resets the devices that are in overdrive.
+/////////////////////////////////////////////////////////////////////////
+static const OneWireSimTimingType SimTiming[2] =
+{
+	{480000, 15000, 30000, 120000, 30000},
+	{48000, 2000, 3000, 16000, 3000}
+};
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Standard speed timing
+/////////////////////////////////////////////////////////////////////////
+static const OneWireSimTimingType *const StandardTiming = &SimTiming[0];
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Default simulated bus
+/////////////////////////////////////////////////////////////////////////
+OneWireSimType OneWireSimBus;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Check if the device has a DS18B20 style configuration register
+/////////////////////////////////////////////////////////////////////////
+static uint_fast8_t OneWireSim_HasConfig(const OneWireSimDeviceType *device)
+{
+	return (device->Rom.Code[0] != FamilyDS18S20);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Conversion time of the device in us
+/////////////////////////////////////////////////////////////////////////
+static uint32_t OneWireSim_ConvertionTime(const OneWireSimDeviceType *device)
+{
+	if(OneWireSim_HasConfig(device))
+	{
+		// 93.75ms at 9 bit doubling with every extra bit
+		return 93750UL << ((device->Scratchpad[4] >> 5) & 0x03);
+	}
+
+	return 750000UL;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Store the device temperature in the scratch pad the way the
+///	real device does and update the alarm flag.
+/////////////////////////////////////////////////////////////////////////
+static void OneWireSim_Convert(OneWireSimDeviceType *device)
+{
+	int16_t Raw;
+	int16_t Integer;
+	uint8_t Resolution;
+
+	if(OneWireSim_HasConfig(device))
+	{
+		// 1/16 degree C steps with the unused low bits cleared
+		Resolution = (device->Scratchpad[4] >> 5) & 0x03;
+		Raw = (int16_t)floorf(device->Temperature * 16.0f + 0.5f);
+		Raw &= (int16_t)(0xFFFF << (3 - Resolution));
+		Integer = Raw >> 4;
+
+		device->Scratchpad[0] = (uint8_t)Raw;
+		device->Scratchpad[1] = (uint8_t)((uint16_t)Raw >> 8);
+	}
+	else
+	{
+		// 1/2 degree C steps plus the count remain for the extended resolution
+		Raw = (int16_t)floorf(device->Temperature * 2.0f + 0.5f);
+		Integer = Raw >> 1;
+
+		device->Scratchpad[0] = (uint8_t)Raw;
+		device->Scratchpad[1] = (Raw < 0) ? 0xFF : 0x00;
+		device->Scratchpad[6] = 16 - (uint8_t)floorf((device->Temperature - Integer + 0.25f) * 16.0f + 0.5f);
+		device->Scratchpad[7] = 16;
+	}
+
+	device->Scratchpad[8] = OneWire_CalculateCRC(&device->Scratchpad[0], ONEWIRESIM_SCRATCHPAD_LENGTH - 1);
+
+	device->Alarm = (Integer >= (int8_t)device->Scratchpad[2]) || (Integer <= (int8_t)device->Scratchpad[3]);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Finish the conversions that are due
+/////////////////////////////////////////////////////////////////////////
+static void OneWireSim_Update(OneWireSimType *sim)
+{
+	OneWireSimDeviceType *Device;
+	uint32_t Now = OneWireSim_Time(sim);
+
+	for(Device = sim->Devices; Device; Device = Device->Next)
+	{
+		if(Device->Converting && ((int32_t)(Now - Device->ConvertionEnd) >= 0))
+		{
+			Device->Converting = FALSE;
+			OneWireSim_Convert(Device);
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Start sending data on the following read slots
+/////////////////////////////////////////////////////////////////////////
+static void OneWireSim_Send(OneWireSimDeviceType *device, const uint8_t *data, uint8_t length, uint8_t nextState)
+{
+	device->State = SIM_SEND;
+	device->NextState = nextState;
+	device->SendData = data;
+	device->SendLength = length;
+	device->BitCount = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Get the bit the device puts on the bus in the next slot
+///
+///	\return 0 if the device pulls the bus low else 1
+/////////////////////////////////////////////////////////////////////////
+static uint8_t OneWireSim_Output(const OneWireSimDeviceType *device)
+{
+	uint8_t Bit;
+
+	switch(device->State)
+	{
+		case SIM_SEND:
+			return (device->SendData[device->BitCount >> 3] >> (device->BitCount & 0x07)) & 0x01;
+
+		case SIM_SEARCH_ROM:
+			Bit = (device->Rom.Code[device->BitCount >> 3] >> (device->BitCount & 0x07)) & 0x01;
+
+			if(0 == device->SearchStep)
+			{
+				return Bit;
+			}
+
+			if(1 == device->SearchStep)
+			{
+				return Bit ^ 0x01;
+			}
+
+			return 1;
+
+		case SIM_STATUS:
+			return device->Converting ? 0 : 1;
+
+		default:
+			return 1;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Act on a complete ROM command
+/////////////////////////////////////////////////////////////////////////
+static void OneWireSim_RomCommand(OneWireSimDeviceType *device, uint8_t command)
+{
+	device->BitCount = 0;
+
+	switch(command)
+	{
+		case SIM_READ_ROM:
+			OneWireSim_Send(device, &device->Rom.Code[0], ONEWIRE_ROM_LENGTH, SIM_FUNCTION_COMMAND);
+			break;
+
+		case SIM_MATCH:
+			device->State = SIM_MATCH_ROM;
+			break;
+
+		case SIM_SKIP:
+			device->State = SIM_FUNCTION_COMMAND;
+			break;
+
+		case SIM_OVERDRIVE_MATCH:
+		case SIM_OVERDRIVE_SKIP:
+			// Every overdrive device switches speed, even the ones the match drops
+			device->Overdrive = device->OverdriveSupport;
+			device->State = !device->Overdrive ? SIM_IDLE : ((SIM_OVERDRIVE_SKIP == command) ? SIM_FUNCTION_COMMAND : SIM_MATCH_ROM);
+			break;
+
+		case SIM_ALARM_SEARCH:
+			device->SearchStep = 0;
+			device->State = device->Alarm ? SIM_SEARCH_ROM : SIM_IDLE;
+			break;
+
+		case SIM_SEARCH:
+			device->SearchStep = 0;
+			device->State = SIM_SEARCH_ROM;
+			break;
+
+		default:
+			device->State = SIM_IDLE;
+			break;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Act on a complete function command
+/////////////////////////////////////////////////////////////////////////
+static void OneWireSim_FunctionCommand(OneWireSimType *sim, OneWireSimDeviceType *device, uint8_t command)
+{
+	device->BitCount = 0;
+	device->State = SIM_IDLE;
+
+	switch(command)
+	{
+		case SIM_CONVERT_T:
+			device->Converting = TRUE;
+			device->ConvertionEnd = OneWireSim_Time(sim) + OneWireSim_ConvertionTime(device);
+			device->State = SIM_STATUS;
+			break;
+
+		case SIM_READ_SCRATCHPAD:
+			OneWireSim_Send(device, &device->Scratchpad[0], ONEWIRESIM_SCRATCHPAD_LENGTH, SIM_IDLE);
+			break;
+
+		case SIM_WRITE_SCRATCHPAD:
+			device->State = SIM_RECEIVE;
+			device->SendLength = 0;
+			break;
+
+		case SIM_COPY_SCRATCHPAD:
+			device->Eeprom[0] = device->Scratchpad[2];
+			device->Eeprom[1] = device->Scratchpad[3];
+			device->Eeprom[2] = device->Scratchpad[4];
+			break;
+
+		case SIM_RECALL_E2:
+			device->Scratchpad[2] = device->Eeprom[0];
+			device->Scratchpad[3] = device->Eeprom[1];
+
+			if(OneWireSim_HasConfig(device))
+			{
+				device->Scratchpad[4] = device->Eeprom[2];
+			}
+
+			device->Scratchpad[8] = OneWire_CalculateCRC(&device->Scratchpad[0], ONEWIRESIM_SCRATCHPAD_LENGTH - 1);
+			break;
+
+		default:
+			// Read power supply answers 1 (external power) and that is the idle state too
+			break;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Move the device on by one slot
+///
+///	\param sim the bus
+///	\param device the device
+///	\param line the bus level sampled in the slot
+/////////////////////////////////////////////////////////////////////////
+static void OneWireSim_Slot(OneWireSimType *sim, OneWireSimDeviceType *device, uint8_t line)
+{
+	uint8_t Bit;
+
+	switch(device->State)
+	{
+		case SIM_ROM_COMMAND:
+		case SIM_MATCH_ROM:
+		case SIM_FUNCTION_COMMAND:
+		case SIM_RECEIVE:
+			device->Data = (device->Data >> 1) | (line ? 0x80 : 0x00);
+			device->BitCount++;
+
+			if(device->BitCount & 0x07)
+			{
+				break;
+			}
+
+			if(SIM_ROM_COMMAND == device->State)
+			{
+				OneWireSim_RomCommand(device, device->Data);
+			}
+			else if(SIM_FUNCTION_COMMAND == device->State)
+			{
+				OneWireSim_FunctionCommand(sim, device, device->Data);
+			}
+			else if(SIM_MATCH_ROM == device->State)
+			{
+				if(device->Data != device->Rom.Code[(device->BitCount >> 3) - 1])
+				{
+					device->State = SIM_IDLE;
+				}
+				else if(device->BitCount == (ONEWIRE_ROM_LENGTH * 8))
+				{
+					device->BitCount = 0;
+					device->State = SIM_FUNCTION_COMMAND;
+				}
+			}
+			else
+			{
+				// TH, TL and on the DS18B20 the configuration register
+				device->Scratchpad[2 + device->SendLength] = device->Data;
+				device->SendLength++;
+
+				if(!OneWireSim_HasConfig(device) && (2 == device->SendLength))
+				{
+					device->State = SIM_IDLE;
+				}
+				else if(3 == device->SendLength)
+				{
+					// Only the resolution bits can be written
+					device->Scratchpad[4] = (device->Scratchpad[4] & 0x60) | 0x1F;
+					device->State = SIM_IDLE;
+				}
+
+				device->Scratchpad[8] = OneWire_CalculateCRC(&device->Scratchpad[0], ONEWIRESIM_SCRATCHPAD_LENGTH - 1);
+			}
+			break;
+
+		case SIM_SEND:
+			device->BitCount++;
+
+			if(device->BitCount == (device->SendLength * 8))
+			{
+				device->BitCount = 0;
+				device->State = device->NextState;
+			}
+			break;
+
+		case SIM_SEARCH_ROM:
+			if(device->SearchStep < 2)
+			{
+				device->SearchStep++;
+				break;
+			}
+
+			// The master picked a direction. Drop out if it isn't ours
+			Bit = (device->Rom.Code[device->BitCount >> 3] >> (device->BitCount & 0x07)) & 0x01;
+			device->SearchStep = 0;
+			device->BitCount++;
+
+			if(line != Bit)
+			{
+				device->State = SIM_IDLE;
+			}
+			else if(device->BitCount == (ONEWIRE_ROM_LENGTH * 8))
+			{
+				device->BitCount = 0;
+				device->State = SIM_FUNCTION_COMMAND;
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Start with an empty bus
+///
+///	\param sim the bus
+/////////////////////////////////////////////////////////////////////////
+void OneWireSim_Init(OneWireSimType *sim)
+{
+	sim->Devices = 0;
+	sim->Baud = 9600;
+	sim->BaudChanges = 0;
+	sim->TimeNs = 0;
+	sim->PresenceStartNs = 0;
+	sim->PresenceEndNs = 0;
+	sim->EchoPolls = 0;
+	sim->EchoWait = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Set up a device in its power up state
+///
+///	\param device the device
+///	\param family the family code. ie 0x10 DS18S20, 0x28 DS18B20
+///	\param serial the device serial number
+/////////////////////////////////////////////////////////////////////////
+void OneWireSim_DeviceInit(OneWireSimDeviceType *device, uint8_t family, uint32_t serial)
+{
+	uint8_t Index;
+
+	device->Rom.Code[0] = family;
+
+	for(Index = 1; Index < (ONEWIRE_ROM_LENGTH - 1); Index++)
+	{
+		device->Rom.Code[Index] = (uint8_t)serial;
+		serial = serial >> 8;
+	}
+
+	device->Rom.Code[ONEWIRE_ROM_LENGTH - 1] = OneWire_CalculateCRC(&device->Rom.Code[0], ONEWIRE_ROM_LENGTH - 1);
+
+	// Power up defaults
+	device->Eeprom[0] = 75;
+	device->Eeprom[1] = 70;
+	device->Eeprom[2] = 0x7F;
+
+	device->Scratchpad[2] = device->Eeprom[0];
+	device->Scratchpad[3] = device->Eeprom[1];
+	device->Scratchpad[4] = OneWireSim_HasConfig(device) ? device->Eeprom[2] : 0xFF;
+	device->Scratchpad[5] = 0xFF;
+	device->Scratchpad[6] = 0x0C;
+	device->Scratchpad[7] = 0x10;
+
+	device->Temperature = 85.0f;
+	OneWireSim_Convert(device);
+
+	device->Converting = FALSE;
+	device->ConvertionEnd = 0;
+	device->OverdriveSupport = FALSE;
+	device->Overdrive = FALSE;
+	device->State = SIM_IDLE;
+	device->BitCount = 0;
+	device->SearchStep = 0;
+	device->Next = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Set the temperature the next conversion will read
+///
+///	\param device the device
+///	\param temperature the temperature in degree C
+/////////////////////////////////////////////////////////////////////////
+void OneWireSim_SetTemperature(OneWireSimDeviceType *device, float temperature)
+{
+	device->Temperature = temperature;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Connect a device to the bus
+///
+///	\param sim the bus
+///	\param device the device
+/////////////////////////////////////////////////////////////////////////
+void OneWireSim_Attach(OneWireSimType *sim, OneWireSimDeviceType *device)
+{
+	device->State = SIM_IDLE;
+	device->Next = sim->Devices;
+	sim->Devices = device;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Disconnect a device from the bus
+///
+///	\param sim the bus
+///	\param device the device
+/////////////////////////////////////////////////////////////////////////
+void OneWireSim_Detach(OneWireSimType *sim, OneWireSimDeviceType *device)
+{
+	OneWireSimDeviceType **Link = &sim->Devices;
+
+	while(*Link)
+	{
+		if(*Link == device)
+		{
+			*Link = device->Next;
+			device->Next = 0;
+			return;
+		}
+
+		Link = &(*Link)->Next;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Set the UART baudrate used for the following transfers
+///
+///	\param sim the bus
+///	\param baud the baudrate
+/////////////////////////////////////////////////////////////////////////
+void OneWireSim_SetBaud(OneWireSimType *sim, uint32_t baud)
+{
+	sim->Baud = baud;
+	sim->BaudChanges++;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Check if a low pulse resets the device. Returns the timing
+///	of the presence pulse or NULL when the pulse is just a slot.
+///
+///	\param device the device
+///	\param lowNs how long the bus was held low
+/////////////////////////////////////////////////////////////////////////
+static const OneWireSimTimingType *OneWireSim_Reset(OneWireSimDeviceType *device, uint32_t lowNs)
+{
+	if(lowNs >= StandardTiming->ResetLowNs)
+	{
+		device->Overdrive = FALSE;
+	}
+	else if(!device->Overdrive || (lowNs < SimTiming[1].ResetLowNs))
+	{
+		return 0;
+	}
+
+	device->State = SIM_ROM_COMMAND;
+	device->BitCount = 0;
+	device->Data = 0;
+
+	return &SimTiming[device->Overdrive];
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Widen the time the devices hold the bus low
+/////////////////////////////////////////////////////////////////////////
+static void OneWireSim_PullLow(uint32_t *start, uint32_t *end, uint32_t from, uint32_t to)
+{
+	if(*end == 0)
+	{
+		*start = from;
+	}
+	else if(from < *start)
+	{
+		*start = from;
+	}
+
+	if(to > *end)
+	{
+		*end = to;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Hold the bus low without a UART character, ie. a UART break,
+///	then leave it idle. A break of 480us or more is a reset pulse and
+///	the presence pulse shows up in the echo of any character sent within
+///	the idle time.
+///
+///	\param sim the bus
+///	\param low how long the bus is held low in us
+///	\param idle how long the bus is left idle afterwards in us
+/////////////////////////////////////////////////////////////////////////
+void OneWireSim_Break(OneWireSimType *sim, uint32_t low, uint32_t idle)
+{
+	OneWireSimDeviceType *Device;
+
+	OneWireSim_Update(sim);
+
+	sim->TimeNs += (uint64_t)low * 1000;
+
+	if((((uint64_t)low * 1000) >= StandardTiming->ResetLowNs) && sim->Devices)
+	{
+		for(Device = sim->Devices; Device; Device = Device->Next)
+		{
+			OneWireSim_Reset(Device, StandardTiming->ResetLowNs);
+		}
+
+		sim->PresenceStartNs = sim->TimeNs + StandardTiming->PresenceDelayNs;
+		sim->PresenceEndNs = sim->PresenceStartNs + StandardTiming->PresenceLowNs;
+	}
+
+	OneWireSim_Delay(sim, idle);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Send one UART character on the bus and get its echo. The
+///	TX and RX pins are tied to the open drain bus so the echo is the
+///	wired AND of the character and whatever the devices drive.
+///
+///	\param sim the bus
+///	\param data the character sent
+///	\return the character received
+/////////////////////////////////////////////////////////////////////////
+uint8_t OneWireSim_Transfer(OneWireSimType *sim, uint8_t data)
+{
+	OneWireSimDeviceType *Device;
+	uint32_t BitNs = 1000000000UL / sim->Baud;
+	uint32_t LowNs = BitNs; // start bit
+	uint32_t DeviceLowStart = 0;
+	uint32_t DeviceLowEnd = 0;
+	uint32_t SampleNs;
+	const OneWireSimTimingType *Timing;
+	uint8_t Echo = 0;
+	uint8_t Line = 1;
+	uint8_t Index;
+
+	OneWireSim_Update(sim);
+
+	// The bus stays low from the start bit up to the first 1 bit
+	for(Index = 0; (Index < 8) && !((data >> Index) & 0x01); Index++)
+	{
+		LowNs += BitNs;
+	}
+
+	if(sim->PresenceEndNs > sim->TimeNs)
+	{
+		// Still in the presence pulse that followed a break. The devices
+		// ignore the bus until it's over
+		if(sim->PresenceStartNs > sim->TimeNs)
+		{
+			DeviceLowStart = (uint32_t)(sim->PresenceStartNs - sim->TimeNs);
+		}
+
+		DeviceLowEnd = (uint32_t)(sim->PresenceEndNs - sim->TimeNs);
+	}
+	else
+	{
+		// A reset pulse for the devices at its speed, they answer with a 
+		// presence pulse. The others see a time slot
+		for(Device = sim->Devices; Device; Device = Device->Next)
+		{
+			Timing = OneWireSim_Reset(Device, LowNs);
+
+			if(Timing)
+			{
+				OneWireSim_PullLow(&DeviceLowStart, &DeviceLowEnd, LowNs + Timing->PresenceDelayNs, LowNs + Timing->PresenceDelayNs + Timing->PresenceLowNs);
+			}
+			else if(!OneWireSim_Output(Device))
+			{
+				Line = 0;
+				OneWireSim_PullLow(&DeviceLowStart, &DeviceLowEnd, 0, SimTiming[Device->Overdrive].ReadZeroLowNs);
+			}
+		}
+
+		for(Device = sim->Devices; Device; Device = Device->Next)
+		{
+			Timing = &SimTiming[Device->Overdrive];
+
+			// The devices that were reset sit this one out
+			if(LowNs >= Timing->ResetLowNs)
+			{
+				continue;
+			}
+
+			// A long low is a write 0
+			OneWireSim_Slot(sim, Device, Line && (LowNs < Timing->WriteZeroLowNs));
+		}
+	}
+
+	// Sample each data bit in the middle of the bit time
+	for(Index = 0; Index < 8; Index++)
+	{
+		SampleNs = (BitNs * (2 * Index + 3)) / 2;
+
+		if(((data >> Index) & 0x01) && !((SampleNs >= DeviceLowStart) && (SampleNs < DeviceLowEnd)))
+		{
+			Echo |= (1 << Index);
+		}
+	}
+
+	// Start, 8 data bits and stop
+	sim->TimeNs += (uint64_t)BitNs * 10;
+
+	return Echo;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Let time pass on the bus
+///
+///	\param sim the bus
+///	\param us how long to wait in us
+/////////////////////////////////////////////////////////////////////////
+void OneWireSim_Delay(OneWireSimType *sim, uint32_t us)
+{
+	sim->TimeNs += (uint64_t)us * 1000;
+
+	OneWireSim_Update(sim);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Get the bus time
+///
+///	\param sim the bus
+///	\return the time since OneWireSim_Init() in us
+/////////////////////////////////////////////////////////////////////////
+uint32_t OneWireSim_Time(const OneWireSimType *sim)
+{
+	return (uint32_t)(sim->TimeNs / 1000);
+}
@@ -0,0 +1,520 @@
+/////////////////////////////////////////////////////////////////////////
+///	\file	romtable.c
+///	\brief saved table of the sensors on a bus so a restart only has to
+///	check them instead of searching the bus again.
+///
+///	\section RomTableFormat Saved Format
+///
+///	Byte 0 is the format version, byte 1 the number of sensors. Then for
+///	each sensor its 8 byte ROM code, the resolution, TH and TL. The last
+///	byte is the 1-Wire CRC of everything before it, so a table that was
+///	only half written is thrown away like a missing one.
+///
+///	\section RomTableStart Warm Start
+///
+///	At start up every saved sensor is addressed with match ROM and its
+///	scratch pad read back. That proves it's still on the bus and gives its
+///	configuration, which is put back if it's different from the saved one.
+///	Only when a sensor is missing is the whole bus searched. A sensor that
+///	was added while the power was off isn't seen until the next search,
+///	so call RomTableBus_Search() when the wiring changes.
+///
+///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
+///	Website: www.HashDefineElectronics.com
+///
+///	Licences:
+///
+///		Copyright (c) 2014 Ronald Alexander Nobrega De Sousa
+///
+///		Permission is hereby granted, free of charge, to any person obtaining a copy
+///		of this software and associated documentation files (the "Software"), to deal
+///		in the Software without restriction, including without limitation the rights
+///		to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+///		copies of the Software, and to permit persons to whom the Software is
+///		furnished to do so, subject to the following conditions:
+///
+///		The above copyright notice and this permission notice shall be included in
+///		all copies or substantial portions of the Software.
+///
+///		THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///		IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///		FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///		AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///		LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///		THE SOFTWARE.
+/////////////////////////////////////////////////////////////////////////
+#include "common.h"
+#include "romtable.h"
+
+#if ROMTABLE_FILE_STORAGE
+	#include <stdio.h>
+#endif
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Offset of the first sensor in the saved table
+/////////////////////////////////////////////////////////////////////////
+static const uint8_t HeaderLength = 2;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Put the saved configuration back on a sensor
+///
+///	\param bus the bus
+///	\param entry the sensor and its configuration
+///	\return TMP_Success or the TemperatureRespoceEnum error
+/////////////////////////////////////////////////////////////////////////
+static TemperatureRespoceEnum RomTable_Configure(TemperatureBusType *bus, const RomTableEntryType *entry)
+{
+	TemperatureRespoceEnum ReturnState = TemperatureBus_SetAlarm(bus, &entry->Rom, entry->High, entry->Low);
+	
+	if(ReturnState || !entry->Resolution)
+	{
+		return ReturnState;
+	}
+	
+	return TemperatureBus_SetResolution(bus, &entry->Rom, entry->Resolution);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Set the bus conversion time to the slowest sensor in the 
+///	table
+///
+///	\param bus the bus
+///	\param table the sensors on the bus
+/////////////////////////////////////////////////////////////////////////
+static void RomTable_ConvertionTime(TemperatureBusType *bus, const RomTableType *table)
+{
+	uint16_t Time = 0;
+	uint16_t DeviceTime;
+	uint8_t Index;
+	
+	for(Index = 0; Index < table->Count; Index++)
+	{
+		DeviceTime = Temperature_ConvertionTime(table->Device[Index].Rom.Code[0], table->Device[Index].Resolution);
+		
+		if(DeviceTime > Time)
+		{
+			Time = DeviceTime;
+		}
+	}
+	
+	bus->ConvertionTime = Time;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Write the table in the saved format
+///
+///	\param table the table
+///	\param destination where to write it
+///	\param length size of the destination in bytes
+///	\return bytes written or 0 if the destination is too small
+/////////////////////////////////////////////////////////////////////////
+uint_fast16_t RomTable_Serialise(const RomTableType *table, uint8_t *destination, uint_fast16_t length)
+{
+	uint_fast16_t Length = ROMTABLE_LENGTH(table->Count);
+	const RomTableEntryType *Entry;
+	uint8_t *Data = &destination[HeaderLength];
+	uint8_t Index;
+	uint8_t Byte;
+	
+	if((table->Count > ROMTABLE_MAX_DEVICES) || (length < Length))
+	{
+		return 0;
+	}
+	
+	destination[0] = ROMTABLE_VERSION;
+	destination[1] = table->Count;
+	
+	for(Index = 0; Index < table->Count; Index++)
+	{
+		Entry = &table->Device[Index];
+		
+		for(Byte = 0; Byte < ONEWIRE_ROM_LENGTH; Byte++)
+		{
+			Data[Byte] = Entry->Rom.Code[Byte];
+		}
+		
+		Data[ONEWIRE_ROM_LENGTH] = Entry->Resolution;
+		Data[ONEWIRE_ROM_LENGTH + 1] = (uint8_t)Entry->High;
+		Data[ONEWIRE_ROM_LENGTH + 2] = (uint8_t)Entry->Low;
+		
+		Data += ROMTABLE_ENTRY_LENGTH;
+	}
+	
+	*Data = OneWire_CalculateCRC(destination, (uint8_t)(Length - 1));
+	
+	return Length;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read a table in the saved format. The version, the CRC and
+///	every ROM code CRC have to match.
+///
+///	\param table the table to fill
+///	\param source the saved bytes
+///	\param length how many bytes were saved
+///	\return FALSE on success else TRUE. The table is left empty on failure
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t RomTable_Deserialise(RomTableType *table, const uint8_t *source, uint_fast16_t length)
+{
+	RomTableEntryType *Entry;
+	const uint8_t *Data = &source[HeaderLength];
+	uint8_t Index;
+	uint8_t Byte;
+	
+	table->Count = 0;
+	
+	if((length < ROMTABLE_LENGTH(0)) || (ROMTABLE_VERSION != source[0]) || (source[1] > ROMTABLE_MAX_DEVICES) || (length < ROMTABLE_LENGTH(source[1])))
+	{
+		return TRUE;
+	}
+	
+	// The CRC over the data and its CRC is zero
+	if(OneWire_CalculateCRC((uint8_t *)source, (uint8_t)ROMTABLE_LENGTH(source[1])))
+	{
+		return TRUE;
+	}
+	
+	for(Index = 0; Index < source[1]; Index++)
+	{
+		Entry = &table->Device[Index];
+		
+		for(Byte = 0; Byte < ONEWIRE_ROM_LENGTH; Byte++)
+		{
+			Entry->Rom.Code[Byte] = Data[Byte];
+		}
+		
+		Entry->Resolution = Data[ONEWIRE_ROM_LENGTH];
+		Entry->High = (int8_t)Data[ONEWIRE_ROM_LENGTH + 1];
+		Entry->Low = (int8_t)Data[ONEWIRE_ROM_LENGTH + 2];
+		
+		if(OneWire_CalculateCRC(&Entry->Rom.Code[0], ONEWIRE_ROM_LENGTH))
+		{
+			return TRUE;
+		}
+		
+		Data += ROMTABLE_ENTRY_LENGTH;
+	}
+	
+	table->Count = source[1];
+	
+	return FALSE;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Save the table
+///
+///	\param table the table
+///	\param storage where to save it
+///	\param context passed to the storage operations
+///	\return FALSE on success else TRUE
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t RomTable_Save(const RomTableType *table, const RomTableStorageOpsType *storage, void *context)
+{
+	uint8_t Data[ROMTABLE_MAX_LENGTH];
+	uint_fast16_t Length = RomTable_Serialise(table, &Data[0], sizeof(Data));
+	
+	if(!Length)
+	{
+		return TRUE;
+	}
+	
+	return storage->Save(context, &Data[0], Length);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Load the saved table
+///
+///	\param table the table to fill
+///	\param storage where it was saved
+///	\param context passed to the storage operations
+///	\return FALSE on success else TRUE if nothing valid was saved
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t RomTable_Load(RomTableType *table, const RomTableStorageOpsType *storage, void *context)
+{
+	uint8_t Data[ROMTABLE_MAX_LENGTH];
+	
+	return RomTable_Deserialise(table, &Data[0], storage->Load(context, &Data[0], sizeof(Data)));
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Check if a sensor in the table explains a branch on the 
+///	search path of another one, ie. its ROM code is the same up to the 
+///	branch and differs at it.
+///
+///	\param table the sensors
+///	\param rom the ROM code whose path has the branch
+///	\param bit the branch, 0 for the LSB of the family code
+///	\return TRUE if a sensor in the table takes the other branch
+/////////////////////////////////////////////////////////////////////////
+static uint_fast8_t RomTable_Branch(const RomTableType *table, const OneWireRomType *rom, uint8_t bit)
+{
+	const OneWireRomType *Other;
+	uint8_t Byte = bit >> 3;
+	uint8_t Mask = (uint8_t)(1 << (bit & 0x07));
+	uint8_t Index;
+	uint8_t Device;
+	
+	for(Device = 0; Device < table->Count; Device++)
+	{
+		Other = &table->Device[Device].Rom;
+		
+		for(Index = 0; (Index < Byte) && (Other->Code[Index] == rom->Code[Index]); Index++)
+		{
+		}
+		
+		// Same lower bits in the branch byte, different branch bit
+		if((Index == Byte) && (((Other->Code[Byte] ^ rom->Code[Byte]) & (uint8_t)((Mask << 1) - 1)) == Mask))
+		{
+			return TRUE;
+		}
+	}
+	
+	return FALSE;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Check the bus still has exactly the sensors in the table. 
+///	Each one is looked for with a single search pass down its ROM path,
+///	see OneWireBus_Verify(). Every branch on the way has to lead to 
+///	another sensor in the table, one that doesn't is a device that was
+///	added. A sensor whose configuration doesn't match the table gets the
+///	table configuration back, ie. after a power cycle that reloaded an
+///	older one from its EEPROM.
+///
+///	\param bus the bus
+///	\param table the sensors
+///	\return TMP_Success, TMP_NoPresence if a sensor has gone, TMP_Error if
+///		the bus has a device that isn't in the table or the error of the
+///		first sensor that couldn't be configured
+///
+///	\note any device that isn't a sensor counts as an added one, so on a
+///		bus shared with other kinds of device the check always fails.
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum RomTableBus_Verify(TemperatureBusType *bus, const RomTableType *table)
+{
+	const RomTableEntryType *Entry;
+	TemperatureRespoceEnum ReturnState;
+	OneWireSearchType Search;
+	OneWireRomType Branches;
+	uint8_t Resolution;
+	int8_t High;
+	int8_t Low;
+	uint8_t Index;
+	uint8_t Bit;
+	
+	if(!table->Count)
+	{
+		// Nothing may answer the reset either
+		return (OW_NoPresence == OneWireBus_Reset(bus->Bus)) ? TMP_Success : TMP_Error;
+	}
+	
+	Temperature_SearchInit(&Search);
+	
+	for(Index = 0; Index < table->Count; Index++)
+	{
+		Entry = &table->Device[Index];
+		
+		if(OneWireBus_Verify(bus->Bus, &Entry->Rom, Search.Command, &Branches))
+		{
+			return TMP_NoPresence;
+		}
+		
+		for(Bit = 0; Bit < (ONEWIRE_ROM_LENGTH * 8); Bit++)
+		{
+			if((Branches.Code[Bit >> 3] & (1 << (Bit & 0x07))) && !RomTable_Branch(table, &Entry->Rom, Bit))
+			{
+				return TMP_Error;
+			}
+		}
+	}
+	
+	for(Index = 0; Index < table->Count; Index++)
+	{
+		Entry = &table->Device[Index];
+		
+		ReturnState = TemperatureBus_GetConfig(bus, &Entry->Rom, &High, &Low, &Resolution);
+		
+		if(ReturnState)
+		{
+			return ReturnState;
+		}
+		
+		if((High != Entry->High) || (Low != Entry->Low) || (Resolution != Entry->Resolution))
+		{
+			ReturnState = RomTable_Configure(bus, Entry);
+			
+			if(ReturnState)
+			{
+				return ReturnState;
+			}
+		}
+	}
+	
+	RomTable_ConvertionTime(bus, table);
+	
+	return TMP_Success;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Search the bus and fill the table with the sensors found and
+///	the configuration they are running with. Sensors whose scratch pad
+///	can't be read are left out.
+///
+///	\param bus the bus
+///	\param table the table to fill
+///	\return how many sensors are in the table
+/////////////////////////////////////////////////////////////////////////
+uint8_t RomTableBus_Search(TemperatureBusType *bus, RomTableType *table)
+{
+	OneWireSearchType Search;
+	RomTableEntryType *Entry;
+	
+	table->Count = 0;
+	Temperature_SearchInit(&Search);
+	
+	while(table->Count < ROMTABLE_MAX_DEVICES)
+	{
+		Entry = &table->Device[table->Count];
+		
+		if(OneWireBus_SearchNext(bus->Bus, &Search, &Entry->Rom))
+		{
+			break;
+		}
+		
+		if(!TemperatureBus_GetConfig(bus, &Entry->Rom, &Entry->High, &Entry->Low, &Entry->Resolution))
+		{
+			table->Count++;
+		}
+		
+		if(Search.LastDevice)
+		{
+			break;
+		}
+	}
+	
+	RomTable_ConvertionTime(bus, table);
+	
+	return table->Count;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Get the table ready after a restart. The saved table is
+///	loaded and checked against the bus. Only if that fails, ie. a sensor
+///	has gone or been added, is the bus searched and the new table saved.
+///
+///	\param bus the bus
+///	\param table the table to fill
+///	\param storage where the table is saved
+///	\param context passed to the storage operations
+///	\return RT_Verified if the saved table was used else RomTableStartEnum
+/////////////////////////////////////////////////////////////////////////
+RomTableStartEnum RomTableBus_Start(TemperatureBusType *bus, RomTableType *table, const RomTableStorageOpsType *storage, void *context)
+{
+	if(!RomTable_Load(table, storage, context) && table->Count && !RomTableBus_Verify(bus, table))
+	{
+		return RT_Verified;
+	}
+	
+	if(!RomTableBus_Search(bus, table))
+	{
+		return RT_NoDevices;
+	}
+	
+	if(RomTable_Save(table, storage, context))
+	{
+		return RT_NotSaved;
+	}
+	
+	return RT_Searched;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Check every sensor in the table is still on the default bus
+///	\sa RomTableBus_Verify
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum RomTable_Verify(const RomTableType *table)
+{
+	return RomTableBus_Verify(&TemperatureDefaultBus, table);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Search the default bus in to the table
+///	\sa RomTableBus_Search
+/////////////////////////////////////////////////////////////////////////
+uint8_t RomTable_Search(RomTableType *table)
+{
+	return RomTableBus_Search(&TemperatureDefaultBus, table);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Get the table of the default bus ready after a restart
+///	\sa RomTableBus_Start
+/////////////////////////////////////////////////////////////////////////
+RomTableStartEnum RomTable_Start(RomTableType *table, const RomTableStorageOpsType *storage, void *context)
+{
+	return RomTableBus_Start(&TemperatureDefaultBus, table, storage, context);
+}
+
+#if ROMTABLE_FILE_STORAGE
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read the saved table from a file
+///
+///	\param context the file name
+///	\param destination where to put the bytes
+///	\param length most bytes to read
+///	\return bytes read. 0 if there is no file
+/////////////////////////////////////////////////////////////////////////
+static uint_fast16_t RomTableFile_Load(void *context, uint8_t *destination, uint_fast16_t length)
+{
+	FILE *File = fopen((const char *)context, "rb");
+	size_t Length;
+	
+	if(!File)
+	{
+		return 0;
+	}
+	
+	Length = fread(destination, 1, length, File);
+	fclose(File);
+	
+	return (uint_fast16_t)Length;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Replace the file with the table
+///
+///	\param context the file name
+///	\param source the bytes to save
+///	\param length how many bytes
+///	\return FALSE on success else TRUE
+/////////////////////////////////////////////////////////////////////////
+static uint_fast8_t RomTableFile_Save(void *context, const uint8_t *source, uint_fast16_t length)
+{
+	FILE *File = fopen((const char *)context, "wb");
+	uint_fast8_t Error;
+	
+	if(!File)
+	{
+		return TRUE;
+	}
+	
+	Error = (fwrite(source, 1, length, File) != length);
+	
+	if(fclose(File))
+	{
+		Error = TRUE;
+	}
+	
+	return Error;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	File storage for the host
+/////////////////////////////////////////////////////////////////////////
+const RomTableStorageOpsType RomTableFileOps =
+{
+	RomTableFile_Load,
+	RomTableFile_Save
+};
+#endif
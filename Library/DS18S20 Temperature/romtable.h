@@ -0,0 +1,172 @@
+////////////////////////////////////////////////////////////////////////////////
+/// \file	romtable.h
+///	\brief saved table of the sensors on a bus so a restart only has to
+///	check them instead of searching the bus again.
+///
+///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
+///	Website: www.HashDefineElectronics.com
+///
+///	Licences:
+///
+///		Copyright (c) 2014 Ronald Alexander Nobrega De Sousa
+///
+///		Permission is hereby granted, free of charge, to any person obtaining a copy
+///		of this software and associated documentation files (the "Software"), to deal
+///		in the Software without restriction, including without limitation the rights
+///		to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+///		copies of the Software, and to permit persons to whom the Software is
+///		furnished to do so, subject to the following conditions:
+///
+///		The above copyright notice and this permission notice shall be included in
+///		all copies or substantial portions of the Software.
+///
+///		THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///		IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///		FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///		AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///		LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///		THE SOFTWARE.
+///
+///
+///	Warm Start Code Example:
+///	\code
+///	#include "romtable.h"
+///
+///	static RomTableType Sensors;
+///
+///	void main(void)
+///	{
+///		float Temperatures[ROMTABLE_MAX_DEVICES];
+///		uint8_t Index;
+///
+///		Temperature_Init();
+///
+///		// Check the saved sensors, only search the bus if they changed
+///		if(RT_NoDevices == RomTable_Start(&Sensors, &RomTableFileOps, "sensors.bin"))
+///			{
+///				printf("No sensors\r\n");
+///			}
+///
+///		for( ;; )
+///		{
+///			Temperature_RequestConvertion();
+///			// ... wait for the conversion
+///
+///			for(Index = 0; Index < Sensors.Count; Index++)
+///			{
+///				Temperature_ReadDevice(&Sensors.Device[Index].Rom, &Temperatures[Index]);
+///			}
+///		}
+///	}
+///	\endcode
+////////////////////////////////////////////////////////////////////////////////
+#ifndef __ROM_TABLE_H__
+#define __ROM_TABLE_H__
+	#include "temperature.h"
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Saved table format version. Tables saved with any other
+	///	version are ignored and the bus is searched again.
+	/////////////////////////////////////////////////////////////////////////
+	#define ROMTABLE_VERSION 1
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Most sensors the table holds
+	/////////////////////////////////////////////////////////////////////////
+	#ifndef ROMTABLE_MAX_DEVICES
+		#define ROMTABLE_MAX_DEVICES 16
+	#endif
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Saved bytes per sensor. ROM code, resolution, TH and TL
+	/////////////////////////////////////////////////////////////////////////
+	#define ROMTABLE_ENTRY_LENGTH (ONEWIRE_ROM_LENGTH + 3)
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Saved bytes for a table of count sensors. Version, count,
+	///	the sensors and the CRC.
+	/////////////////////////////////////////////////////////////////////////
+	#define ROMTABLE_LENGTH(count) (3U + ((count) * ROMTABLE_ENTRY_LENGTH))
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Size of the storage needed for a full table
+	/////////////////////////////////////////////////////////////////////////
+	#define ROMTABLE_MAX_LENGTH ROMTABLE_LENGTH(ROMTABLE_MAX_DEVICES)
+	
+	#if ROMTABLE_MAX_LENGTH > 255
+		#error "ROMTABLE_MAX_DEVICES is too big for the 8 bit CRC length"
+	#endif
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Compile the file storage. On by default in the simulation
+	///	build that runs on the host.
+	/////////////////////////////////////////////////////////////////////////
+	#ifndef ROMTABLE_FILE_STORAGE
+		#ifdef ONEWIRE_SIMULATION
+			#define ROMTABLE_FILE_STORAGE 1
+		#else
+			#define ROMTABLE_FILE_STORAGE 0
+		#endif
+	#endif
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	One sensor and the configuration it should run with
+	/////////////////////////////////////////////////////////////////////////
+	typedef struct
+	{
+		OneWireRomType Rom;					///< Sensor ROM code
+		uint8_t Resolution;					///< Resolution in bits. 0 for the fixed resolution DS18S20
+		int8_t High;						///< Alarm high threshold (TH) in degree C
+		int8_t Low;							///< Alarm low threshold (TL) in degree C
+	} RomTableEntryType;
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	The sensors on one bus
+	/////////////////////////////////////////////////////////////////////////
+	typedef struct
+	{
+		uint8_t Count;						///< Sensors in the table
+		RomTableEntryType Device[ROMTABLE_MAX_DEVICES];	///< The sensors
+	} RomTableType;
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Where the table is kept, ie. flash, EEPROM or a file. Every
+	///	call gets the context given with the table.
+	/////////////////////////////////////////////////////////////////////////
+	typedef struct
+	{
+		uint_fast16_t (*Load)(void *context, uint8_t *destination, uint_fast16_t length);		///< Read up to length saved bytes. Returns how many were read, 0 when nothing is saved
+		uint_fast8_t (*Save)(void *context, const uint8_t *source, uint_fast16_t length);		///< Replace the saved bytes. TRUE on failure
+	} RomTableStorageOpsType;
+	
+	////////////////////////////////////////////////////////////////////////////////
+	///	\brief How the table was started
+	////////////////////////////////////////////////////////////////////////////////
+	typedef enum{
+		RT_Verified = 0,			///< The saved table matched the bus
+		RT_Searched,				///< The saved table was missing or out of date. The bus was searched and the new table saved
+		RT_NotSaved,				///< The bus was searched but the new table couldn't be saved
+		RT_NoDevices				///< The bus was searched and no sensor answered
+	} RomTableStartEnum;
+	
+#if ROMTABLE_FILE_STORAGE
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	File storage for the host. The context is the file name.
+	/////////////////////////////////////////////////////////////////////////
+	extern const RomTableStorageOpsType RomTableFileOps;
+#endif
+	
+	uint_fast16_t RomTable_Serialise(const RomTableType *table, uint8_t *destination, uint_fast16_t length);
+	uint_fast8_t RomTable_Deserialise(RomTableType *table, const uint8_t *source, uint_fast16_t length);
+	uint_fast8_t RomTable_Save(const RomTableType *table, const RomTableStorageOpsType *storage, void *context);
+	uint_fast8_t RomTable_Load(RomTableType *table, const RomTableStorageOpsType *storage, void *context);
+	TemperatureRespoceEnum RomTableBus_Verify(TemperatureBusType *bus, const RomTableType *table);
+	uint8_t RomTableBus_Search(TemperatureBusType *bus, RomTableType *table);
+	RomTableStartEnum RomTableBus_Start(TemperatureBusType *bus, RomTableType *table, const RomTableStorageOpsType *storage, void *context);
+	
+	TemperatureRespoceEnum RomTable_Verify(const RomTableType *table);
+	uint8_t RomTable_Search(RomTableType *table);
+	RomTableStartEnum RomTable_Start(RomTableType *table, const RomTableStorageOpsType *storage, void *context);
+
+#endif
@@ -1,7 +1,8 @@
 /////////////////////////////////////////////////////////////////////////
 ///	\file	temperature.c
-///	\brief interface code for 1 wire Temperature sensor (DS18S20). This was written
-///		to talk to a single sensor and not multiple. 
+///	\brief interface code for 1 wire Temperature sensor (DS18S20). The DS18B20 and
+///		DS1822 are also supported, the sensor family code picks how the scratch
+///		pad is decoded. Calls that take a NULL ROM talk to a single sensor.
 ///
 ///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
 ///	Website: www.HashDefineElectronics.com
@@ -32,6 +33,16 @@
 #include "temperature.h"
 #include "onewire.h"
 
+/////////////////////////////////////////////////////////////////////////
+///	\brief	The simulation build waits on the simulated bus time unless
+///	the application has its own clock
+/////////////////////////////////////////////////////////////////////////
+#if defined(ONEWIRE_SIMULATION) && !defined(TEMPERATURE_MILLIS)
+	#include "onewiresim.h"
+	#define TEMPERATURE_MILLIS() ((uint32_t)(OneWireSimBus.TimeNs / 1000000))
+	#define TEMPERATURE_SLEEP_MS(ms) OneWireSim_Delay(&OneWireSimBus, (ms) * 1000UL)
+#endif
+
 /////////////////////////////////////////////////////////////////////////
 ///	\brief	DS18S20 internal ROM and function commands.
 ///	for a more extensive information on the DS18S20 commands then see the
@@ -55,181 +66,1330 @@ enum DS18S20Enum{
 };
 
 /////////////////////////////////////////////////////////////////////////
-///	\brief	Initialize the temperature sensor
+///	\brief	The sensors on the default bus. Set up by Temperature_Init()
 /////////////////////////////////////////////////////////////////////////
-void Temperature_Init(void)
+TemperatureBusType TemperatureDefaultBus;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	DS18B20 configuration register bits that are always set
+/////////////////////////////////////////////////////////////////////////
+static const uint8_t ConfigReserved = 0x1F;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Position of the resolution bits in the configuration register
+/////////////////////////////////////////////////////////////////////////
+static const uint8_t ConfigResolutionShift = 5;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	DS18B20 power up configuration, 12 bit. Written when the
+///	family of the sensors is unknown.
+/////////////////////////////////////////////////////////////////////////
+static const uint8_t ConfigDefault = 0x7F;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Get the sensor family code
+///
+///	\param bus the bus
+///	\param rom the sensor or NULL for the single sensor. Its family is
+///		read by TemperatureBus_Init()
+///	\return the family code or 0 when it's unknown, ie. on a multidrop
+///		bus. Reads decode an unknown family as a DS18S20, writes have to
+///		suit every family.
+/////////////////////////////////////////////////////////////////////////
+static uint8_t Temperature_Family(TemperatureBusType *bus, const OneWireRomType *rom)
 {
-	OneWire_Init();
+	if(rom)
+	{
+		return rom->Code[0];
+	}
+	
+	return bus->Family;
 }
 
 /////////////////////////////////////////////////////////////////////////
-///	\brief	sensor serial number
+///	\brief	Check if the sensor has a configuration register, ie. a 
+///	DS18B20 class sensor with selectable resolution.
 ///
-///		format: <BYTE 0> device family code
-///				<BYTE 1 - 6> Serial Num. Byte 1  is MSB
-///				<BYTE 7> CheckSum.
-///	
-///	\param destination pointer to return the device 8 byte serial number. 
-///	\return FALSE on success else TRUE error
+///	\param family the sensor family code
+///	\return TRUE if it has the configuration register
 /////////////////////////////////////////////////////////////////////////
-TemperatureRespoceEnum Temperature_GetSerialNumber(uint8_t * destination)
+static uint_fast8_t Temperature_HasConfig(uint8_t family)
 {
-	uint8_t Index = 0;
-	
-	if(OneWire_Reset() || OneWire_Write(DS18S20_READ_ROM))
-	{ 
-		
-		return TMP_Error;
-	}
-	// Read sensor scratch pad
-	for(Index = 0; Index < SERIAL_LENGTH; Index++)
+	return (TMP_FAMILY_DS18B20 == family) || (TMP_FAMILY_DS1822 == family);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Map a 1-Wire error to the matching result
+///
+///	\param error OneWireErrorEnum error
+///	\return the TemperatureRespoceEnum result
+/////////////////////////////////////////////////////////////////////////
+static TemperatureRespoceEnum Temperature_Result(int_fast8_t error)
+{
+	switch(error)
 	{
-		 //get the array of data from sensor
-		if(OneWire_Read(&destination[Index]))
-		{ 
+		case OW_Success:
+			return TMP_Success;
+		case OW_Timeout:
+			return TMP_Timeout;
+		case OW_NoPresence:
+			return TMP_NoPresence;
+		case OW_CRCError:
+			return TMP_CRCError;
+		default:
 			return TMP_Error;
-		}		
 	}
-	
-	// verify CRC. if it return zero then we have the correct
-	// CRC else its a mistmatch
-	if(!OneWire_CalculateCRC(&destination[0], SERIAL_LENGTH))
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	How long the conversion on the bus takes. The worst case
+///	until the resolution of the sensors is known.
+///
+///	\param bus the bus
+///	\return the conversion time in ms
+/////////////////////////////////////////////////////////////////////////
+static uint16_t Temperature_BusConvertionTime(const TemperatureBusType *bus)
+{
+	if(bus->ConvertionTime)
 	{
-		return TMP_Success;
+		return bus->ConvertionTime;
 	}
 	
-	return TMP_Error;
+	return Temperature_ConvertionTime(bus->Family, 0);
 }
 
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Check if the bus was reset for anything else since the
+///	conversion request. The sensors only answer the read slots with the
+///	conversion status straight after CONVERT_T, after a reset the line
+///	idles high and reads done whether they are or not.
+///
+///	\param bus the bus
+///	\return TRUE if the read slot can't be trusted
+/////////////////////////////////////////////////////////////////////////
+static uint_fast8_t Temperature_BusUsed(const TemperatureBusType *bus)
+{
+	return bus->ConvertionPending && (bus->Bus->ResetCount != bus->ConvertionResets);
+}
 
 /////////////////////////////////////////////////////////////////////////
-///	\brief	Non-Blocking. Request all connected devices to start
-///		converting temperature.
+///	\brief	Check if the conversion has finished. The sensors hold the
+///	read slot low while they are converting. With several sensors on
+///	the bus this only reads done when all of them are done.
+///
+///	With TEMPERATURE_MILLIS() the read slot is only sent once the
+///	conversion is close to its deadline and then every
+///	TEMPERATURE_POLL_MS. Until then it reads busy without using the bus.
 ///
-///	\return FALSE on success else TRUE error
+///	If the bus was used for anything else since the request the read slot
+///	is no use, see Temperature_BusUsed(). The conversion is then done once
+///	the full conversion time has passed. Without TEMPERATURE_MILLIS() that
+///	can't be known, so it stays busy until TemperatureBus_ConvertionEnd()
+///	or a new request.
+///
+///	\param bus the bus
+///	\return TMP_Busy = Stil processing, TMP_Success or TMP_Timeout
 /////////////////////////////////////////////////////////////////////////
-TemperatureRespoceEnum Temperature_RequestConvertion(void)
+TemperatureRespoceEnum TemperatureBus_ConvertionDone(TemperatureBusType *bus)
 {
-	// Reset device, Skip ROM identification and request temperature conversion
-	if(OneWire_Reset() || OneWire_Write(DS18S20_SKIP_ROM) || OneWire_Write(DS18S20_CONVERT_T))
-	{ 
+	uint8_t Data = 0;
+	int_fast8_t Error;
+	
+#ifdef TEMPERATURE_MILLIS
+	uint32_t Now = TEMPERATURE_MILLIS();
+	
+	if(Temperature_BusUsed(bus))
+	{
+		if((int32_t)(Now - bus->ConvertionDue) < 0)
+		{
+			return TMP_Busy;
+		}
 		
-		return TMP_Error;
+		bus->ConvertionPending = FALSE;
+		
+		return TMP_Success;
+	}
+	
+	if(bus->ConvertionPending)
+	{
+		if((int32_t)(Now - bus->ConvertionPoll) < 0)
+		{
+			return TMP_Busy; // Too early. Leave the bus to the other devices
+		}
+		
+		bus->ConvertionPoll = Now + TEMPERATURE_POLL_MS;
+	}
+#else
+	if(Temperature_BusUsed(bus))
+	{
+		return TMP_Busy;
+	}
+#endif
+	
+	// The sensor return zero if its still processing data otherwise we can continue
+	Error = OneWireBus_Read(bus->Bus, &Data);
+	
+	if(Error)
+	{
+		return Temperature_Result(Error); // Error. the device didn't respond. 
 	}
 	
+	if(!Data)
+	{
+		return TMP_Busy;
+	}
+	
+	bus->ConvertionPending = FALSE;
+	
 	return TMP_Success;
 }
-	
+
 /////////////////////////////////////////////////////////////////////////
-///	\brief	a non-blocking method to Get Temperature from sensor.
-///		You will need to call Temperature_RequestConvertion() to invoke
-///		tempreature convertion.
-///
-///	\param temperature pointer to return the sensor temperature
-///	\return TMP_Busy = Stil processing, TMP_Success or TMP_Error
+///	\brief	Sleep until the conversion is due to be polled again. Does
+///	nothing without TEMPERATURE_MILLIS().
 ///
-///	\note the DS18S20 take 750ms to convert temperature.
-///	\sa TemperatureRespoceEnum Temperature_RequestConvertion
+///	\param bus the bus
 /////////////////////////////////////////////////////////////////////////
-TemperatureRespoceEnum Temperature_NonBlockingRead(float *temperature)
+static void Temperature_Sleep(const TemperatureBusType *bus)
 {
-	uint8_t ReadData[9];
-	uint8_t *ReadDataPointer;
-	TypeCon dataTemp;
-	uint8_t CalculatedCRC = 0;
-  uint8_t Index = 0;
-
-
-	// The sensor return zero if its still processing data otherwise we can continue
-	if(OneWire_Read(&Index))
+	uint32_t Wait = TemperatureBus_ConvertionWait(bus);
+	
+#ifdef TEMPERATURE_MILLIS
+	#ifdef TEMPERATURE_SLEEP_MS
+	if(Wait)
 	{
-		return TMP_Error; // Error. the device didn't respond. 
+		TEMPERATURE_SLEEP_MS(Wait);
 	}
+	#else
+	uint32_t Start = TEMPERATURE_MILLIS();
 	
-	if(!Index)
+	while((TEMPERATURE_MILLIS() - Start) < Wait)
 	{
-		return TMP_Busy;
 	}
-		
+	#endif
+#else
+	(void)Wait;
+#endif
+}
 
-	// Reset device, Skip ROM identification and request temperature conversion
-	if(OneWire_Reset() || OneWire_Write(DS18S20_SKIP_ROM) || OneWire_Write(DS18S20_READ_SCRATCHPAD))
-	{ 
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Reset the bus, address the sensor and send a function
+///	command. The whole command is streamed in one block.
+///
+///	\param bus the bus
+///	\param rom the sensor to address or NULL to skip ROM
+///	\param command the function command
+///	\return OW_Success or the OneWireErrorEnum error
+/////////////////////////////////////////////////////////////////////////
+static int_fast8_t Temperature_Command(TemperatureBusType *bus, const OneWireRomType *rom, uint8_t command)
+{
+	uint8_t Command[ONEWIRE_ROM_LENGTH + 2];
+	uint8_t Length = 0;
+	uint8_t Index;
+	int_fast8_t Error;
+	
+	if(rom)
+	{
+		Command[Length++] = DS18S20_MATCH_ROM;
 		
-		return TMP_Error; //error
+		for(Index = 0; Index < ONEWIRE_ROM_LENGTH; Index++)
+		{
+			Command[Length++] = rom->Code[Index];
+		}
 	}
-		
-	// Reset pointer
-	ReadDataPointer = &ReadData[0];
-	  
-	// Read sensor scratch pad
-	for(Index = 0; Index < 9; Index++)
+	else
 	{
-		 //get the array of data from sensor
-		if(OneWire_Read(ReadDataPointer))
-		{ 
-			return TMP_Error; //error
-		}		
-		// Increment pointer
-		ReadDataPointer++;
+		Command[Length++] = DS18S20_SKIP_ROM;
 	}
-	  
-	// calculate the CRC value
-	CalculatedCRC  = OneWire_CalculateCRC(&ReadData[0], 8);
 	
-	// Convert data to obtain the higher resolution we need
-	ReadData[0] = ReadData[0] >> 1;
-			
-	//is it negative?
-	if(ReadData[1])
+	Command[Length++] = command;
+	
+	Error = OneWireBus_Reset(bus->Bus);
+	
+	if(Error)
+	{
+		return Error;
+	}
+	
+	return OneWireBus_WriteBlock(bus->Bus, &Command[0], Length);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Send a command with the bus retry policy
+///
+///	\param bus the bus
+///	\param rom the sensor to address or NULL to skip ROM
+///	\param command the function command
+///	\return TMP_Success or the error of the last attempt
+/////////////////////////////////////////////////////////////////////////
+static TemperatureRespoceEnum Temperature_Send(TemperatureBusType *bus, const OneWireRomType *rom, uint8_t command)
+{
+	uint8_t Attempt = 0;
+	int_fast8_t Error;
+	
+	do
 	{
-		ReadData[0] -= 0x80;
+		Error = Temperature_Command(bus, rom, command);
 	}
+	while(Error && !OneWireBus_Retry(bus->Bus, &Attempt));
+	
+	return Temperature_Result(Error);
+}
 
-	dataTemp._uint8[0] = ReadData[0];
+/////////////////////////////////////////////////////////////////////////
+///	\brief	One attempt at reading the scratch pad
+///
+///	\param bus the bus
+///	\param rom the sensor or NULL for the single sensor
+///	\param scratchpad array to return the 9 scratch pad bytes
+///	\return OW_Success or the OneWireErrorEnum error
+/////////////////////////////////////////////////////////////////////////
+static int_fast8_t Temperature_ReadScratchpadOnce(TemperatureBusType *bus, const OneWireRomType *rom, uint8_t *scratchpad)
+{
+	uint8_t CRC = OneWire_CRCInit();
+	
+	// Reset device, address it and request the scratch pad
+	int_fast8_t Error = Temperature_Command(bus, rom, DS18S20_READ_SCRATCHPAD);
+	
+	if(Error)
+	{ 
+		return Error;
+	}
+	  
+	// Read sensor scratch pad. The CRC is worked out as the bytes arrive
+	Error = OneWireBus_ReadBlockCRC(bus->Bus, &scratchpad[0], TMP_SCRATCHPAD_LENGTH, &CRC);
+	
+	if(Error)
+	{ 
+		return Error;
+	}
+	
+	// Do the CRC match? Including the CRC byte it comes out as zero
+	if(OneWire_CRCFinal(CRC))
+	{
+		ONEWIRE_STATS_ADD(bus->Bus, CRCFailures, 1);
+		return OW_CRCError;
+	}
+	
+	return OW_Success;
+}
 
-	// Calculate temperature
-	*temperature = ReadData[7] - ReadData[6];
-	*temperature /= ReadData[7];
-	*temperature = (dataTemp._int8[0] - 0.25) + *temperature;
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read the sensor scratch pad and check its CRC. Failed reads
+///	are retried with the bus retry policy.
+///
+///	\param bus the bus
+///	\param rom the sensor or NULL for the single sensor
+///	\param scratchpad array to return the 9 scratch pad bytes
+///	\return TMP_Success or the error of the last attempt
+/////////////////////////////////////////////////////////////////////////
+static TemperatureRespoceEnum Temperature_ReadScratchpad(TemperatureBusType *bus, const OneWireRomType *rom, uint8_t *scratchpad)
+{
+	uint8_t Attempt = 0;
+	int_fast8_t Error;
 	
-	// Do the CRC match?
-	if(CalculatedCRC == ReadData[8])
+	do
 	{
-		return TMP_Success;
+		Error = Temperature_ReadScratchpadOnce(bus, rom, scratchpad);
 	}
+	while(Error && !OneWireBus_Retry(bus->Bus, &Attempt));
+	
+	return Temperature_Result(Error);
+}
 
-	return TMP_Error;
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Write the sensor scratch pad. The DS18S20 only takes TH and
+///	TL, the DS18B20 class sensors also take the configuration register.
+///	When the family is unknown all three bytes are sent, a DS18S20 
+///	ignores the last one and a DS18B20 would corrupt its scratch pad
+///	without it.
+///
+///	\param bus the bus
+///	\param rom the sensor or NULL for the single sensor
+///	\param high alarm high threshold (TH)
+///	\param low alarm low threshold (TL)
+///	\param config configuration register
+///	\return TMP_Success or the error of the last attempt
+/////////////////////////////////////////////////////////////////////////
+static TemperatureRespoceEnum Temperature_WriteScratchpad(TemperatureBusType *bus, const OneWireRomType *rom, uint8_t high, uint8_t low, uint8_t config)
+{
+	uint8_t Data[3];
+	uint8_t Length = 2;
+	uint8_t Family = Temperature_Family(bus, rom);
+	uint8_t Attempt = 0;
+	int_fast8_t Error;
+	
+	Data[0] = high;
+	Data[1] = low;
+	Data[2] = config;
+	
+	if(!Family || Temperature_HasConfig(Family))
+	{
+		Length = 3;
+	}
+	
+	do
+	{
+		Error = Temperature_Command(bus, rom, DS18S20_WRITE_SCRATCHPAD);
+		
+		if(!Error)
+		{
+			Error = OneWireBus_WriteBlock(bus->Bus, &Data[0], Length);
+		}
+	}
+	while(Error && !OneWireBus_Retry(bus->Bus, &Attempt));
 	
+	return Temperature_Result(Error);
 }
 
 /////////////////////////////////////////////////////////////////////////
-///	\brief	This function will request and get temperature from sensor.
-///		this is a blocking function.
+///	\brief	Get the conversion time of the only sensor on the bus from
+///	its configuration register. On a multidrop bus it's left unknown, so
+///	the conversions wait the worst case until
+///	TemperatureBus_SetResolution() is used.
 ///
-///	\param temperature pointer to return the sensor temperature
-///	\return TMP_Success or TMP_Error
+///	\param bus the bus
+/////////////////////////////////////////////////////////////////////////
+static void Temperature_ReadConvertionTime(TemperatureBusType *bus)
+{
+	int8_t High;
+	int8_t Low;
+	uint8_t Resolution;
+	
+	bus->ConvertionTime = 0;
+	
+	if(!bus->Family || TemperatureBus_GetConfig(bus, 0, &High, &Low, &Resolution))
+	{
+		return;
+	}
+	
+	bus->ConvertionTime = Temperature_ConvertionTime(bus->Family, Resolution);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Initialize the temperature sensors on a bus. If there is 
+///	only one sensor on the bus its family code is read so that the calls
+///	with a NULL ROM decode it correctly, along with how long its
+///	conversion takes.
 ///
-///	\note the DS18S20 take 750ms to convert temperature.
+///	\param bus the temperature sensors state
+///	\param oneWireBus the 1-Wire bus they are on. Already set up with
+///		OneWireBus_Init()
 /////////////////////////////////////////////////////////////////////////
-TemperatureRespoceEnum Temperature_BlockingRead(float *temperature)
-{	
+void TemperatureBus_Init(TemperatureBusType *bus, OneWireBusType *oneWireBus)
+{
+	uint8_t Serial[SERIAL_LENGTH];
 	
-	TemperatureRespoceEnum ReturnState;
+	bus->Bus = oneWireBus;
+	bus->Family = 0;
+	bus->ConvertionTime = 0;
+	bus->ConvertionPending = FALSE;
+	bus->ConvertionPoll = 0;
+	bus->ConvertionDue = 0;
+	bus->ConvertionResets = 0;
 	
-	if(Temperature_RequestConvertion()) // Request temperature from the sensors
+	if(!TemperatureBus_GetSerialNumber(bus, &Serial[0]))
 	{
-		return TMP_Error;
+		bus->Family = Serial[0];
 	}
+	
+	Temperature_ReadConvertionTime(bus);
+}
 
-	for( ;; ) // Wait until the sensor has converted the temperature
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Get a search state ready to enumerate the sensors on the bus.
+///	Then use OneWire_SearchRom() or OneWire_SearchNext() to fill the
+///	ROM table.
+///
+///	\param search the search state
+/////////////////////////////////////////////////////////////////////////
+void Temperature_SearchInit(OneWireSearchType *search)
+{
+	OneWire_SearchInit(search, DS18S20_SEARCH_ROM);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Get a search state ready to find only the sensors with their
+///	alarm flag set, ie. the last temperature was above TH or below TL.
+///	Then use OneWire_SearchRom() or OneWire_SearchNext() as normal.
+///
+///	\param search the search state
+/////////////////////////////////////////////////////////////////////////
+void Temperature_AlarmSearchInit(OneWireSearchType *search)
+{
+	OneWire_SearchInit(search, DS18S20_ALARM_SEARCH);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Set the sensor alarm thresholds. The values are only kept
+///	in the scratch pad, use Temperature_SaveAlarm() to keep them
+///	after a power cycle.
+///
+///	The DS18B20 class sensors take their configuration register in the
+///	same write, so it's read back first to keep it. That read needs the
+///	sensor addressed, so on a multidrop bus program each sensor with its
+///	ROM. A NULL ROM on a bus of unknown family can't read it and puts
+///	every DS18B20 class sensor back to 12 bit.
+///
+///	\param bus the bus
+///	\param rom the sensor to program or NULL for all the sensors
+///	\param high the alarm high threshold (TH) in degree C
+///	\param low the alarm low threshold (TL) in degree C
+///	\return TMP_Success or the TemperatureRespoceEnum error
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum TemperatureBus_SetAlarm(TemperatureBusType *bus, const OneWireRomType *rom, int8_t high, int8_t low)
+{
+	uint8_t Scratchpad[TMP_SCRATCHPAD_LENGTH];
+	uint8_t Family = Temperature_Family(bus, rom);
+	TemperatureRespoceEnum ReturnState;
+	
+	Scratchpad[4] = ConfigDefault;
+	
+	// Keep the configuration register as it is
+	if(Temperature_HasConfig(Family))
 	{
-		ReturnState = Temperature_NonBlockingRead(temperature);
+		ReturnState = Temperature_ReadScratchpad(bus, rom, &Scratchpad[0]);
 		
-		if(TMP_Busy != ReturnState)
+		if(ReturnState)
 		{
 			return ReturnState;
 		}
-		
 	}
+	
+	ReturnState = Temperature_WriteScratchpad(bus, rom, (uint8_t)high, (uint8_t)low, Scratchpad[4]);
+	
+	if(!ReturnState && !Family)
+	{
+		// Any DS18B20 class sensor is back to 12 bit, so back to the worst case
+		bus->ConvertionTime = 0;
+	}
+	
+	return ReturnState;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Set the conversion resolution of a DS18B20 class sensor. 
+///	Lower resolution converts faster. The value is only kept in the
+///	scratch pad, use Temperature_SaveAlarm() to keep it after a power
+///	cycle.
+///
+///	\param bus the bus
+///	\param rom the sensor or NULL for the single sensor
+///	\param resolution 9 to 12 bits
+///	\return TMP_Success or TMP_Error. The DS18S20 has a fixed resolution
+///		and always returns an error.
+///
+///	\sa Temperature_ConvertionTime
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum TemperatureBus_SetResolution(TemperatureBusType *bus, const OneWireRomType *rom, uint8_t resolution)
+{
+	uint8_t Scratchpad[TMP_SCRATCHPAD_LENGTH];
+	uint8_t Config;
+	uint16_t Time;
+	TemperatureRespoceEnum ReturnState;
+	
+	if(!Temperature_HasConfig(Temperature_Family(bus, rom)) || (resolution < TMP_RESOLUTION_MIN) || (resolution > TMP_RESOLUTION_MAX))
+	{
+		return TMP_Error;
+	}
+	
+	// Keep the alarm thresholds as they are
+	ReturnState = Temperature_ReadScratchpad(bus, rom, &Scratchpad[0]);
+	
+	if(ReturnState)
+	{
+		return ReturnState;
+	}
+	
+	Config = ((resolution - TMP_RESOLUTION_MIN) << ConfigResolutionShift) | ConfigReserved;
+	
+	ReturnState = Temperature_WriteScratchpad(bus, rom, Scratchpad[2], Scratchpad[3], Config);
+	
+	if(ReturnState)
+	{
+		return ReturnState;
+	}
+	
+	// A single sensor can't shorten the wait, the others may still be slower
+	Time = Temperature_ConvertionTime(Temperature_Family(bus, rom), resolution);
+	
+	if(!rom || (Time > Temperature_BusConvertionTime(bus)))
+	{
+		bus->ConvertionTime = Time;
+	}
+	
+	return TMP_Success;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read the alarm thresholds and the resolution of a sensor
+///	from its scratch pad.
+///
+///	\param bus the bus
+///	\param rom the sensor or NULL for the single sensor
+///	\param high pointer to return the alarm high threshold (TH) in degree C
+///	\param low pointer to return the alarm low threshold (TL) in degree C
+///	\param resolution pointer to return the resolution in bits. 0 for the
+///		fixed resolution DS18S20
+///	\return TMP_Success or the TemperatureRespoceEnum error
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum TemperatureBus_GetConfig(TemperatureBusType *bus, const OneWireRomType *rom, int8_t *high, int8_t *low, uint8_t *resolution)
+{
+	uint8_t Scratchpad[TMP_SCRATCHPAD_LENGTH];
+	TemperatureRespoceEnum ReturnState = Temperature_ReadScratchpad(bus, rom, &Scratchpad[0]);
+	
+	if(ReturnState)
+	{
+		return ReturnState;
+	}
+	
+	*high = (int8_t)Scratchpad[2];
+	*low = (int8_t)Scratchpad[3];
+	*resolution = 0;
+	
+	if(Temperature_HasConfig(Temperature_Family(bus, rom)))
+	{
+		*resolution = TMP_RESOLUTION_MIN + ((Scratchpad[4] >> ConfigResolutionShift) & 0x03);
+	}
+	
+	return TMP_Success;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	How long the sensor takes to convert the temperature
+///
+///	\param family the sensor family code. ie rom->Code[0]
+///	\param resolution 9 to 12 bits. Ignored for the DS18S20
+///	\return the maximum conversion time in ms
+/////////////////////////////////////////////////////////////////////////
+uint16_t Temperature_ConvertionTime(uint8_t family, uint8_t resolution)
+{
+	static const uint16_t ConvertionTime[] = {94, 188, 375, 750};
+	
+	if(!Temperature_HasConfig(family) || (resolution < TMP_RESOLUTION_MIN) || (resolution > TMP_RESOLUTION_MAX))
+	{
+		return ConvertionTime[TMP_RESOLUTION_MAX - TMP_RESOLUTION_MIN];
+	}
+	
+	return ConvertionTime[resolution - TMP_RESOLUTION_MIN];
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Copy the alarm thresholds, and the resolution of DS18B20 class
+///	sensors, from the scratch pad to the sensor EEPROM.
+///
+///	\param bus the bus
+///	\param rom the sensor or NULL for all the sensors
+///	\return TMP_Success or the TemperatureRespoceEnum error
+///
+///	\note the sensor takes up to 10ms to write the EEPROM.
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum TemperatureBus_SaveAlarm(TemperatureBusType *bus, const OneWireRomType *rom)
+{
+	return Temperature_Send(bus, rom, DS18S20_COPY_SCRATCHPAD);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Reload the alarm thresholds, and the resolution of DS18B20
+///	class sensors, from the sensor EEPROM in to the scratch pad.
+///
+///	\param bus the bus
+///	\param rom the sensor or NULL for all the sensors
+///	\return TMP_Success or the TemperatureRespoceEnum error
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum TemperatureBus_RecallAlarm(TemperatureBusType *bus, const OneWireRomType *rom)
+{
+	TemperatureRespoceEnum ReturnState = Temperature_Send(bus, rom, DS18S20_RECAL_E_2);
+	
+	if(!ReturnState)
+	{
+		// The resolution came back from the EEPROM too
+		Temperature_ReadConvertionTime(bus);
+	}
+	
+	return ReturnState;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	sensor serial number
+///
+///		format: <BYTE 0> device family code
+///				<BYTE 1 - 6> Serial Num. Byte 1  is MSB
+///				<BYTE 7> CheckSum.
+///	
+///	\param bus the bus
+///	\param destination pointer to return the device 8 byte serial number. 
+///	\return TMP_Success or the TemperatureRespoceEnum error
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum TemperatureBus_GetSerialNumber(TemperatureBusType *bus, uint8_t * destination)
+{
+	uint8_t Attempt = 0;
+	int_fast8_t Error;
+	
+	do
+	{
+		Error = OneWireBus_Reset(bus->Bus);
+		
+		if(!Error)
+		{
+			Error = OneWireBus_Write(bus->Bus, DS18S20_READ_ROM);
+		}
+		
+		// Read the sensor ROM
+		if(!Error)
+		{
+			Error = OneWireBus_ReadBlock(bus->Bus, &destination[0], SERIAL_LENGTH);
+		}
+		
+		// verify CRC. if it return zero then we have the correct
+		// CRC else its a mistmatch
+		if(!Error && OneWire_CalculateCRC(&destination[0], SERIAL_LENGTH))
+		{
+			ONEWIRE_STATS_ADD(bus->Bus, CRCFailures, 1);
+			Error = OW_CRCError;
+		}
+	}
+	while(Error && !OneWireBus_Retry(bus->Bus, &Attempt));
+	
+	return Temperature_Result(Error);
+}
+
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Non-Blocking. Request all connected devices to start
+///		converting temperature. With TEMPERATURE_MILLIS() the non-blocking
+///		reads leave the bus alone until the conversion is nearly done.
+///
+///	\param bus the bus
+///	\return TMP_Success or the TemperatureRespoceEnum error
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum TemperatureBus_RequestConvertion(TemperatureBusType *bus)
+{
+	// Reset device, Skip ROM identification and request temperature conversion
+	TemperatureRespoceEnum ReturnState = Temperature_Send(bus, 0, DS18S20_CONVERT_T);
+#ifdef TEMPERATURE_MILLIS
+	uint16_t Time = Temperature_BusConvertionTime(bus);
+	uint32_t Now = TEMPERATURE_MILLIS();
+#endif
+	
+	if(ReturnState)
+	{
+		return ReturnState;
+	}
+	
+	bus->ConvertionPending = TRUE;
+	bus->ConvertionResets = bus->Bus->ResetCount;
+	
+#ifdef TEMPERATURE_MILLIS
+	// The sensors are rarely slower than 7/8 of the datasheet maximum
+	bus->ConvertionPoll = Now + Time - (Time >> 3);
+	bus->ConvertionDue = Now + Time;
+#endif
+	
+	return TMP_Success;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Mark the conversion as finished without polling the bus. For
+///	callers that wait out Temperature_ConvertionTime() on their own
+///	timer, so the non-blocking reads use the bus straight away.
+///
+///	\param bus the bus
+/////////////////////////////////////////////////////////////////////////
+void TemperatureBus_ConvertionEnd(TemperatureBusType *bus)
+{
+	bus->ConvertionPending = FALSE;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	How long until the conversion is worth polling. Use it to
+///	sleep, or run other devices on the bus, between the non-blocking
+///	reads. Once the bus has been used for anything else the sensors can
+///	no longer say when they are done, so this is the time left of the
+///	full conversion time instead. Needs TEMPERATURE_MILLIS(), without it
+///	this is always 0.
+///
+///	\param bus the bus
+///	\return ms until the next non-blocking read uses the bus or finishes
+///		the conversion. 0 if it does straight away
+/////////////////////////////////////////////////////////////////////////
+uint32_t TemperatureBus_ConvertionWait(const TemperatureBusType *bus)
+{
+#ifdef TEMPERATURE_MILLIS
+	int32_t Wait = (int32_t)((Temperature_BusUsed(bus) ? bus->ConvertionDue : bus->ConvertionPoll) - TEMPERATURE_MILLIS());
+	
+	if(bus->ConvertionPending && (Wait > 0))
+	{
+		return (uint32_t)Wait;
+	}
+#else
+	(void)bus;
+#endif
+	
+	return 0;
+}
+	
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Convert the scratch pad to temperature
+///
+///	\param family the sensor family code
+///	\param scratchpad the 9 bytes read from the sensor
+///	\return the temperature in degree C
+/////////////////////////////////////////////////////////////////////////
+float Temperature_Decode(uint8_t family, const uint8_t *scratchpad)
+{
+	TypeCon dataTemp;
+	uint8_t Data;
+	float Temperature;
+	
+	if(Temperature_HasConfig(family))
+	{
+		// Clear the bits that are undefined at the lower resolutions
+		Data = (scratchpad[4] >> ConfigResolutionShift) & 0x03;
+		Data = scratchpad[0] & (uint8_t)(0xFF << (3 - Data));
+		
+		// 12 bit two's complement value in 1/16 degree C
+		return (int16_t)(((uint16_t)scratchpad[1] << 8) | Data) / 16.0f;
+	}
+	
+	// Convert data to obtain the higher resolution we need
+	Data = scratchpad[0] >> 1;
+			
+	//is it negative?
+	if(scratchpad[1])
+	{
+		Data -= 0x80;
+	}
+
+	dataTemp._uint8[0] = Data;
+
+	// Calculate temperature
+	Temperature = scratchpad[7] - scratchpad[6];
+	Temperature /= scratchpad[7];
+	Temperature = (dataTemp._int8[0] - 0.25) + Temperature;
+	
+	return Temperature;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Keep a fixed point temperature within int16_t. Only a 
+///	corrupt scratch pad gets anywhere near the limits.
+/////////////////////////////////////////////////////////////////////////
+static int16_t Temperature_Saturate(int32_t temperature)
+{
+	if(temperature > INT16_MAX)
+	{
+		return INT16_MAX;
+	}
+	
+	if(temperature < INT16_MIN)
+	{
+		return INT16_MIN;
+	}
+	
+	return (int16_t)temperature;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Convert the scratch pad to a Q8.8 temperature with integer
+///	math only. Gives Temperature_Decode() times 256 rounded to nearest,
+///	which is exact for every DS18B20 and for the DS18S20 with its 16 
+///	counts per degree.
+///
+///	\param family the sensor family code
+///	\param scratchpad the 9 bytes read from the sensor
+///	\return the temperature in 1/256 degree C
+/////////////////////////////////////////////////////////////////////////
+int16_t Temperature_DecodeFixed(uint8_t family, const uint8_t *scratchpad)
+{
+	TypeCon dataTemp;
+	uint8_t Data;
+	uint8_t CountRemain = scratchpad[6];
+	uint8_t CountPerC = scratchpad[7];
+	int32_t Fraction;
+	
+	if(Temperature_HasConfig(family))
+	{
+		// Clear the bits that are undefined at the lower resolutions
+		Data = (scratchpad[4] >> ConfigResolutionShift) & 0x03;
+		Data = scratchpad[0] & (uint8_t)(0xFF << (3 - Data));
+		
+		// 1/16 degree C to 1/256 degree C
+		dataTemp._uint16[0] = ((uint16_t)scratchpad[1] << 8) | Data;
+		
+		return Temperature_Saturate((int32_t)dataTemp._int16[0] * 16);
+	}
+	
+	// Same whole degrees as the float version
+	Data = scratchpad[0] >> 1;
+	
+	if(scratchpad[1])
+	{
+		Data -= 0x80;
+	}
+	
+	dataTemp._uint8[0] = Data;
+	
+	if(!CountPerC || (CountRemain > CountPerC))
+	{
+		// No usable count remain so fall back to the 1/2 degree C reading
+		return Temperature_Saturate(((int32_t)dataTemp._int8[0] * 2 + (scratchpad[0] & 0x01)) * 128);
+	}
+	
+	// ((whole - 0.25) + (count per C - count remain) / count per C) * 256
+	Fraction = (((int32_t)(CountPerC - CountRemain) << TMP_FIXED_SHIFT) + (CountPerC >> 1)) / CountPerC;
+	
+	return Temperature_Saturate((int32_t)dataTemp._int8[0] * (1 << TMP_FIXED_SHIFT) - 64 + Fraction);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read the temperature from one sensor. Call once the 
+///	conversion has finished.
+///
+///	\param bus the bus
+///	\param rom the sensor to read or NULL if it's the only one on the bus
+///	\param temperature pointer to return the sensor temperature
+///	\return TMP_Success or TMP_Error
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum TemperatureBus_ReadDevice(TemperatureBusType *bus, const OneWireRomType *rom, float *temperature)
+{
+	uint8_t ReadData[TMP_SCRATCHPAD_LENGTH];
+	TemperatureRespoceEnum ReturnState = Temperature_ReadScratchpad(bus, rom, &ReadData[0]);
+	
+	if(ReturnState)
+	{ 
+		return ReturnState; //error
+	}
+	
+	*temperature = Temperature_Decode(Temperature_Family(bus, rom), &ReadData[0]);
+	
+	return TMP_Success;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Same as TemperatureBus_ReadDevice() but in fixed point with
+///	no floating point math at all.
+///
+///	\param bus the bus
+///	\param rom the sensor to read or NULL if it's the only one on the bus
+///	\param temperature pointer to return the sensor temperature in Q8.8,
+///		see TMP_FIXED_SHIFT
+///	\return TMP_Success or TMP_Error
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum TemperatureBus_ReadDeviceFixed(TemperatureBusType *bus, const OneWireRomType *rom, int16_t *temperature)
+{
+	uint8_t ReadData[TMP_SCRATCHPAD_LENGTH];
+	TemperatureRespoceEnum ReturnState = Temperature_ReadScratchpad(bus, rom, &ReadData[0]);
+	
+	if(ReturnState)
+	{ 
+		return ReturnState; //error
+	}
+	
+	*temperature = Temperature_DecodeFixed(Temperature_Family(bus, rom), &ReadData[0]);
+	
+	return TMP_Success;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	One attempt at reading the whole degrees. Only the first two
+///	scratch pad bytes are read, the reset that starts the next command
+///	stops the sensor sending the rest.
+///
+///	\param bus the bus
+///	\param rom the sensor or NULL for the single sensor
+///	\param temperature pointer to return the temperature in whole degree C
+///	\return OW_Success or the OneWireErrorEnum error
+/////////////////////////////////////////////////////////////////////////
+static int_fast8_t Temperature_ReadIntegerOnce(TemperatureBusType *bus, const OneWireRomType *rom, int8_t *temperature)
+{
+	uint8_t ReadData[2];
+	TypeCon dataTemp;
+	int_fast8_t Error = Temperature_Command(bus, rom, DS18S20_READ_SCRATCHPAD);
+	
+	if(!Error)
+	{
+		Error = OneWireBus_ReadBlock(bus->Bus, &ReadData[0], sizeof(ReadData));
+	}
+	
+	if(Error)
+	{
+		return Error;
+	}
+	
+	dataTemp._uint16[0] = ((uint16_t)ReadData[1] << 8) | ReadData[0];
+	
+	if(Temperature_HasConfig(Temperature_Family(bus, rom)))
+	{
+		// 1/16 degree C. The bits that are undefined at the lower resolutions
+		// are all below the whole degrees
+		*temperature = (int8_t)(dataTemp._int16[0] >> 4);
+	}
+	else
+	{
+		// 1/2 degree C
+		*temperature = (int8_t)(dataTemp._int16[0] >> 1);
+	}
+	
+	return OW_Success;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read the temperature of one sensor in whole degrees, rounded
+///	down. Only 2 of the 9 scratch pad bytes are read so it saves 56 slots
+///	per sensor on quick scans, but there is no CRC to catch a corrupt 
+///	reading and a sensor that has gone from a multidrop bus reads -1.
+///	Use TemperatureBus_ReadDevice() when the reading has to be right.
+///
+///	\param bus the bus
+///	\param rom the sensor to read or NULL if it's the only one on the bus
+///	\param temperature pointer to return the temperature in whole degree C
+///	\return TMP_Success or the error of the last attempt
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum TemperatureBus_ReadDeviceInteger(TemperatureBusType *bus, const OneWireRomType *rom, int8_t *temperature)
+{
+	uint8_t Attempt = 0;
+	int_fast8_t Error;
+	
+	do
+	{
+		Error = Temperature_ReadIntegerOnce(bus, rom, temperature);
+	}
+	while(Error && !OneWireBus_Retry(bus->Bus, &Attempt));
+	
+	return Temperature_Result(Error);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	a non-blocking method to Get Temperature from sensor.
+///		You will need to call Temperature_RequestConvertion() to invoke
+///		tempreature convertion.
+///
+///	\param bus the bus
+///	\param temperature pointer to return the sensor temperature
+///	\return TMP_Busy = Stil processing, TMP_Success or TMP_Error
+///
+///	\note the DS18S20 take 750ms to convert temperature.
+///	\sa TemperatureRespoceEnum Temperature_RequestConvertion
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum TemperatureBus_NonBlockingRead(TemperatureBusType *bus, float *temperature)
+{
+	TemperatureRespoceEnum ReturnState = TemperatureBus_ConvertionDone(bus);
+	
+	if(TMP_Success != ReturnState)
+	{
+		return ReturnState;
+	}
+	
+	return TemperatureBus_ReadDevice(bus, 0, temperature);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Same as TemperatureBus_NonBlockingRead() but in fixed point
+///
+///	\param bus the bus
+///	\param temperature pointer to return the sensor temperature in Q8.8
+///	\return TMP_Busy = Stil processing, TMP_Success or TMP_Error
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum TemperatureBus_NonBlockingReadFixed(TemperatureBusType *bus, int16_t *temperature)
+{
+	TemperatureRespoceEnum ReturnState = TemperatureBus_ConvertionDone(bus);
+	
+	if(TMP_Success != ReturnState)
+	{
+		return ReturnState;
+	}
+	
+	return TemperatureBus_ReadDeviceFixed(bus, 0, temperature);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	a non-blocking method to get the temperature from every
+///		sensor in the ROM table. Temperature_RequestConvertion() starts
+///		all the sensors converting in parallel, then once they are done
+///		each scratch pad is read back to back with match ROM.
+///
+///	\param bus the bus
+///	\param table the sensors ROM codes
+///	\param count how many sensors are in the table
+///	\param temperatures array to return each sensor temperature
+///	\param results array to return each sensor result or NULL
+///	\return TMP_Busy = Stil processing, TMP_Success or TMP_Error if any of
+///		the sensors failed
+///
+///	\sa TemperatureRespoceEnum Temperature_RequestConvertion
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum TemperatureBus_NonBlockingReadAll(TemperatureBusType *bus, const OneWireRomType *table, uint8_t count, float *temperatures, TemperatureRespoceEnum *results)
+{
+	TemperatureRespoceEnum ReturnState = TemperatureBus_ConvertionDone(bus);
+	TemperatureRespoceEnum DeviceState;
+	uint8_t Index;
+	
+	if(TMP_Success != ReturnState)
+	{
+		return ReturnState;
+	}
+	
+	for(Index = 0; Index < count; Index++)
+	{
+		DeviceState = TemperatureBus_ReadDevice(bus, &table[Index], &temperatures[Index]);
+		
+		if(results)
+		{
+			results[Index] = DeviceState;
+		}
+		
+		if(TMP_Success != DeviceState)
+		{
+			ReturnState = TMP_Error;
+		}
+	}
+	
+	return ReturnState;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	This function will request and get temperature from sensor.
+///		this is a blocking function.
+///
+///	\param bus the bus
+///	\param temperature pointer to return the sensor temperature
+///	\return TMP_Success or the error. TMP_Timeout if the sensor is still
+///		busy after OneWireBus_BusyPolls() polls.
+///
+///	\note the DS18S20 take 750ms to convert temperature. With
+///		TEMPERATURE_MILLIS() that time is slept through instead of polling
+///		the bus.
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum TemperatureBus_BlockingRead(TemperatureBusType *bus, float *temperature)
+{	
+	uint32_t Polls = OneWireBus_BusyPolls(bus->Bus);
+	TemperatureRespoceEnum ReturnState = TemperatureBus_RequestConvertion(bus); // Request temperature from the sensors
+	
+	if(ReturnState)
+	{
+		return ReturnState;
+	}
+
+	for( ;; ) // Wait until the sensor has converted the temperature
+	{
+		ReturnState = TemperatureBus_NonBlockingRead(bus, temperature);
+		
+		if(TMP_Busy != ReturnState)
+		{
+			return ReturnState;
+		}
+		
+		if(!Polls)
+		{
+			return TMP_Timeout;
+		}
+		
+		Polls--;
+		Temperature_Sleep(bus);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	This function will request and get temperature from every
+///		sensor in the ROM table. this is a blocking function.
+///
+///	\param bus the bus
+///	\param table the sensors ROM codes
+///	\param count how many sensors are in the table
+///	\param temperatures array to return each sensor temperature
+///	\param results array to return each sensor result or NULL
+///	\return TMP_Success or TMP_Error if any of the sensors failed. 
+///		TMP_Timeout if they are still busy after OneWireBus_BusyPolls() polls
+///		or the conversion request failed on a timeout.
+///
+///	\note all the sensors convert at the same time so this takes 750ms
+///		plus a short read out per sensor. With TEMPERATURE_MILLIS() the
+///		bus is only polled near the end of the conversion.
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum TemperatureBus_BlockingReadAll(TemperatureBusType *bus, const OneWireRomType *table, uint8_t count, float *temperatures, TemperatureRespoceEnum *results)
+{
+	uint32_t Polls = OneWireBus_BusyPolls(bus->Bus);
+	TemperatureRespoceEnum ReturnState = TemperatureBus_RequestConvertion(bus); // Request temperature from all the sensors
+	
+	if(ReturnState)
+	{
+		return ReturnState;
+	}
+
+	for( ;; ) // Wait until the sensors have converted the temperature
+	{
+		ReturnState = TemperatureBus_NonBlockingReadAll(bus, table, count, temperatures, results);
+		
+		if(TMP_Busy != ReturnState)
+		{
+			return ReturnState;
+		}
+		
+		if(!Polls)
+		{
+			return TMP_Timeout;
+		}
+		
+		Polls--;
+		Temperature_Sleep(bus);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Initialize the temperature sensor on the default bus
+///	\sa TemperatureBus_Init
+/////////////////////////////////////////////////////////////////////////
+void Temperature_Init(void)
+{
+	OneWire_Init();
+	TemperatureBus_Init(&TemperatureDefaultBus, &OneWireDefaultBus);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Set the sensor alarm thresholds
+///	\sa TemperatureBus_SetAlarm
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum Temperature_SetAlarm(const OneWireRomType *rom, int8_t high, int8_t low)
+{
+	return TemperatureBus_SetAlarm(&TemperatureDefaultBus, rom, high, low);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Set the conversion resolution of a DS18B20 class sensor
+///	\sa TemperatureBus_SetResolution
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum Temperature_SetResolution(const OneWireRomType *rom, uint8_t resolution)
+{
+	return TemperatureBus_SetResolution(&TemperatureDefaultBus, rom, resolution);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read the alarm thresholds and the resolution of a sensor
+///	\sa TemperatureBus_GetConfig
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum Temperature_GetConfig(const OneWireRomType *rom, int8_t *high, int8_t *low, uint8_t *resolution)
+{
+	return TemperatureBus_GetConfig(&TemperatureDefaultBus, rom, high, low, resolution);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Copy the scratch pad to the sensor EEPROM
+///	\sa TemperatureBus_SaveAlarm
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum Temperature_SaveAlarm(const OneWireRomType *rom)
+{
+	return TemperatureBus_SaveAlarm(&TemperatureDefaultBus, rom);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Reload the scratch pad from the sensor EEPROM
+///	\sa TemperatureBus_RecallAlarm
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum Temperature_RecallAlarm(const OneWireRomType *rom)
+{
+	return TemperatureBus_RecallAlarm(&TemperatureDefaultBus, rom);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	sensor serial number
+///	\sa TemperatureBus_GetSerialNumber
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum Temperature_GetSerialNumber(uint8_t * destination)
+{
+	return TemperatureBus_GetSerialNumber(&TemperatureDefaultBus, destination);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Non-Blocking. Start all the sensors converting
+///	\sa TemperatureBus_RequestConvertion
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum Temperature_RequestConvertion(void)
+{
+	return TemperatureBus_RequestConvertion(&TemperatureDefaultBus);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	How long until the conversion is worth polling
+///	\sa TemperatureBus_ConvertionWait
+/////////////////////////////////////////////////////////////////////////
+uint32_t Temperature_ConvertionWait(void)
+{
+	return TemperatureBus_ConvertionWait(&TemperatureDefaultBus);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read the temperature from one sensor
+///	\sa TemperatureBus_ReadDevice
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum Temperature_ReadDevice(const OneWireRomType *rom, float *temperature)
+{
+	return TemperatureBus_ReadDevice(&TemperatureDefaultBus, rom, temperature);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	a non-blocking method to Get Temperature from sensor
+///	\sa TemperatureBus_NonBlockingRead
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum Temperature_NonBlockingRead(float *temperature)
+{
+	return TemperatureBus_NonBlockingRead(&TemperatureDefaultBus, temperature);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read the temperature from one sensor in fixed point
+///	\sa TemperatureBus_ReadDeviceFixed
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum Temperature_ReadDeviceFixed(const OneWireRomType *rom, int16_t *temperature)
+{
+	return TemperatureBus_ReadDeviceFixed(&TemperatureDefaultBus, rom, temperature);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Read the temperature from one sensor in whole degrees
+///	without the CRC
+///	\sa TemperatureBus_ReadDeviceInteger
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum Temperature_ReadDeviceInteger(const OneWireRomType *rom, int8_t *temperature)
+{
+	return TemperatureBus_ReadDeviceInteger(&TemperatureDefaultBus, rom, temperature);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	a non-blocking method to Get Temperature from sensor in 
+///	fixed point
+///	\sa TemperatureBus_NonBlockingReadFixed
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum Temperature_NonBlockingReadFixed(int16_t *temperature)
+{
+	return TemperatureBus_NonBlockingReadFixed(&TemperatureDefaultBus, temperature);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	a non-blocking method to get the temperature from every
+///		sensor in the ROM table
+///	\sa TemperatureBus_NonBlockingReadAll
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum Temperature_NonBlockingReadAll(const OneWireRomType *table, uint8_t count, float *temperatures, TemperatureRespoceEnum *results)
+{
+	return TemperatureBus_NonBlockingReadAll(&TemperatureDefaultBus, table, count, temperatures, results);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Blocking. Request and get the temperature from the sensor
+///	\sa TemperatureBus_BlockingRead
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum Temperature_BlockingRead(float *temperature)
+{
+	return TemperatureBus_BlockingRead(&TemperatureDefaultBus, temperature);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Blocking. Request and get the temperature from every sensor
+///		in the ROM table
+///	\sa TemperatureBus_BlockingReadAll
+/////////////////////////////////////////////////////////////////////////
+TemperatureRespoceEnum Temperature_BlockingReadAll(const OneWireRomType *table, uint8_t count, float *temperatures, TemperatureRespoceEnum *results)
+{
+	return TemperatureBus_BlockingReadAll(&TemperatureDefaultBus, table, count, temperatures, results);
 }
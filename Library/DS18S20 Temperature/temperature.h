@@ -93,9 +93,105 @@
 ///	}
 ///	\endcode 
 ///
+///
+///	Find All Sensors Code Example:
+///	\code
+///	#include "temperature.h"
+///
+///	#define MAX_SENSORS 16
+///
+///	void main(void)
+///	{
+///		OneWireSearchType Search;
+///		OneWireRomType Sensors[MAX_SENSORS];
+///		uint8_t SensorCount;
+///		float Temperatures[MAX_SENSORS];
+///
+///		Temperature_Init();
+///		Temperature_SearchInit(&Search);
+///
+///		SensorCount = OneWire_SearchRom(&Search, &Sensors[0], MAX_SENSORS);
+///
+///		for( ;; )
+///		{
+///			// One conversion for all the sensors then read each one
+///			if(!Temperature_BlockingReadAll(&Sensors[0], SensorCount, &Temperatures[0], 0))
+///				{
+///					printf("%0.4f\r\n",Temperatures[0]);
+///				}
+///		}
+///	}
+///	\endcode 
+///
+///
+///	Poll Only Out Of Range Sensors Code Example:
+///	\code
+///	#include "temperature.h"
+///
+///	void main(void)
+///	{
+///		OneWireSearchType Search;
+///		OneWireRomType Sensors[MAX_SENSORS];
+///		OneWireRomType Alarmed[MAX_SENSORS];
+///		uint8_t SensorCount;
+///		uint8_t AlarmCount;
+///		uint8_t Index;
+///
+///		Temperature_Init();
+///		Temperature_SearchInit(&Search);
+///		SensorCount = OneWire_SearchRom(&Search, &Sensors[0], MAX_SENSORS);
+///
+///		// Every sensor alarms above 60C or below 5C. Each one is addressed
+///		// so the DS18B20 class sensors keep their configuration register
+///		for(Index = 0; Index < SensorCount; Index++)
+///		{
+///			Temperature_SetAlarm(&Sensors[Index], 60, 5);
+///		}
+///
+///		for( ;; )
+///		{
+///			Temperature_RequestConvertion(); // Conversion also updates the alarm flags
+///			// ... wait for the conversion
+///
+///			Temperature_AlarmSearchInit(&Search);
+///			AlarmCount = OneWire_SearchRom(&Search, &Alarmed[0], MAX_SENSORS);
+///		}
+///	}
+///	\endcode 
+///
+///
+///	Second Bus Code Example:
+///	\code
+///	#include "uart.h"
+///	#include "temperature.h"
+///
+///	static UartPortType Port2;
+///	static OneWireBusType Bus2;
+///	static TemperatureBusType Sensors2;
+///
+///	void main(void)
+///	{
+///		float Inside;
+///		float Outside;
+///
+///		Temperature_Init(); // Default bus
+///
+///		UartPort_Init(&Port2, USART2, 9600);
+///		OneWireBus_Init(&Bus2, &OneWireUartPortOps, &Port2);
+///		TemperatureBus_Init(&Sensors2, &Bus2);
+///
+///		for( ;; )
+///		{
+///			Temperature_BlockingRead(&Inside);
+///			TemperatureBus_BlockingRead(&Sensors2, &Outside);
+///		}
+///	}
+///	\endcode
+///
 ////////////////////////////////////////////////////////////////////////////////
 #ifndef __TEMPERATURE_H__
 #define __TEMPERATURE_H__
+	#include "onewire.h"
 	
 	
 	/////////////////////////////////////////////////////////////////////////
@@ -104,20 +200,134 @@
 	/////////////////////////////////////////////////////////////////////////
 	#define SERIAL_LENGTH 8
 
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Number of bytes in the sensor scratch pad including the CRC
+	/////////////////////////////////////////////////////////////////////////
+	#define TMP_SCRATCHPAD_LENGTH 9
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Fraction bits of the fixed point temperatures. They are Q8.8,
+	///	degree C times 256, so 1/256 degree C per count.
+	/////////////////////////////////////////////////////////////////////////
+	#define TMP_FIXED_SHIFT 8
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Lowest DS18B20 resolution in bits
+	/////////////////////////////////////////////////////////////////////////
+	#define TMP_RESOLUTION_MIN 9
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Highest DS18B20 resolution in bits. Also the power up default
+	/////////////////////////////////////////////////////////////////////////
+	#define TMP_RESOLUTION_MAX 12
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Free running ms counter, ie. HAL_GetTick(). With it the driver
+	///	knows when the conversion is due and leaves the bus alone until
+	///	then. Without it the busy sensors are polled back to back. The
+	///	simulation build uses the simulated bus time.
+	/////////////////////////////////////////////////////////////////////////
+	// #define TEMPERATURE_MILLIS() HAL_GetTick()
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Sleep or yield while a blocking read waits for the conversion,
+	///	ie. vTaskDelay(). Defaults to waiting on TEMPERATURE_MILLIS().
+	/////////////////////////////////////////////////////////////////////////
+	// #define TEMPERATURE_SLEEP_MS(ms) vTaskDelay(pdMS_TO_TICKS(ms))
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Time between the busy polls in ms once the conversion is
+	///	close to its deadline. Needs TEMPERATURE_MILLIS()
+	/////////////////////////////////////////////////////////////////////////
+	#ifndef TEMPERATURE_POLL_MS
+		#define TEMPERATURE_POLL_MS 10
+	#endif
+	
+	////////////////////////////////////////////////////////////////////////////////
+	///	\brief Supported sensor family codes. The first byte of the ROM code
+	////////////////////////////////////////////////////////////////////////////////
+	typedef enum{
+		TMP_FAMILY_DS18S20 = 0x10,		///< DS18S20 (and DS1820). Fixed 9 bit plus count remain
+		TMP_FAMILY_DS1822 = 0x22,		///< DS1822. 9 to 12 bit
+		TMP_FAMILY_DS18B20 = 0x28		///< DS18B20. 9 to 12 bit
+	} TemperatureFamilyEnum;
+
 	////////////////////////////////////////////////////////////////////////////////
 	///	\brief This are the function enum types
 	////////////////////////////////////////////////////////////////////////////////
 	typedef enum{
 		TMP_Success = 0,			///< comminucation was a success
 		TMP_Error,						///< error was found
-		TMP_Busy							///< Device is still busy converting data
+		TMP_Busy,							///< Device is still busy converting data
+		TMP_Timeout,					///< The bus didn't respond in time or the sensor stayed busy
+		TMP_NoPresence,				///< No sensor answered the reset pulse
+		TMP_CRCError					///< The data read back failed its CRC
 	} TemperatureRespoceEnum;
 	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	The temperature sensors on one 1-Wire bus. Set it up with
+	///	TemperatureBus_Init(). What the driver knows about the sensors is
+	///	kept here, the 1-Wire bus itself knows nothing about them.
+	/////////////////////////////////////////////////////////////////////////
+	typedef struct
+	{
+		OneWireBusType *Bus;				///< The 1-Wire bus the sensors are on
+		uint8_t Family;						///< Family code of the only sensor on a single drop bus. 0 when unknown
+		uint16_t ConvertionTime;			///< Slowest conversion time of the sensors on the bus in ms. 0 when unknown
+		uint8_t ConvertionPending;			///< TRUE from the conversion request until the sensors are done. Internal use only
+		uint32_t ConvertionPoll;			///< Time in ms the conversion is polled next. Internal use only
+		uint32_t ConvertionDue;				///< Time in ms the conversion is done at the latest. Internal use only
+		uint32_t ConvertionResets;			///< Bus ResetCount straight after the conversion request. Internal use only
+	} TemperatureBusType;
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	The sensors behind the Temperature_* calls. Set up by
+	///	Temperature_Init() on OneWireDefaultBus.
+	/////////////////////////////////////////////////////////////////////////
+	extern TemperatureBusType TemperatureDefaultBus;
+	
+	
+	void TemperatureBus_Init(TemperatureBusType *bus, OneWireBusType *oneWireBus);
+	TemperatureRespoceEnum TemperatureBus_GetSerialNumber(TemperatureBusType *bus, uint8_t * destination);
+	TemperatureRespoceEnum TemperatureBus_SetAlarm(TemperatureBusType *bus, const OneWireRomType *rom, int8_t high, int8_t low);
+	TemperatureRespoceEnum TemperatureBus_SaveAlarm(TemperatureBusType *bus, const OneWireRomType *rom);
+	TemperatureRespoceEnum TemperatureBus_RecallAlarm(TemperatureBusType *bus, const OneWireRomType *rom);
+	TemperatureRespoceEnum TemperatureBus_SetResolution(TemperatureBusType *bus, const OneWireRomType *rom, uint8_t resolution);
+	TemperatureRespoceEnum TemperatureBus_GetConfig(TemperatureBusType *bus, const OneWireRomType *rom, int8_t *high, int8_t *low, uint8_t *resolution);
+	TemperatureRespoceEnum TemperatureBus_BlockingRead(TemperatureBusType *bus, float *temperature);
+	TemperatureRespoceEnum TemperatureBus_RequestConvertion(TemperatureBusType *bus);
+	TemperatureRespoceEnum TemperatureBus_ConvertionDone(TemperatureBusType *bus);
+	uint32_t TemperatureBus_ConvertionWait(const TemperatureBusType *bus);
+	void TemperatureBus_ConvertionEnd(TemperatureBusType *bus);
+	TemperatureRespoceEnum TemperatureBus_NonBlockingRead(TemperatureBusType *bus, float *temperature);
+	TemperatureRespoceEnum TemperatureBus_ReadDevice(TemperatureBusType *bus, const OneWireRomType *rom, float *temperature);
+	TemperatureRespoceEnum TemperatureBus_ReadDeviceFixed(TemperatureBusType *bus, const OneWireRomType *rom, int16_t *temperature);
+	TemperatureRespoceEnum TemperatureBus_ReadDeviceInteger(TemperatureBusType *bus, const OneWireRomType *rom, int8_t *temperature);
+	TemperatureRespoceEnum TemperatureBus_NonBlockingReadFixed(TemperatureBusType *bus, int16_t *temperature);
+	TemperatureRespoceEnum TemperatureBus_NonBlockingReadAll(TemperatureBusType *bus, const OneWireRomType *table, uint8_t count, float *temperatures, TemperatureRespoceEnum *results);
+	TemperatureRespoceEnum TemperatureBus_BlockingReadAll(TemperatureBusType *bus, const OneWireRomType *table, uint8_t count, float *temperatures, TemperatureRespoceEnum *results);
 	
 	void Temperature_Init(void);
 	TemperatureRespoceEnum Temperature_GetSerialNumber(uint8_t * destination);
+	void Temperature_SearchInit(OneWireSearchType *search);
+	void Temperature_AlarmSearchInit(OneWireSearchType *search);
+	TemperatureRespoceEnum Temperature_SetAlarm(const OneWireRomType *rom, int8_t high, int8_t low);
+	TemperatureRespoceEnum Temperature_SaveAlarm(const OneWireRomType *rom);
+	TemperatureRespoceEnum Temperature_RecallAlarm(const OneWireRomType *rom);
+	TemperatureRespoceEnum Temperature_SetResolution(const OneWireRomType *rom, uint8_t resolution);
+	TemperatureRespoceEnum Temperature_GetConfig(const OneWireRomType *rom, int8_t *high, int8_t *low, uint8_t *resolution);
+	uint16_t Temperature_ConvertionTime(uint8_t family, uint8_t resolution);
+	float Temperature_Decode(uint8_t family, const uint8_t *scratchpad);
+	int16_t Temperature_DecodeFixed(uint8_t family, const uint8_t *scratchpad);
 	TemperatureRespoceEnum Temperature_BlockingRead(float *destination);
 	TemperatureRespoceEnum Temperature_RequestConvertion(void);
+	uint32_t Temperature_ConvertionWait(void);
 	TemperatureRespoceEnum Temperature_NonBlockingRead(float *temperature);
+	TemperatureRespoceEnum Temperature_ReadDevice(const OneWireRomType *rom, float *temperature);
+	TemperatureRespoceEnum Temperature_ReadDeviceFixed(const OneWireRomType *rom, int16_t *temperature);
+	TemperatureRespoceEnum Temperature_ReadDeviceInteger(const OneWireRomType *rom, int8_t *temperature);
+	TemperatureRespoceEnum Temperature_NonBlockingReadFixed(int16_t *temperature);
+	TemperatureRespoceEnum Temperature_NonBlockingReadAll(const OneWireRomType *table, uint8_t count, float *temperatures, TemperatureRespoceEnum *results);
+	TemperatureRespoceEnum Temperature_BlockingReadAll(const OneWireRomType *table, uint8_t count, float *temperatures, TemperatureRespoceEnum *results);
 
 #endif
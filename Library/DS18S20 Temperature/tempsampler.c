@@ -0,0 +1,242 @@
+/////////////////////////////////////////////////////////////////////////
+///	\file	tempsampler.c
+///	\brief background temperature sampler. A periodic tick runs the
+///	conversions and the rest of the program reads the latest result
+///	without touching the bus.
+///
+///	\section TemperatureSampler Sampler
+///
+///	Each sample starts a conversion, waits the conversion time of the
+///	sensor in ticks and then reads the scratch pad. Only those two steps
+///	use the bus, every other tick just counts. A conversion that started
+///	late, ie. the tick was caught up on late, isn't read early. The
+///	sensor is asked with TemperatureBus_ConvertionDone() once a tick
+///	until it's done. A step is one blocking
+///	bus transaction of a few ms that needs the UART interrupt to move its
+///	data and may wait out a retry back-off. So call 
+///	TemperatureSampler_Tick() from the main loop or a task, never from
+///	an interrupt. Count the timer ticks in the interrupt and catch up
+///	on them in the main loop, see tempsampler.h.
+///
+///	The reading is published in to whichever buffer the readers are not
+///	using and then Sequence moves on to it. TemperatureSampler_Latest()
+///	only copies the newest buffer and tries again in the rare case a
+///	second reading was published while it was copying. The sampler is
+///	written for a single core. On a multi core part put a memory barrier
+///	before each Sequence update and after each Sequence read.
+///
+///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
+///	Website: www.HashDefineElectronics.com
+///
+///	Licences:
+///
+///		Copyright (c) 2014 Ronald Alexander Nobrega De Sousa
+///
+///		Permission is hereby granted, free of charge, to any person obtaining a copy
+///		of this software and associated documentation files (the "Software"), to deal
+///		in the Software without restriction, including without limitation the rights
+///		to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+///		copies of the Software, and to permit persons to whom the Software is
+///		furnished to do so, subject to the following conditions:
+///
+///		The above copyright notice and this permission notice shall be included in
+///		all copies or substantial portions of the Software.
+///
+///		THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///		IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///		FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///		AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///		LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///		THE SOFTWARE.
+/////////////////////////////////////////////////////////////////////////
+#include "common.h"
+#include "tempsampler.h"
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Publish a new reading. It goes in to the buffer the readers
+///	aren't using and only becomes visible once Sequence moves on.
+///
+///	\param sampler the sampler
+///	\param temperature the temperature read
+///	\param timestamp tick the conversion was started on
+/////////////////////////////////////////////////////////////////////////
+static void TemperatureSampler_Publish(TemperatureSamplerType *sampler, float temperature, uint32_t timestamp)
+{
+	volatile TemperatureReadingType *Reading = &sampler->Reading[(sampler->Sequence + 1) & 0x01];
+	
+	Reading->Temperature = temperature;
+	Reading->Timestamp = timestamp;
+	
+	sampler->Sequence++;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Record a failed step and try again next period
+///
+///	\param sampler the sampler
+///	\param result what went wrong
+/////////////////////////////////////////////////////////////////////////
+static void TemperatureSampler_Fail(TemperatureSamplerType *sampler, TemperatureRespoceEnum result)
+{
+	sampler->LastResult = result;
+	sampler->Errors++;
+	sampler->Converting = FALSE;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Set up a sampler. The first conversion starts on the first
+///	tick.
+///
+///	\param sampler the sampler
+///	\param bus the bus the sensor is on
+///	\param rom the sensor or NULL for the only sensor on the bus. It must
+///		stay valid while the sampler runs
+///	\param tickMs how often TemperatureSampler_Tick() is called in ms
+///	\param periodMs time between readings in ms. Never shorter than the
+///		conversion time
+///	\param resolution the sensor resolution in bits, it sets how long
+///		the conversion takes. 0 waits as long as the slowest resolution
+///
+///	\sa Temperature_ConvertionTime
+/////////////////////////////////////////////////////////////////////////
+void TemperatureSampler_Init(TemperatureSamplerType *sampler, TemperatureBusType *bus, const OneWireRomType *rom, uint32_t tickMs, uint32_t periodMs, uint8_t resolution)
+{
+	uint32_t ConvertionMs = Temperature_ConvertionTime(rom ? rom->Code[0] : bus->Family, resolution);
+	
+	if(!tickMs)
+	{
+		tickMs = 1;
+	}
+	
+	sampler->Bus = bus;
+	sampler->Rom = rom;
+	
+	// Round up so the scratch pad is never read early
+	sampler->ConvertionTicks = (ConvertionMs + tickMs - 1) / tickMs;
+	sampler->Period = (periodMs + tickMs - 1) / tickMs;
+	
+	if(sampler->Period <= sampler->ConvertionTicks)
+	{
+		sampler->Period = sampler->ConvertionTicks + 1;
+	}
+	
+	sampler->Now = 0;
+	sampler->Due = 0;
+	sampler->Started = 0;
+	sampler->Converting = FALSE;
+	sampler->LastResult = TMP_Busy;
+	sampler->Errors = 0;
+	sampler->Sequence = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Move the sampler on by one tick. Call it every tickMs from
+///	the main loop or a task, not from an interrupt. Only touches the bus
+///	on the tick a conversion starts and the tick it's read back, plus a
+///	read slot a tick while a late conversion finishes.
+///
+///	\param sampler the sampler
+/////////////////////////////////////////////////////////////////////////
+void TemperatureSampler_Tick(TemperatureSamplerType *sampler)
+{
+	TemperatureRespoceEnum ReturnState;
+	float Temperature;
+	uint32_t Now = sampler->Now + 1;
+	
+	sampler->Now = Now;
+	
+	if((int32_t)(Now - sampler->Due) < 0)
+	{
+		return;
+	}
+	
+	if(!sampler->Converting)
+	{
+		sampler->Started = Now;
+		sampler->Due = Now + sampler->Period;
+		
+		ReturnState = TemperatureBus_RequestConvertion(sampler->Bus);
+		
+		if(ReturnState)
+		{
+			TemperatureSampler_Fail(sampler, ReturnState);
+			return;
+		}
+		
+		// Come back once the conversion is done
+		sampler->Converting = TRUE;
+		sampler->Due = Now + sampler->ConvertionTicks;
+		return;
+	}
+	
+	// The conversion only starts once the request is on the bus, that
+	// may be well after its tick when the ticks are caught up on late.
+	// So ask the sensor, unless it's had twice its time
+	if((Now - sampler->Started) < (sampler->ConvertionTicks * 2))
+	{
+		ReturnState = TemperatureBus_ConvertionDone(sampler->Bus);
+		
+		if(TMP_Busy == ReturnState)
+		{
+			sampler->Due = Now + 1;
+			return;
+		}
+		
+		if(ReturnState)
+		{
+			TemperatureSampler_Fail(sampler, ReturnState);
+			sampler->Due = sampler->Started + sampler->Period;
+			return;
+		}
+	}
+	
+	// Next conversion is a period after this one started
+	sampler->Converting = FALSE;
+	sampler->Due = sampler->Started + sampler->Period;
+	
+	// Done or waited out, so the other users of the bus don't have to poll
+	// for it
+	TemperatureBus_ConvertionEnd(sampler->Bus);
+	
+	ReturnState = TemperatureBus_ReadDevice(sampler->Bus, sampler->Rom, &Temperature);
+	
+	if(ReturnState)
+	{
+		TemperatureSampler_Fail(sampler, ReturnState);
+		return;
+	}
+	
+	sampler->LastResult = TMP_Success;
+	TemperatureSampler_Publish(sampler, Temperature, sampler->Started);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Get the newest reading. Never touches the bus and never
+///	waits for TemperatureSampler_Tick(), so it's safe to call from any
+///	interrupt or the main loop.
+///
+///	\param sampler the sampler
+///	\param reading pointer to return the reading
+///	\return FALSE on success else TRUE if there is no reading yet
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t TemperatureSampler_Latest(const TemperatureSamplerType *sampler, TemperatureReadingType *reading)
+{
+	uint32_t Sequence;
+	
+	do
+	{
+		Sequence = sampler->Sequence;
+		
+		if(!Sequence)
+		{
+			return TRUE;
+		}
+		
+		reading->Temperature = sampler->Reading[Sequence & 0x01].Temperature;
+		reading->Timestamp = sampler->Reading[Sequence & 0x01].Timestamp;
+	}
+	while(Sequence != sampler->Sequence); // A second reading was published, the copy may be torn
+	
+	return FALSE;
+}
@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////
+/// \file	tempsampler.h
+///	\brief background temperature sampler. A periodic tick runs the
+///	conversions and the rest of the program reads the latest result
+///	without touching the bus.
+///
+///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
+///	Website: www.HashDefineElectronics.com
+///
+///	Licences:
+///
+///		Copyright (c) 2014 Ronald Alexander Nobrega De Sousa
+///
+///		Permission is hereby granted, free of charge, to any person obtaining a copy
+///		of this software and associated documentation files (the "Software"), to deal
+///		in the Software without restriction, including without limitation the rights
+///		to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+///		copies of the Software, and to permit persons to whom the Software is
+///		furnished to do so, subject to the following conditions:
+///
+///		The above copyright notice and this permission notice shall be included in
+///		all copies or substantial portions of the Software.
+///
+///		THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///		IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///		FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///		AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///		LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///		THE SOFTWARE.
+///
+///
+///	Background Sampler Code Example:
+///	\code
+///	#include "tempsampler.h"
+///
+///	static TemperatureSamplerType Sampler;
+///	static volatile uint32_t Ticks;
+///
+///	void SysTick_Handler(void) // every 10ms
+///	{
+///		Ticks++; // Only count, the sampler uses the bus and must not run here
+///	}
+///
+///	void TIM2_IRQHandler(void) // control loop
+///	{
+///		TemperatureReadingType Reading;
+///
+///		if(!TemperatureSampler_Latest(&Sampler, &Reading))
+///			{
+///				// Reading.Temperature was taken (Sampler.Now - Reading.Timestamp) ticks ago
+///			}
+///	}
+///
+///	void main(void)
+///	{
+///		uint32_t Ticked = 0;
+///
+///		Temperature_Init();
+///
+///		// Only sensor on the default bus, 12 bit, a new reading every second
+///		TemperatureSampler_Init(&Sampler, &TemperatureDefaultBus, 0, 10, 1000, 12);
+///
+///		for( ;; ) // program loop
+///		{
+///			// Catch up on the ticks since the last time round
+///			while(Ticked != Ticks)
+///			{
+///				Ticked++;
+///				TemperatureSampler_Tick(&Sampler);
+///			}
+///
+///			// Process something else
+///			YourProcess();
+///		}
+///	}
+///	\endcode
+////////////////////////////////////////////////////////////////////////////////
+#ifndef __TEMPERATURE_SAMPLER_H__
+#define __TEMPERATURE_SAMPLER_H__
+	#include "temperature.h"
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	One published reading
+	/////////////////////////////////////////////////////////////////////////
+	typedef struct
+	{
+		float Temperature;					///< Temperature in degree C
+		uint32_t Timestamp;					///< Tick the conversion was started on
+	} TemperatureReadingType;
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Sampler state. Set it up with TemperatureSampler_Init().
+	///	Readings are published in to the two buffers in turn and Sequence
+	///	tells the readers which one is the newest.
+	/////////////////////////////////////////////////////////////////////////
+	typedef struct
+	{
+		TemperatureBusType *Bus;			///< Bus the sensor is on
+		const OneWireRomType *Rom;			///< The sensor or NULL for the only sensor on the bus
+		uint32_t Period;					///< Ticks from the start of one conversion to the next
+		uint32_t ConvertionTicks;			///< Ticks the sensor needs to convert
+		volatile uint32_t Now;				///< Ticks since TemperatureSampler_Init()
+		uint32_t Due;						///< Tick the next step runs on. Internal use only
+		uint32_t Started;					///< Tick the conversion was started on. Internal use only
+		uint8_t Converting;					///< TRUE while waiting for the conversion. Internal use only
+		uint8_t LastResult;					///< TemperatureRespoceEnum of the last sample
+		uint32_t Errors;					///< Samples that failed. The last good reading stays published
+		volatile uint32_t Sequence;			///< Readings published so far. Internal use only
+		volatile TemperatureReadingType Reading[2];	///< Reading buffers. Internal use only
+	} TemperatureSamplerType;
+	
+	void TemperatureSampler_Init(TemperatureSamplerType *sampler, TemperatureBusType *bus, const OneWireRomType *rom, uint32_t tickMs, uint32_t periodMs, uint8_t resolution);
+	void TemperatureSampler_Tick(TemperatureSamplerType *sampler);
+	uint_fast8_t TemperatureSampler_Latest(const TemperatureSamplerType *sampler, TemperatureReadingType *reading);
+
+#endif
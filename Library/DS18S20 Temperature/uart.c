@@ -4,6 +4,21 @@
 ///
 ///	\section UartLayer Serial Layer
 ///
+///	The layer keeps a transmit and a receive ring buffer. The MCU receive
+///	interrupt pushes bytes with Uart_RxInterrupt() and the transmit side is
+///	drained either by the transmit empty interrupt (Uart_TxInterrupt()) or
+///	by DMA (Uart_TxDmaBlock() and Uart_TxDmaComplete()). The original
+///	Uart_* calls are kept as a synchronous wrapper on top of the buffers
+///	so the caller can either block on a byte or queue a burst and come
+///	back later.
+///
+///	Each UART is a UartPortType with its own buffers, so several ports
+///	can run at the same time. The UartPort_* calls take the port and the
+///	Uart_* calls use UartDefaultPort.
+///
+///	Define ONEWIRE_SIMULATION to connect the ports to the simulated bus
+///	in onewiresim.c instead of the MCU hardware.
+///
 ///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
 ///	Website: www.HashDefineElectronics.com
 ///
@@ -31,6 +46,461 @@
 /////////////////////////////////////////////////////////////////////////
 #include <stdint.h>
 #include "common.h"
+#include "uart.h"
+
+#ifdef ONEWIRE_SIMULATION
+	#include "onewiresim.h"
+#endif
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Mask used to wrap the ring buffer index
+/////////////////////////////////////////////////////////////////////////
+#define UART_BUFFER_MASK (UART_BUFFER_SIZE - 1)
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	The port behind the Uart_* calls
+/////////////////////////////////////////////////////////////////////////
+UartPortType UartDefaultPort;
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Number of bytes stored in the ring
+/////////////////////////////////////////////////////////////////////////
+static uint_fast8_t Uart_RingCount(const UartRingType * ring)
+{
+	return (uint8_t)(ring->Head - ring->Tail);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	setup the uart peripheral. Enable the receive interrupt and
+///	the transmit complete interrupt.
+///
+///	\param port the port. port->Hardware selects the peripheral
+///	\param baud the desire baudrate
+/////////////////////////////////////////////////////////////////////////
+static void UartHw_Init(UartPortType *port, uint32_t baud)
+{
+#ifdef ONEWIRE_SIMULATION
+	OneWireSim_SetBaud((OneWireSimType *)port->Hardware, baud);
+#else
+	///	\todo Write code here setup the uart and its interrupts.
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	change the uart peripheral baudrate
+///
+///	\param port the port
+///	\param baud the desire baudrate
+/////////////////////////////////////////////////////////////////////////
+static void UartHw_Setbaud(UartPortType *port, uint32_t baud)
+{
+#ifdef ONEWIRE_SIMULATION
+	OneWireSim_SetBaud((OneWireSimType *)port->Hardware, baud);
+#else
+	///	\todo Write code here set the uart buadrate. 
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Hold the TX line low for at least the given time, release 
+///	it and leave it idle. The transmitter is idle when this is called.
+///
+///	\param port the port
+///	\param low the minimum low time in us
+///	\param idle the minimum time in us before the next character starts
+/////////////////////////////////////////////////////////////////////////
+static void UartHw_Break(UartPortType *port, uint32_t low, uint32_t idle)
+{
+#ifdef ONEWIRE_SIMULATION
+	OneWireSim_Break((OneWireSimType *)port->Hardware, low, idle);
+#else
+	///	\todo Write code here that holds the TX pin low, ie. set the 
+	///	send break bit or switch the pin to a GPIO driven low, wait and
+	///	give the pin back to the uart. Then wait idle us.
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Kick the hardware so that it starts to empty the transmit
+///	buffer. With interrupts this enables the transmit empty interrupt,
+///	with DMA it should start a transfer of the block returned by 
+///	UartPort_TxDmaBlock().
+///
+///	\param port the port
+/////////////////////////////////////////////////////////////////////////
+static void UartHw_StartTransmit(UartPortType *port)
+{
+#ifdef ONEWIRE_SIMULATION
+	uint8_t Data;
+	
+	// Late echoes are sent out by UartHw_Poll()
+	if(((OneWireSimType *)port->Hardware)->EchoPolls)
+	{
+		return;
+	}
+	
+	// The simulated bus echoes each character straight away
+	while(UartPort_TxInterrupt(port, &Data))
+	{
+		UartPort_RxInterrupt(port, OneWireSim_Transfer((OneWireSimType *)port->Hardware, Data));
+	}
+	
+	UartPort_TxCompleteInterrupt(port);
+#else
+	///	\todo Write code here that enables the transmit empty interrupt
+	///	or starts the DMA channel.
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Called each time the port is polled. On the MCU the interrupts
+///	move the transmitter on so there is nothing to do. The simulated bus
+///	with OneWireSimType EchoPolls set sends one character every EchoPolls
+///	polls, its echo arrives just before the transmit complete like on a
+///	real UART.
+///
+///	\param port the port
+/////////////////////////////////////////////////////////////////////////
+static void UartHw_Poll(UartPortType *port)
+{
+#ifdef ONEWIRE_SIMULATION
+	OneWireSimType *Sim = (OneWireSimType *)port->Hardware;
+	uint8_t Data;
+	
+	if(!Sim->EchoPolls || !port->TxActive)
+	{
+		return;
+	}
+	
+	Sim->EchoWait++;
+	
+	if(Sim->EchoWait < Sim->EchoPolls)
+	{
+		return;
+	}
+	
+	Sim->EchoWait = 0;
+	
+	if(UartPort_TxInterrupt(port, &Data))
+	{
+		UartPort_RxInterrupt(port, OneWireSim_Transfer(Sim, Data));
+		UartPort_TxCompleteInterrupt(port);
+	}
+#else
+	(void)port;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Start the hardware if it's idle and there is data waiting
+/////////////////////////////////////////////////////////////////////////
+static void Uart_StartTransmit(UartPortType *port)
+{
+	if(!port->TxActive && Uart_RingCount(&port->TxRing))
+	{
+		port->TxActive = TRUE;
+		UartHw_StartTransmit(port);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	setup a uart port
+///
+///	\param port the port
+///	\param hardware the MCU peripheral used by the port. With 
+///		ONEWIRE_SIMULATION this is the OneWireSimType bus.
+///	\param baud the desire baudrate
+/////////////////////////////////////////////////////////////////////////
+void UartPort_Init(UartPortType *port, void *hardware, uint32_t baud)
+{
+	port->TxRing.Head = port->TxRing.Tail = 0;
+	port->RxRing.Head = port->RxRing.Tail = 0;
+	port->TxComplete = TRUE;
+	port->TxActive = FALSE;
+	port->Hardware = hardware;
+	
+	UartHw_Init(port, baud);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Set the port baudrate. can be called at any time.
+///
+///	\param port the port
+///	\param baud the desire baudrate
+///	\return FALSE on success else TRUE if the transmit buffer didn't
+///		drain within UART_WRITE_TIMEOUT polls. The baudrate is unchanged.
+///
+///	\note waits for the transmit buffer to drain before the baudrate is
+///		changed so that no queued data is corrupted.
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t UartPort_Setbaud(UartPortType *port, uint32_t baud)
+{
+	uint32_t Timeout = UART_WRITE_TIMEOUT;
+	
+	while(!UartPort_WriteComplete(port))
+	{
+		if(!Timeout)
+		{
+			return TRUE;
+		}
+		
+		Timeout--;
+	}
+	
+	UartHw_Setbaud(port, baud);
+	
+	return FALSE;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Send a break, ie. hold the line low for longer than a 
+///	character, followed by some idle time. Waits for the transmit buffer
+///	to drain first. A low time of 0 just waits.
+///
+///	\param port the port
+///	\param low the minimum low time in us
+///	\param idle the minimum time in us before the next character starts
+///	\return FALSE on success else TRUE if the transmit buffer didn't
+///		drain within UART_WRITE_TIMEOUT polls
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t UartPort_Break(UartPortType *port, uint32_t low, uint32_t idle)
+{
+	uint32_t Timeout = UART_WRITE_TIMEOUT;
+	
+	while(!UartPort_WriteComplete(port))
+	{
+		if(!Timeout)
+		{
+			return TRUE;
+		}
+		
+		Timeout--;
+	}
+	
+	UartHw_Break(port, low, idle);
+	
+	return FALSE;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Non-blocking. Queue a block of data for transmission. Either
+///	the whole block is queued or nothing is.
+///
+///	\param port the port
+///	\param source pointer to the data to send
+///	\param length how many bytes to send
+///	\return FALSE on success else TRUE if there isn't enough room
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t UartPort_Write(UartPortType *port, const uint8_t * source, uint_fast8_t length)
+{
+	uint8_t Head = port->TxRing.Head;
+	
+	if(length > UartPort_WriteSpace(port))
+	{
+		return TRUE;
+	}
+	
+	if(!length)
+	{
+		return FALSE;
+	}
+	
+	while(length)
+	{
+		port->TxRing.Buffer[Head & UART_BUFFER_MASK] = *source;
+		Head++;
+		source++;
+		length--;
+	}
+	
+	// Publish the new data in one go. Completion is worked out from the
+	// ring as well, so there is no flag to clear here that a transmit 
+	// complete interrupt for the previous data could race with
+	port->TxRing.Head = Head;
+	
+	Uart_StartTransmit(port);
+	
+	return FALSE;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Non-blocking. Take up to length bytes out of the receive
+///	buffer.
+///
+///	\param port the port
+///	\param destination pointer to return the data
+///	\param length maximum number of bytes to read
+///	\return the number of bytes read
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t UartPort_Read(UartPortType *port, uint8_t * destination, uint_fast8_t length)
+{
+	uint8_t Tail;
+	uint_fast8_t Count;
+	uint_fast8_t Index;
+	
+	UartHw_Poll(port);
+	
+	Tail = port->RxRing.Tail;
+	Count = Uart_RingCount(&port->RxRing);
+	
+	if(Count > length)
+	{
+		Count = length;
+	}
+	
+	for(Index = 0; Index < Count; Index++)
+	{
+		destination[Index] = port->RxRing.Buffer[Tail & UART_BUFFER_MASK];
+		Tail++;
+	}
+	
+	port->RxRing.Tail = Tail;
+	
+	return Count;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	How many bytes can be queued without waiting
+///
+///	\param port the port
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t UartPort_WriteSpace(UartPortType *port)
+{
+	UartHw_Poll(port);
+	
+	return UART_BUFFER_SIZE - Uart_RingCount(&port->TxRing);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	How many received bytes are waiting to be read
+///
+///	\param port the port
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t UartPort_ReadAvailable(UartPortType *port)
+{
+	UartHw_Poll(port);
+	
+	return Uart_RingCount(&port->RxRing);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Transmit completion. The ring has to be empty and the
+///	last byte taken out of it has to have left the shift register.
+///
+///	\param port the port
+///	\return TRUE once every queued byte has been sent out
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t UartPort_WriteComplete(UartPortType *port)
+{
+	UartHw_Poll(port);
+	
+	return (port->TxComplete && !Uart_RingCount(&port->TxRing));
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Call from the receive interrupt with the received byte.
+///	If the buffer is full the byte is dropped.
+///
+///	\param port the port
+///	\param data the received byte
+/////////////////////////////////////////////////////////////////////////
+void UartPort_RxInterrupt(UartPortType *port, uint8_t data)
+{
+	uint8_t Head = port->RxRing.Head;
+	
+	if(Uart_RingCount(&port->RxRing) < UART_BUFFER_SIZE)
+	{
+		port->RxRing.Buffer[Head & UART_BUFFER_MASK] = data;
+		port->RxRing.Head = Head + 1;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Call from the transmit empty interrupt to get the next byte
+///	to load in to the data register.
+///
+///	\param port the port
+///	\param destination pointer to return the byte to send
+///	\return TRUE if a byte was returned. FALSE means the buffer is empty
+///		and the transmit empty interrupt should be disabled.
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t UartPort_TxInterrupt(UartPortType *port, uint8_t * destination)
+{
+	uint8_t Tail = port->TxRing.Tail;
+	
+	if(!Uart_RingCount(&port->TxRing))
+	{
+		port->TxActive = FALSE;
+		return FALSE;
+	}
+	
+	// The byte is in the shift register until the next transmit complete
+	port->TxComplete = FALSE;
+	
+	*destination = port->TxRing.Buffer[Tail & UART_BUFFER_MASK];
+	port->TxRing.Tail = Tail + 1;
+	
+	return TRUE;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Call from the transmit complete interrupt, ie once the last
+///	byte has left the shift register.
+///
+///	\param port the port
+/////////////////////////////////////////////////////////////////////////
+void UartPort_TxCompleteInterrupt(UartPortType *port)
+{
+	if(!Uart_RingCount(&port->TxRing))
+	{
+		port->TxComplete = TRUE;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Get the next contiguous block of the transmit buffer for
+///	a DMA transfer. Only call this from UartHw_StartTransmit() or after
+///	UartPort_TxDmaComplete().
+///
+///	\param port the port
+///	\param source pointer to return the start of the block
+///	\return the block length. zero when the buffer is empty
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t UartPort_TxDmaBlock(UartPortType *port, const uint8_t ** source)
+{
+	uint_fast8_t Count = Uart_RingCount(&port->TxRing);
+	uint_fast8_t Offset = port->TxRing.Tail & UART_BUFFER_MASK;
+	
+	// Stop at the end of the buffer, the rest is sent in the next block
+	if(Count > (UART_BUFFER_SIZE - Offset))
+	{
+		Count = UART_BUFFER_SIZE - Offset;
+	}
+	
+	if(Count)
+	{
+		port->TxComplete = FALSE;
+	}
+	
+	*source = &port->TxRing.Buffer[Offset];
+	
+	return Count;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Call from the DMA transfer complete interrupt. Releases the
+///	block and starts the next one if there is more data waiting.
+///
+///	\param port the port
+///	\param length the length of the block that was sent
+/////////////////////////////////////////////////////////////////////////
+void UartPort_TxDmaComplete(UartPortType *port, uint_fast8_t length)
+{
+	port->TxRing.Tail = port->TxRing.Tail + length;
+	port->TxActive = FALSE;
+	
+	Uart_StartTransmit(port);
+}
 
 /////////////////////////////////////////////////////////////////////////
 ///	\brief	setup the uart hardware
@@ -39,62 +509,166 @@
 /////////////////////////////////////////////////////////////////////////
 void Uart_Init(uint32_t baud)
 {
-	///	\todo Write code here setup the uart.
+	UartPort_Init(&UartDefaultPort, UART_DEFAULT_HARDWARE, baud);
 }
 
 /////////////////////////////////////////////////////////////////////////
 ///	\brief	Set Uart baudrate. can be called at any time.
 ///
 ///	\param baud the desire baudrate
-///
-///	\note setting baudrate will effect any data currently been sent.
-///		make sure that you check that the write buffer is empty
+///	\return FALSE on success else TRUE on timeout
+///	\sa UartPort_Setbaud
 /////////////////////////////////////////////////////////////////////////
-void Uart_Setbaud(uint32_t baud)
+uint_fast8_t Uart_Setbaud(uint32_t baud)
 {
-	///	\todo Write code here set the uart buadrate. 
+	return UartPort_Setbaud(&UartDefaultPort, baud);
 }
 
 /////////////////////////////////////////////////////////////////////////
 ///	\brief	you can use this function to check if the write buffer is
 ///	empty and ready for new data
 ///
-///	\param destination pointer to return the read byte
-///	\return TRUE = empty and ready. else false
+///	\return TRUE = there is room for another byte. else false
 /////////////////////////////////////////////////////////////////////////
 uint_fast8_t Uart_WriteBusy(void)
 {
-	uint_fast8_t ReturnState = TRUE;
-	
-	///	\todo Write code here that will get the MCU current write 
-	/// buffer empty state and set ReturnState.
-	
-	return ReturnState;
+	return (UartPort_WriteSpace(&UartDefaultPort) != 0);
 }
 
 /////////////////////////////////////////////////////////////////////////
-///	\brief	Uart write single byte
+///	\brief	Uart write single byte. Waits up to UART_WRITE_TIMEOUT polls
+///	for space in the transmit buffer.
 ///
 ///	\param source byte to write
+///	\return FALSE on success else TRUE if there was no room
 /////////////////////////////////////////////////////////////////////////
-void Uart_WriteByte(uint8_t source)
+uint_fast8_t Uart_WriteByte(uint8_t source)
 {
-	///	\todo Write code here that transmit one byte.
+	uint32_t Timeout = UART_WRITE_TIMEOUT;
+	
+	while(!Uart_WriteBusy())
+	{
+		if(!Timeout)
+		{
+			return TRUE;
+		}
+		
+		Timeout--;
+	}
+	
+	return UartPort_Write(&UartDefaultPort, &source, 1);
 }
 
 /////////////////////////////////////////////////////////////////////////
-///	\brief	Uart read single byte
+///	\brief	Uart read single byte. Waits up to UART_READ_TIMEOUT polls
+///	for the byte to arrive.
 ///
 ///	\param destination pointer to return the read byte
 ///	\return FALSE on success else TRUE
 /////////////////////////////////////////////////////////////////////////
 uint_fast8_t Uart_ReadByte(uint8_t * destination)
 {
-	uint_fast8_t ReturnState = TRUE;
-
-	///	\todo Write code here that reads one byte from uart and 
-	///	set ReturnState TRUE of false depending
-	///	if it was sucessful.
+	uint32_t Timeout = UART_READ_TIMEOUT;
+	
+	while(!UartPort_Read(&UartDefaultPort, destination, 1))
+	{
+		if(!Timeout)
+		{
+			return TRUE; // Nothing arrived
+		}
+		
+		Timeout--;
+	}
 	
-	return ReturnState;
+	return FALSE;
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Non-blocking. Queue a block of data on the default port
+///	\sa UartPort_Write
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t Uart_Write(const uint8_t * source, uint_fast8_t length)
+{
+	return UartPort_Write(&UartDefaultPort, source, length);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Non-blocking. Read from the default port
+///	\sa UartPort_Read
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t Uart_Read(uint8_t * destination, uint_fast8_t length)
+{
+	return UartPort_Read(&UartDefaultPort, destination, length);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	How many bytes can be queued on the default port
+///	\sa UartPort_WriteSpace
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t Uart_WriteSpace(void)
+{
+	return UartPort_WriteSpace(&UartDefaultPort);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	How many received bytes are waiting on the default port
+///	\sa UartPort_ReadAvailable
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t Uart_ReadAvailable(void)
+{
+	return UartPort_ReadAvailable(&UartDefaultPort);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Default port transmit completion flag
+///	\sa UartPort_WriteComplete
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t Uart_WriteComplete(void)
+{
+	return UartPort_WriteComplete(&UartDefaultPort);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Default port receive interrupt
+///	\sa UartPort_RxInterrupt
+/////////////////////////////////////////////////////////////////////////
+void Uart_RxInterrupt(uint8_t data)
+{
+	UartPort_RxInterrupt(&UartDefaultPort, data);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Default port transmit empty interrupt
+///	\sa UartPort_TxInterrupt
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t Uart_TxInterrupt(uint8_t * destination)
+{
+	return UartPort_TxInterrupt(&UartDefaultPort, destination);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Default port transmit complete interrupt
+///	\sa UartPort_TxCompleteInterrupt
+/////////////////////////////////////////////////////////////////////////
+void Uart_TxCompleteInterrupt(void)
+{
+	UartPort_TxCompleteInterrupt(&UartDefaultPort);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Default port DMA block
+///	\sa UartPort_TxDmaBlock
+/////////////////////////////////////////////////////////////////////////
+uint_fast8_t Uart_TxDmaBlock(const uint8_t ** source)
+{
+	return UartPort_TxDmaBlock(&UartDefaultPort, source);
+}
+
+/////////////////////////////////////////////////////////////////////////
+///	\brief	Default port DMA complete
+///	\sa UartPort_TxDmaComplete
+/////////////////////////////////////////////////////////////////////////
+void Uart_TxDmaComplete(uint_fast8_t length)
+{
+	UartPort_TxDmaComplete(&UartDefaultPort, length);
 }
@@ -31,10 +31,108 @@
 #define __UART_LAYER_MCU_H__
 	#include <stdint.h>
 	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Size of the transmit and receive ring buffers in bytes.
+	///	Must be a power of two and no bigger than 128.
+	/////////////////////////////////////////////////////////////////////////
+	#ifndef UART_BUFFER_SIZE
+		#define UART_BUFFER_SIZE 32
+	#endif
+
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	How many times Uart_ReadByte() polls the receive buffer
+	///	before giving up.
+	/////////////////////////////////////////////////////////////////////////
+	#ifndef UART_READ_TIMEOUT
+		#define UART_READ_TIMEOUT 100000UL
+	#endif
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	How many times the transmit buffer is polled for room or
+	///	for the last byte to go out before giving up.
+	/////////////////////////////////////////////////////////////////////////
+	#ifndef UART_WRITE_TIMEOUT
+		#define UART_WRITE_TIMEOUT 100000UL
+	#endif
+
+	// The ring index arithmetic relies on masking
+	#if (UART_BUFFER_SIZE & (UART_BUFFER_SIZE - 1)) || (UART_BUFFER_SIZE > 128)
+		#error UART_BUFFER_SIZE must be a power of two no bigger than 128
+	#endif
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Hardware used by UartDefaultPort. Point it at the MCU
+	///	peripheral the Uart_* calls should use.
+	/////////////////////////////////////////////////////////////////////////
+	#ifndef UART_DEFAULT_HARDWARE
+		#ifdef ONEWIRE_SIMULATION
+			#define UART_DEFAULT_HARDWARE (&OneWireSimBus)
+		#else
+			#define UART_DEFAULT_HARDWARE 0
+		#endif
+	#endif
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	Ring buffer. Head is only moved by the producer and Tail
+	///	only by the consumer, so one side can live in an interrupt without
+	///	any locking. Both are free running and wrap at 256.
+	/////////////////////////////////////////////////////////////////////////
+	typedef struct
+	{
+		uint8_t Buffer[UART_BUFFER_SIZE];	///< data storage
+		volatile uint8_t Head;				///< next free location
+		volatile uint8_t Tail;				///< next location to read
+	} UartRingType;
+	
+	/////////////////////////////////////////////////////////////////////////
+	///	\brief	One UART with its own buffers. Internal use only, set it
+	///	up with UartPort_Init().
+	/////////////////////////////////////////////////////////////////////////
+	typedef struct
+	{
+		UartRingType TxRing;				///< Transmit buffer
+		UartRingType RxRing;				///< Receive buffer
+		volatile uint_fast8_t TxComplete;	///< FALSE while a byte taken out of TxRing is still being sent. Only changed by the transmit side
+		volatile uint_fast8_t TxActive;		///< TRUE while the hardware is sending out of the transmit buffer
+		void *Hardware;						///< The MCU peripheral
+	} UartPortType;
+	
+	extern UartPortType UartDefaultPort;
+	
+	// Port layer
+	void UartPort_Init(UartPortType *port, void *hardware, uint32_t baud);
+	uint_fast8_t UartPort_Setbaud(UartPortType *port, uint32_t baud);
+	uint_fast8_t UartPort_Break(UartPortType *port, uint32_t low, uint32_t idle);
+	uint_fast8_t UartPort_Write(UartPortType *port, const uint8_t * source, uint_fast8_t length);
+	uint_fast8_t UartPort_Read(UartPortType *port, uint8_t * destination, uint_fast8_t length);
+	uint_fast8_t UartPort_WriteSpace(UartPortType *port);
+	uint_fast8_t UartPort_ReadAvailable(UartPortType *port);
+	uint_fast8_t UartPort_WriteComplete(UartPortType *port);
+	void UartPort_RxInterrupt(UartPortType *port, uint8_t data);
+	uint_fast8_t UartPort_TxInterrupt(UartPortType *port, uint8_t * destination);
+	void UartPort_TxCompleteInterrupt(UartPortType *port);
+	uint_fast8_t UartPort_TxDmaBlock(UartPortType *port, const uint8_t ** source);
+	void UartPort_TxDmaComplete(UartPortType *port, uint_fast8_t length);
+	
+	// Synchronous layer
 	void Uart_Init(uint32_t  baud);
-	void Uart_Setbaud(uint32_t  baud);
-	void Uart_WriteByte(uint8_t source);
+	uint_fast8_t Uart_Setbaud(uint32_t  baud);
+	uint_fast8_t Uart_WriteByte(uint8_t source);
 	uint_fast8_t Uart_WriteBusy(void);
 	uint_fast8_t Uart_ReadByte(uint8_t * destination);
 
+	// Buffered layer
+	uint_fast8_t Uart_Write(const uint8_t * source, uint_fast8_t length);
+	uint_fast8_t Uart_Read(uint8_t * destination, uint_fast8_t length);
+	uint_fast8_t Uart_WriteSpace(void);
+	uint_fast8_t Uart_ReadAvailable(void);
+	uint_fast8_t Uart_WriteComplete(void);
+
+	// Interrupt and DMA hooks. Call these from the MCU vectors
+	void Uart_RxInterrupt(uint8_t data);
+	uint_fast8_t Uart_TxInterrupt(uint8_t * destination);
+	void Uart_TxCompleteInterrupt(void);
+	uint_fast8_t Uart_TxDmaBlock(const uint8_t ** source);
+	void Uart_TxDmaComplete(uint_fast8_t length);
+
 #endif
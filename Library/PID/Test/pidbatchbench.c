@@ -0,0 +1,223 @@
+///////////////////////////////////////////////////////////////////////////
+/// \file pidbatchbench.c
+/// \brief host check and benchmark of the PID bank.
+///
+/// \section PIDBatchBenchmark PID bank benchmark
+///
+/// Runs a bank through PID_ProcessBatch() next to the same controllers as
+/// PIDType through PID_Process(), on random ranges, gains and readings.
+/// Every output and every stored error must be the same to the bit. The
+/// bank is a few short of PID_BANK_SIZE so the left over controllers take
+/// the scalar path after the vector one.
+///
+/// Then it times a full bank through both.
+///
+/// \code
+/// cd Library/PID/Test
+/// gcc -std=c99 -O2 -march=native -I.. -I../../1Wire pidbatchbench.c ../pid.c ../../1Wire/cyclecounter.c -o pidbatchbench && ./pidbatchbench
+/// \endcode
+///
+/// Build it without -march=native for the SSE path and with
+/// -DPID_BATCH_SIMD=0 for the scalar one. A count is one ns on the host
+/// and one CPU clock on Cortex-M, see cyclecounter.c.
+///
+///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
+///	Website: www.HashDefineElectronics.com
+///
+///	Licences:
+///
+///		Copyright (c) 2014 Ronald Alexander Nobrega De Sousa
+///
+///		Permission is hereby granted, free of charge, to any person obtaining a copy
+///		of this software and associated documentation files (the "Software"), to deal
+///		in the Software without restriction, including without limitation the rights
+///		to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+///		copies of the Software, and to permit persons to whom the Software is
+///		furnished to do so, subject to the following conditions:
+///
+///		The above copyright notice and this permission notice shall be included in
+///		all copies or substantial portions of the Software.
+///
+///		THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///		IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///		FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///		AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///		LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///		THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "pid.h"
+#include "cyclecounter.h"
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Controllers in the bank
+///////////////////////////////////////////////////////////////////////////
+#define PIDBATCHBENCH_COUNT (PID_BANK_SIZE - 3)
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief How many random banks are checked
+///////////////////////////////////////////////////////////////////////////
+#define PIDBATCHBENCH_SETS 2000
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief How many steps each bank runs for
+///////////////////////////////////////////////////////////////////////////
+#define PIDBATCHBENCH_STEPS 500
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief How many times the bank is timed
+///////////////////////////////////////////////////////////////////////////
+#define PIDBATCHBENCH_ROUNDS 100000UL
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief xorshift state, fixed seed so a failure can be repeated
+///////////////////////////////////////////////////////////////////////////
+static uint32_t PIDBatchBenchSeed = 0x2545F491UL;
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Keep the compiler from dropping the timed loops
+///////////////////////////////////////////////////////////////////////////
+static volatile float PIDBatchBenchSink;
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Random number between low and high
+///////////////////////////////////////////////////////////////////////////
+static float PIDBatchBench_Random(const float low, const float high)
+{
+    PIDBatchBenchSeed ^= PIDBatchBenchSeed << 13;
+    PIDBatchBenchSeed ^= PIDBatchBenchSeed >> 17;
+    PIDBatchBenchSeed ^= PIDBatchBenchSeed << 5;
+
+    return low + ((high - low) * (float)((double)PIDBatchBenchSeed / 4294967295.0));
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Compare two floats to the bit
+///////////////////////////////////////////////////////////////////////////
+static uint8_t PIDBatchBench_Same(const float a, const float b)
+{
+    return (memcmp(&a, &b, sizeof(float)) == 0);
+}
+
+int main(void)
+{
+    static PIDBankType Bank;
+    static PIDType Single[PIDBATCHBENCH_COUNT];
+    float Targets[PIDBATCHBENCH_COUNT];
+    float Actuals[PIDBATCHBENCH_COUNT];
+    float Outputs[PIDBATCHBENCH_COUNT];
+    float SamplingRate;
+    float Minimum;
+    float Limit;
+    float Maximum;
+    float Output;
+    uint32_t Errors = 0;
+    uint32_t Checked = 0;
+    uint32_t Start;
+    uint32_t BatchElapsed;
+    uint32_t SingleElapsed;
+    uint32_t Round;
+    uint32_t Set;
+    uint32_t Step;
+    uint16_t Index;
+
+    for(Set = 0; Set < PIDBATCHBENCH_SETS; Set++)
+    {
+        SamplingRate = PIDBatchBench_Random(0.001f, 1.0f);
+        Minimum = PIDBatchBench_Random(-10.0f, 0.0f);
+        Limit = PIDBatchBench_Random(0.1f, 10.0f);
+        Maximum = PIDBatchBench_Random(1.0f, 100.0f);
+
+        PID_BankInit(&Bank, SamplingRate, Minimum, Limit, Maximum);
+
+        for(Index = 0; Index < PIDBATCHBENCH_COUNT; Index++)
+        {
+            Single[Index].P = PIDBatchBench_Random(0.0f, 10.0f);
+            Single[Index].I = PIDBatchBench_Random(0.0f, 5.0f);
+            Single[Index].D = PIDBatchBench_Random(0.0f, 0.1f);
+            Single[Index].LastError = 0;
+            Single[Index].IntergralError = 0;
+
+            PID_Configure(&Single[Index], SamplingRate, Minimum, Limit, Maximum);
+
+            if(PID_BankAdd(&Bank, Single[Index].P, Single[Index].I, Single[Index].D) != (int16_t)Index)
+            {
+                Errors++;
+            }
+
+            Targets[Index] = PIDBatchBench_Random(0.0f, 100.0f);
+            Actuals[Index] = PIDBatchBench_Random(0.0f, 100.0f);
+        }
+
+        for(Step = 0; Step < PIDBATCHBENCH_STEPS; Step++)
+        {
+            // Random walk so the errors change sign and the integrals
+            // swing through both limits
+            for(Index = 0; Index < PIDBATCHBENCH_COUNT; Index++)
+            {
+                Targets[Index] += PIDBatchBench_Random(-1.0f, 1.0f);
+                Actuals[Index] += PIDBatchBench_Random(-1.0f, 1.0f);
+            }
+
+            PID_ProcessBatch(&Bank, Targets, Actuals, Outputs);
+
+            for(Index = 0; Index < PIDBATCHBENCH_COUNT; Index++)
+            {
+                Output = PID_Process(&Single[Index], Targets[Index], Actuals[Index]);
+
+                if(!PIDBatchBench_Same(Output, Outputs[Index]) ||
+                   !PIDBatchBench_Same(Single[Index].LastError, Bank.LastError[Index]) ||
+                   !PIDBatchBench_Same(Single[Index].IntergralError, Bank.IntergralError[Index]))
+                {
+                    if(Errors < 10)
+                    {
+                        printf("set %lu step %lu controller %u: batch %.9g, single %.9g\n",
+                            (unsigned long)Set, (unsigned long)Step, Index, Outputs[Index], Output);
+                    }
+
+                    Errors++;
+                }
+
+                Checked++;
+            }
+        }
+    }
+
+    CycleCounter_Init();
+
+    Start = CycleCounter_Read();
+
+    for(Round = 0; Round < PIDBATCHBENCH_ROUNDS; Round++)
+    {
+        PID_ProcessBatch(&Bank, Targets, Actuals, Outputs);
+        PIDBatchBenchSink = Outputs[Round % PIDBATCHBENCH_COUNT];
+    }
+
+    BatchElapsed = CycleCounter_Read() - Start;
+
+    Start = CycleCounter_Read();
+
+    for(Round = 0; Round < PIDBATCHBENCH_ROUNDS; Round++)
+    {
+        for(Index = 0; Index < PIDBATCHBENCH_COUNT; Index++)
+        {
+            Outputs[Index] = PID_Process(&Single[Index], Targets[Index], Actuals[Index]);
+        }
+
+        PIDBatchBenchSink = Outputs[Round % PIDBATCHBENCH_COUNT];
+    }
+
+    SingleElapsed = CycleCounter_Read() - Start;
+
+    printf("%lu outputs checked, %lu mismatches\n", (unsigned long)Checked, (unsigned long)Errors);
+    printf("batch %6.2f counts/bank  single %6.2f counts/bank  %u controllers  %s\n",
+        (double)BatchElapsed / (double)PIDBATCHBENCH_ROUNDS,
+        (double)SingleElapsed / (double)PIDBATCHBENCH_ROUNDS,
+        PIDBATCHBENCH_COUNT,
+        Errors ? "FAIL" : "ok");
+
+    return Errors ? 1 : 0;
+}
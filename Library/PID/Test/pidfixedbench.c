@@ -0,0 +1,273 @@
+///////////////////////////////////////////////////////////////////////////
+/// \file pidfixedbench.c
+/// \brief host check of the fixed point PID against the float one.
+///
+/// \section PIDFixedBenchmark Fixed point PID check
+///
+/// Runs PIDFixed_Process() next to PID_Process() and next to a double
+/// precision model of the fixed point math, on random gain and scale sets
+/// driving a simulated heater with random target steps. Both controllers
+/// see the same Q15 readings every step. Per sample the Q15 output must be:
+///
+/// - within PIDFIXEDBENCH_REFERENCE_LSB of the double model. This is the
+///   Q15 output rounding plus the Q31 rounding of the three terms.
+/// - within PIDFIXEDBENCH_FLOAT_LSB of PID_Process() times 32768. Most
+///   of this is the float version's own error, not the fixed point one.
+///   It rounds the readings, the gains and the error sum to 24 bits, and
+///   when a large P or D term cancels a large I term that rounding is
+///   a few LSB of the output. The worst seen is 2.9 LSB, with PID_Process()
+///   2.5 LSB from the double model against the fixed point 0.5.
+///
+/// So the fixed point output is the rounded exact result, half an LSB at
+/// most, and is within 3 LSB of PID_Process() over these gains.
+///
+/// \code
+/// cd Library/PID/Test
+/// gcc -std=c99 -O2 -I.. pidfixedbench.c ../pid.c -lm -o pidfixedbench && ./pidfixedbench
+/// \endcode
+///
+///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
+///	Website: www.HashDefineElectronics.com
+///
+///	Licences:
+///
+///		Copyright (c) 2014 Ronald Alexander Nobrega De Sousa
+///
+///		Permission is hereby granted, free of charge, to any person obtaining a copy
+///		of this software and associated documentation files (the "Software"), to deal
+///		in the Software without restriction, including without limitation the rights
+///		to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+///		copies of the Software, and to permit persons to whom the Software is
+///		furnished to do so, subject to the following conditions:
+///
+///		The above copyright notice and this permission notice shall be included in
+///		all copies or substantial portions of the Software.
+///
+///		THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///		IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///		FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///		AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///		LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///		THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include "pid.h"
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief How many random gain and scale sets are run
+///////////////////////////////////////////////////////////////////////////
+#define PIDFIXEDBENCH_SETS 4000
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief How many steps each set runs for
+///////////////////////////////////////////////////////////////////////////
+#define PIDFIXEDBENCH_STEPS 2000
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Largest difference from the double model, in Q15 LSB. Half an
+/// LSB of output rounding and three half Q31 LSBs of term rounding
+///////////////////////////////////////////////////////////////////////////
+#define PIDFIXEDBENCH_REFERENCE_LSB (0.5 + (1.5 / 65536.0))
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Largest difference from PID_Process(), in Q15 LSB
+///////////////////////////////////////////////////////////////////////////
+#define PIDFIXEDBENCH_FLOAT_LSB 3.0
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief xorshift state, fixed seed so a failure can be repeated
+///////////////////////////////////////////////////////////////////////////
+static uint32_t PIDFixedBenchSeed = 0x2545F491UL;
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief double model of PIDFixed_Process() with the same gains. The
+/// terms are exact, only the sum is rounded to Q15 at the end
+///////////////////////////////////////////////////////////////////////////
+typedef struct
+{
+    double P;               ///< P gain on a Q15 error, Q31 out
+    double I;               ///< I gain on a Q15 error sum, Q31 out
+    double D;               ///< D gain on a Q15 error difference, Q31 out
+    double Limit;           ///< Highest output, Q31
+    double Minimum;         ///< Lowest output, Q31
+    int32_t LastError;      ///< Last error, Q15
+    int64_t IntergralError; ///< Error sum, Q15, saturated like PIDFixed_Process()
+}PIDFixedBenchModelType;
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Random number between 0 and 1
+///////////////////////////////////////////////////////////////////////////
+static double PIDFixedBench_Random(void)
+{
+    PIDFixedBenchSeed ^= PIDFixedBenchSeed << 13;
+    PIDFixedBenchSeed ^= PIDFixedBenchSeed >> 17;
+    PIDFixedBenchSeed ^= PIDFixedBenchSeed << 5;
+
+    return (double)PIDFixedBenchSeed / 4294967295.0;
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Random number spread evenly over the decades between low and high
+///////////////////////////////////////////////////////////////////////////
+static double PIDFixedBench_RandomLog(const double low, const double high)
+{
+    return low * pow(high / low, PIDFixedBench_Random());
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief A gain as it was stored by PIDFixed_Init()
+///////////////////////////////////////////////////////////////////////////
+static double PIDFixedBench_Gain(const int32_t mantissa, const int8_t shift)
+{
+    return ldexp((double)mantissa, shift);
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Degrees to Q15, rounded and saturated
+///////////////////////////////////////////////////////////////////////////
+static int16_t PIDFixedBench_ToQ15(const double value, const double scale)
+{
+    double Scaled = floor((value * 32768.0 / scale) + 0.5);
+
+    if(Scaled > INT16_MAX)
+    {
+        return INT16_MAX;
+    }
+
+    if(Scaled < INT16_MIN)
+    {
+        return INT16_MIN;
+    }
+
+    return (int16_t)Scaled;
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief One step of the double model
+/// \return the output in Q15, not rounded
+///////////////////////////////////////////////////////////////////////////
+static double PIDFixedBench_Model(PIDFixedBenchModelType *model, const int16_t targetValue, const int16_t actualValue)
+{
+    int32_t CurrentError = (int32_t)targetValue - actualValue;
+    double Result;
+
+    model->IntergralError += CurrentError;
+
+    if(model->IntergralError > INT32_MAX)
+    {
+        model->IntergralError = INT32_MAX;
+    }
+    else if(model->IntergralError < INT32_MIN)
+    {
+        model->IntergralError = INT32_MIN;
+    }
+
+    Result =    (model->P * CurrentError) +
+                (model->I * (double)model->IntergralError) +
+                (model->D * (CurrentError - model->LastError));
+
+    model->LastError = CurrentError;
+
+    if(Result > model->Limit)
+    {
+        Result = model->Limit;
+    }
+    else if(Result <= model->Minimum)
+    {
+        Result = model->Minimum;
+    }
+
+    return Result / 65536.0;
+}
+
+int main(void)
+{
+    PIDType Float;
+    PIDFixedType Fixed;
+    PIDFixedBenchModelType Model;
+    double WorstFloat = 0;
+    double WorstModel = 0;
+    double WorstFloatModel = 0;
+    double Difference;
+    double Temperature;
+    double Target;
+    double Scale;
+    double Output;
+    uint32_t Errors = 0;
+    uint32_t Samples = 0;
+    uint32_t Set;
+    uint32_t Step;
+    int16_t TargetQ15;
+    int16_t ActualQ15;
+    int16_t FixedOutput;
+    float FloatOutput;
+
+    for(Set = 0; Set < PIDFIXEDBENCH_SETS; Set++)
+    {
+        // Gains from barely moving to railing on every step, and a range
+        // that covers the readings with some room to spare
+        Scale = ldexp(1.0, 5 + (int)(PIDFixedBench_Random() * 6.0)) * (1.0 + PIDFixedBench_Random());
+
+        Float.P = (float)PIDFixedBench_RandomLog(0.001, 10.0);
+        Float.I = (float)PIDFixedBench_RandomLog(0.001, 10.0);
+        Float.D = (float)((PIDFixedBench_Random() < 0.25) ? 0.0 : PIDFixedBench_RandomLog(0.00001, 0.1));
+        Float.LastError = 0;
+        Float.IntergralError = 0;
+        Float.Configured = 0;
+
+        PIDFixed_Init(&Fixed, Float.P, Float.I, Float.D, (float)Scale);
+
+        Model.P = PIDFixedBench_Gain(Fixed.P, Fixed.PShift);
+        Model.I = PIDFixedBench_Gain(Fixed.I, Fixed.IShift);
+        Model.D = PIDFixedBench_Gain(Fixed.D, Fixed.DShift);
+        Model.Limit = Fixed.Limit;
+        Model.Minimum = Fixed.Minimum;
+        Model.LastError = 0;
+        Model.IntergralError = 0;
+
+        Temperature = Scale * 0.2 * PIDFixedBench_Random();
+        Target = Temperature;
+
+        for(Step = 0; Step < PIDFIXEDBENCH_STEPS; Step++)
+        {
+            if(PIDFixedBench_Random() < 0.01)
+            {
+                Target = Scale * 0.8 * PIDFixedBench_Random();
+            }
+
+            TargetQ15 = PIDFixedBench_ToQ15(Target, Scale);
+            ActualQ15 = PIDFixedBench_ToQ15(Temperature, Scale);
+
+            FixedOutput = PIDFixed_Process(&Fixed, TargetQ15, ActualQ15);
+            FloatOutput = PID_Process(&Float, (float)(TargetQ15 * Scale / 32768.0), (float)(ActualQ15 * Scale / 32768.0));
+            Output = PIDFixedBench_Model(&Model, TargetQ15, ActualQ15);
+
+            Difference = fabs(FixedOutput - Output);
+            WorstModel = (Difference > WorstModel) ? Difference : WorstModel;
+            Errors += (Difference > PIDFIXEDBENCH_REFERENCE_LSB);
+
+            Difference = fabs(FixedOutput - ((double)FloatOutput * 32768.0));
+            WorstFloat = (Difference > WorstFloat) ? Difference : WorstFloat;
+            Errors += (Difference > PIDFIXEDBENCH_FLOAT_LSB);
+
+            Difference = fabs(((double)FloatOutput * 32768.0) - Output);
+            WorstFloatModel = (Difference > WorstFloatModel) ? Difference : WorstFloatModel;
+
+            Samples++;
+
+            // First order heater, full output gains a tenth of the range
+            // over ambient, with a bit of sensor noise
+            Temperature += 0.05 * ((Output / 32768.0 * Scale * 0.2) - Temperature) + (Scale * 0.0005 * (PIDFixedBench_Random() - 0.5));
+        }
+    }
+
+    printf("%lu samples\n", (unsigned long)Samples);
+    printf("PIDFixed_Process() to double model  worst %.4f LSB  limit %.4f\n", WorstModel, PIDFIXEDBENCH_REFERENCE_LSB);
+    printf("PIDFixed_Process() to PID_Process() worst %.4f LSB  limit %.4f\n", WorstFloat, PIDFIXEDBENCH_FLOAT_LSB);
+    printf("PID_Process() to double model       worst %.4f LSB  %s\n", WorstFloatModel, Errors ? "FAIL" : "ok");
+
+    return Errors ? 1 : 0;
+}
@@ -0,0 +1,239 @@
+///////////////////////////////////////////////////////////////////////////
+/// \file pidhppbench.cpp
+/// \brief host check and benchmark of the C++ PID template.
+///
+/// \section PIDHppBenchmark PID template benchmark
+///
+/// Feeds the same random readings to PID_Process() and to
+/// PIDController<float, ...>, and to PIDFixed_Process() and to
+/// PIDController<int16_t, ...>, with a tuning that matches the pid.c
+/// defaults. Every output must be the same to the bit, pid.hpp copies the
+/// pid.c algorithm and this is what catches the two drifting apart.
+///
+/// Then it times each pair over the same readings.
+///
+/// \code
+/// cd Library/PID/Test
+/// gcc -std=c99 -O2 -I.. -I../../1Wire -c ../pid.c ../../1Wire/cyclecounter.c
+/// g++ -std=c++11 -O2 -ffp-contract=off -I.. -I../../1Wire pidhppbench.cpp pid.o cyclecounter.o -o pidhppbench && ./pidhppbench
+/// \endcode
+///
+/// -ffp-contract=off matches pid.c, which turns fused multiply add off
+/// itself. Without it the template may fuse and round differently on a
+/// target with FMA. A count is one ns on the host and one CPU clock on
+/// Cortex-M, see cyclecounter.c.
+///
+///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
+///	Website: www.HashDefineElectronics.com
+///
+///	Licences:
+///
+///		Copyright (c) 2014 Ronald Alexander Nobrega De Sousa
+///
+///		Permission is hereby granted, free of charge, to any person obtaining a copy
+///		of this software and associated documentation files (the "Software"), to deal
+///		in the Software without restriction, including without limitation the rights
+///		to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+///		copies of the Software, and to permit persons to whom the Software is
+///		furnished to do so, subject to the following conditions:
+///
+///		The above copyright notice and this permission notice shall be included in
+///		all copies or substantial portions of the Software.
+///
+///		THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///		IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///		FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///		AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///		LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///		THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "pid.h"
+#include "pid.hpp"
+
+extern "C"
+{
+    #include "cyclecounter.h"
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief How many readings are fed through each controller
+///////////////////////////////////////////////////////////////////////////
+#define PIDHPPBENCH_SAMPLES 65536UL
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief How many times the readings are timed
+///////////////////////////////////////////////////////////////////////////
+#define PIDHPPBENCH_ROUNDS 20UL
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief The pid.c defaults, so PIDFixed_Init() and the Q15 template
+/// work out the same gains
+///////////////////////////////////////////////////////////////////////////
+struct PIDHppBenchTuning
+{
+    static constexpr double P = 2.0;
+    static constexpr double I = 0.5;
+    static constexpr double D = 0.01;
+    static constexpr double SamplingRate = 0.01;
+    static constexpr double Minimum = 0;
+    static constexpr double Limit = 5;
+    static constexpr double Maximum = 10;
+    static constexpr double Scale = 128;
+};
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief xorshift state, fixed seed so a failure can be repeated
+///////////////////////////////////////////////////////////////////////////
+static uint32_t PIDHppBenchSeed = 0x2545F491UL;
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Keep the compiler from dropping the timed loops
+///////////////////////////////////////////////////////////////////////////
+static volatile float PIDHppBenchFloatSink;
+static volatile int16_t PIDHppBenchFixedSink;
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief The readings, a target and an actual per sample
+///////////////////////////////////////////////////////////////////////////
+static float PIDHppBenchTargets[PIDHPPBENCH_SAMPLES];
+static float PIDHppBenchActuals[PIDHPPBENCH_SAMPLES];
+static int16_t PIDHppBenchTargetsQ15[PIDHPPBENCH_SAMPLES];
+static int16_t PIDHppBenchActualsQ15[PIDHPPBENCH_SAMPLES];
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Random number between low and high
+///////////////////////////////////////////////////////////////////////////
+static float PIDHppBench_Random(const float low, const float high)
+{
+    PIDHppBenchSeed ^= PIDHppBenchSeed << 13;
+    PIDHppBenchSeed ^= PIDHppBenchSeed >> 17;
+    PIDHppBenchSeed ^= PIDHppBenchSeed << 5;
+
+    return low + ((high - low) * (float)((double)PIDHppBenchSeed / 4294967295.0));
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Compare two floats to the bit
+///////////////////////////////////////////////////////////////////////////
+static bool PIDHppBench_Same(const float a, const float b)
+{
+    return (memcmp(&a, &b, sizeof(float)) == 0);
+}
+
+int main(void)
+{
+    PIDType Float;
+    PIDFixedType Fixed;
+    PIDController<float, PIDHppBenchTuning> FloatTemplate;
+    PIDController<int16_t, PIDHppBenchTuning> FixedTemplate;
+    uint32_t Errors = 0;
+    uint32_t Start;
+    uint32_t FloatElapsed;
+    uint32_t FloatTemplateElapsed;
+    uint32_t FixedElapsed;
+    uint32_t FixedTemplateElapsed;
+    uint32_t Round;
+    uint32_t Sample;
+    float Output;
+    int16_t FixedOutput;
+
+    // Hover around the target so the output spends time between the
+    // limits as well as on them
+    for(Sample = 0; Sample < PIDHPPBENCH_SAMPLES; Sample++)
+    {
+        PIDHppBenchTargets[Sample] = (Sample & 0x1000) ? 60.0f : 25.0f;
+        PIDHppBenchActuals[Sample] = PIDHppBenchTargets[Sample] + PIDHppBench_Random(-5.0f, 5.0f);
+        PIDHppBenchTargetsQ15[Sample] = (int16_t)(PIDHppBenchTargets[Sample] * 32768.0f / (float)PIDHppBenchTuning::Scale);
+        PIDHppBenchActualsQ15[Sample] = (int16_t)(PIDHppBenchActuals[Sample] * 32768.0f / (float)PIDHppBenchTuning::Scale);
+    }
+
+    memset(&Float, 0, sizeof(Float));
+    Float.P = (float)PIDHppBenchTuning::P;
+    Float.I = (float)PIDHppBenchTuning::I;
+    Float.D = (float)PIDHppBenchTuning::D;
+    PID_Configure(&Float, (float)PIDHppBenchTuning::SamplingRate, (float)PIDHppBenchTuning::Minimum, (float)PIDHppBenchTuning::Limit, (float)PIDHppBenchTuning::Maximum);
+
+    PIDFixed_Init(&Fixed, (float)PIDHppBenchTuning::P, (float)PIDHppBenchTuning::I, (float)PIDHppBenchTuning::D, (float)PIDHppBenchTuning::Scale);
+
+    for(Sample = 0; Sample < PIDHPPBENCH_SAMPLES; Sample++)
+    {
+        Output = PID_Process(&Float, PIDHppBenchTargets[Sample], PIDHppBenchActuals[Sample]);
+
+        if(!PIDHppBench_Same(Output, FloatTemplate.Process(PIDHppBenchTargets[Sample], PIDHppBenchActuals[Sample])))
+        {
+            Errors++;
+        }
+
+        FixedOutput = PIDFixed_Process(&Fixed, PIDHppBenchTargetsQ15[Sample], PIDHppBenchActualsQ15[Sample]);
+
+        if(FixedOutput != FixedTemplate.Process(PIDHppBenchTargetsQ15[Sample], PIDHppBenchActualsQ15[Sample]))
+        {
+            Errors++;
+        }
+    }
+
+    CycleCounter_Init();
+
+    Start = CycleCounter_Read();
+
+    for(Round = 0; Round < PIDHPPBENCH_ROUNDS; Round++)
+    {
+        for(Sample = 0; Sample < PIDHPPBENCH_SAMPLES; Sample++)
+        {
+            PIDHppBenchFloatSink = PID_Process(&Float, PIDHppBenchTargets[Sample], PIDHppBenchActuals[Sample]);
+        }
+    }
+
+    FloatElapsed = CycleCounter_Read() - Start;
+
+    Start = CycleCounter_Read();
+
+    for(Round = 0; Round < PIDHPPBENCH_ROUNDS; Round++)
+    {
+        for(Sample = 0; Sample < PIDHPPBENCH_SAMPLES; Sample++)
+        {
+            PIDHppBenchFloatSink = FloatTemplate.Process(PIDHppBenchTargets[Sample], PIDHppBenchActuals[Sample]);
+        }
+    }
+
+    FloatTemplateElapsed = CycleCounter_Read() - Start;
+
+    Start = CycleCounter_Read();
+
+    for(Round = 0; Round < PIDHPPBENCH_ROUNDS; Round++)
+    {
+        for(Sample = 0; Sample < PIDHPPBENCH_SAMPLES; Sample++)
+        {
+            PIDHppBenchFixedSink = PIDFixed_Process(&Fixed, PIDHppBenchTargetsQ15[Sample], PIDHppBenchActualsQ15[Sample]);
+        }
+    }
+
+    FixedElapsed = CycleCounter_Read() - Start;
+
+    Start = CycleCounter_Read();
+
+    for(Round = 0; Round < PIDHPPBENCH_ROUNDS; Round++)
+    {
+        for(Sample = 0; Sample < PIDHPPBENCH_SAMPLES; Sample++)
+        {
+            PIDHppBenchFixedSink = FixedTemplate.Process(PIDHppBenchTargetsQ15[Sample], PIDHppBenchActualsQ15[Sample]);
+        }
+    }
+
+    FixedTemplateElapsed = CycleCounter_Read() - Start;
+
+    printf("%lu outputs checked, %lu mismatches\n", (unsigned long)(PIDHPPBENCH_SAMPLES * 2), (unsigned long)Errors);
+    printf("PID_Process()      %6.2f counts/call  PIDController<float>   %6.2f counts/call\n",
+        (double)FloatElapsed / (double)(PIDHPPBENCH_SAMPLES * PIDHPPBENCH_ROUNDS),
+        (double)FloatTemplateElapsed / (double)(PIDHPPBENCH_SAMPLES * PIDHPPBENCH_ROUNDS));
+    printf("PIDFixed_Process() %6.2f counts/call  PIDController<int16_t> %6.2f counts/call  %s\n",
+        (double)FixedElapsed / (double)(PIDHPPBENCH_SAMPLES * PIDHPPBENCH_ROUNDS),
+        (double)FixedTemplateElapsed / (double)(PIDHPPBENCH_SAMPLES * PIDHPPBENCH_ROUNDS),
+        Errors ? "FAIL" : "ok");
+
+    return Errors ? 1 : 0;
+}
@@ -27,12 +27,35 @@
 ///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 ///		THE SOFTWARE.
 ///////////////////////////////////////////////////////////////////////////
-#include "mbed.h"
 #include "pid.h"
 
+// Keep a*b+c as a multiply and an add. A fused multiply add rounds once
+// instead of twice, and the compiler fuses the scalar and vector paths
+// differently, so PID_ProcessBatch() would no longer match PID_Process()
+// to the bit. GCC fuses by default when the target has FMA, ie.
+// -march=native or a Cortex-M4F, and ignores the standard pragma.
+#if defined(__clang__)
+    #pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+    #pragma GCC optimize ("fp-contract=off")
+#else
+    #pragma STDC FP_CONTRACT OFF
+#endif
+
+#if PID_BATCH_SIMD
+    #if defined(__AVX__)
+        #include <immintrin.h>
+    #elif defined(__SSE__) || defined(_M_X64)
+        #include <xmmintrin.h>
+    #elif defined(ARM_MATH_CM4) || defined(ARM_MATH_CM7)
+        #include "arm_math.h"
+    #endif
+#endif
+
 ///////////////////////////////////////////////////////////////////////////
 /// \brief Defines the sampling constant used by the PID: ie. dt 
-/// (See Heater interrupt)
+/// (See Heater interrupt). This and the output limits below are the
+/// defaults for the controllers that PID_Configure() wasn't called on
 ///////////////////////////////////////////////////////////////////////////
 const float SamplingRateMs = 0.01;
 ///////////////////////////////////////////////////////////////////////////
@@ -59,7 +82,45 @@ void PID_Init(void)
 }
 
 ///////////////////////////////////////////////////////////////////////////
-/// \brief PID process controller. re-entry
+/// \brief Work out the discrete coefficients so the process only has to
+/// multiply and add
+/// \param pidParameter the pid parameter with its gains set
+/// \param samplingRate dt
+/// \param minimum lowest output before scaling
+/// \param limit highest output before scaling
+/// \param maximum output scaling
+///////////////////////////////////////////////////////////////////////////
+static void PID_Coefficients(PIDType *pidParameter, const float samplingRate, const float minimum, const float limit, const float maximum)
+{
+    pidParameter->SamplingRate = samplingRate;
+    pidParameter->Minimum = minimum;
+    pidParameter->Limit = limit;
+    pidParameter->Maximum = maximum;
+    
+    pidParameter->IntegralGain = pidParameter->I * samplingRate;
+    pidParameter->DerivativeGain = pidParameter->D / samplingRate;
+    pidParameter->InverseMaximum = 1.0f / maximum;
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Give a controller its own sampling rate and output range, so
+/// loops can run at different rates. Set the P, I and D gains first and
+/// call it again whenever they change
+/// \param pidParameter the pid parameter with its gains set
+/// \param samplingRate dt, the time between PID_Process() calls
+/// \param minimum lowest output before scaling
+/// \param limit highest output before scaling
+/// \param maximum the output is divided by this. ie. the PWM full scale
+///////////////////////////////////////////////////////////////////////////
+void PID_Configure(PIDType *pidParameter, const float samplingRate, const float minimum, const float limit, const float maximum)
+{
+    PID_Coefficients(pidParameter, samplingRate, minimum, limit, maximum);
+    pidParameter->Configured = 1;
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief PID process controller. re-entry. A controller that 
+/// PID_Configure() wasn't called on uses the file defaults
 /// \param pidParameter the pid parameter where the funciton stores is last
 /// know error and also hold the PID charateristics
 /// \param targetValue the target value to which the PID will aim for
@@ -74,31 +135,600 @@ float PID_Process(PIDType *pidParameter, const float targetValue, const float ac
     // Calculate the current error between our target value and 
     // whatthe sensor are reading
     float CurrentError = ((float)targetValue - actualValue);
-    // Take the diferent between last error and current error
-    float DerivedError = ((CurrentError - pidParameter->LastError)/SamplingRateMs);
-    // Take the sum of the last error
-    pidParameter->IntergralError += (CurrentError*SamplingRateMs);
+    // Take the diferent between last error and current error. dt is in the D gain
+    float DerivedError = (CurrentError - pidParameter->LastError);
+    
+    if(!pidParameter->Configured)
+    {
+        // Pick up gain changes the same way as before PID_Configure() existed
+        PID_Coefficients(pidParameter, SamplingRateMs, MinimumOuput, LimitOuput, MaximunOuput);
+    }
+    
+    // Take the sum of the last error. dt is in the I gain
+    pidParameter->IntergralError += CurrentError;
     
     // Calculate the new adjust PWM
     Result =    (pidParameter->P * CurrentError) +
-                (pidParameter->I * pidParameter->IntergralError) +
-                (pidParameter->D * DerivedError);
+                (pidParameter->IntegralGain * pidParameter->IntergralError) +
+                (pidParameter->DerivativeGain * DerivedError);
 
     // Now update the last error
     pidParameter->LastError = CurrentError;
     
     // Lets make sure that the Result are within limits
-    if(Result > LimitOuput)
+    if(Result > pidParameter->Limit)
     {
-        Result = LimitOuput;
+        Result = pidParameter->Limit;
        //return  1;//MaximunOuput;
     }
-    else if(Result <= MinimumOuput)
+    else if(Result <= pidParameter->Minimum)
     {
-        Result = MinimumOuput;
+        Result = pidParameter->Minimum;
         
     }
     
     //Return the new PWM value
-    return (Result/MaximunOuput);
+    return (Result * pidParameter->InverseMaximum);
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Saturate to a Q31 value
+///////////////////////////////////////////////////////////////////////////
+static int32_t PIDFixed_SaturateQ31(const int64_t value)
+{
+    if(value > INT32_MAX)
+    {
+        return INT32_MAX;
+    }
+    
+    if(value < INT32_MIN)
+    {
+        return INT32_MIN;
+    }
+    
+    return (int32_t)value;
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Convert a float to Q31, saturating at +-1
+///////////////////////////////////////////////////////////////////////////
+static int32_t PIDFixed_ToQ31(const float value)
+{
+    if(value >= 1.0f)
+    {
+        return INT32_MAX;
+    }
+    
+    if(value <= -1.0f)
+    {
+        return INT32_MIN;
+    }
+    
+    return (int32_t)(value * 2147483648.0f);
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Split a gain in to a Q31 mantissa and a power of two exponent.
+/// Only runs at init so the float math is fine on FPU-less parts too
+/// \param gain the gain
+/// \param mantissa returns the mantissa, 0.5 to 1 in Q31
+/// \param shift returns the exponent
+///////////////////////////////////////////////////////////////////////////
+static void PIDFixed_Gain(float gain, int32_t *mantissa, int8_t *shift)
+{
+    int8_t Exponent = 0;
+    float Magnitude = (gain < 0) ? -gain : gain;
+    
+    if(Magnitude == 0)
+    {
+        *mantissa = 0;
+        *shift = 0;
+        return;
+    }
+    
+    while(Magnitude >= 1.0f)
+    {
+        Magnitude *= 0.5f;
+        Exponent++;
+    }
+    
+    while(Magnitude < 0.5f)
+    {
+        Magnitude *= 2.0f;
+        Exponent--;
+    }
+    
+    // Exact, the float mantissa is only 24 bits
+    *mantissa = (int32_t)(Magnitude * 2147483648.0f);
+    
+    if(gain < 0)
+    {
+        *mantissa = -*mantissa;
+    }
+    
+    // A Q15 value times the mantissa lines up with Q31 after this shift
+    *shift = Exponent - 15;
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Multiply by a gain. The result is Q31 with 31 bits of headroom
+/// so a term far outside the output range can't wrap, and it saturates a
+/// quarter of the way to the int64_t limits so the three terms can still
+/// be added together.
+/// \param mantissa the gain mantissa
+/// \param shift the gain exponent
+/// \param value the Q15 value
+/// \return the result in Q31
+///////////////////////////////////////////////////////////////////////////
+static int64_t PIDFixed_Multiply(const int32_t mantissa, const int8_t shift, const int32_t value)
+{
+    const int64_t TermMax = INT64_MAX >> 2;
+    int64_t Result = (int64_t)mantissa * value;
+    
+    if(shift >= 0)
+    {
+        if((shift > 61) || (Result > (TermMax >> shift)) || (Result < -(TermMax >> shift)))
+        {
+            return (Result > 0) ? TermMax : ((Result < 0) ? -TermMax : 0);
+        }
+        
+        return Result * ((int64_t)1 << shift);
+    }
+    
+    if(shift < -62)
+    {
+        return 0;
+    }
+    
+    // Round to nearest
+    return (Result + ((int64_t)1 << (-shift - 1))) >> -shift;
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Setup a fixed point PID controller. The sampling rate and the
+/// output limits are folded in to the gains here so the process needs no
+/// division.
+/// \param pidParameter the pid parameter to setup
+/// \param p the P gain, same as PIDType
+/// \param i the I gain, same as PIDType
+/// \param d the D gain, same as PIDType
+/// \param scale the target and actual value that maps to 1.0 in Q15. 
+/// ie. 128 to cover +-128 degree C
+///////////////////////////////////////////////////////////////////////////
+void PIDFixed_Init(PIDFixedType *pidParameter, const float p, const float i, const float d, const float scale)
+{
+    PIDFixed_Gain(p * scale / MaximunOuput, &pidParameter->P, &pidParameter->PShift);
+    PIDFixed_Gain(i * SamplingRateMs * scale / MaximunOuput, &pidParameter->I, &pidParameter->IShift);
+    PIDFixed_Gain(d * scale / (SamplingRateMs * MaximunOuput), &pidParameter->D, &pidParameter->DShift);
+    
+    pidParameter->Limit = PIDFixed_ToQ31(LimitOuput / MaximunOuput);
+    pidParameter->Minimum = PIDFixed_ToQ31(MinimumOuput / MaximunOuput);
+    pidParameter->LastError = 0;
+    pidParameter->IntergralError = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Fixed point PID process controller. re-entry. Same as 
+/// PID_Process() with Q15 values, integer math only and saturating 
+/// instead of overflowing
+/// \param pidParameter the pid parameter set up by PIDFixed_Init()
+/// \param targetValue the target value in Q15, see scale
+/// \param actualValue the reading from the temperature sensor in Q15
+///
+/// \return return heater PWM value in Q15
+///////////////////////////////////////////////////////////////////////////
+int16_t PIDFixed_Process(PIDFixedType *pidParameter, const int16_t targetValue, const int16_t actualValue)
+{
+    int64_t Result;
+    
+    // The error can be twice the Q15 range so keep the extra bit
+    int32_t CurrentError = (int32_t)targetValue - actualValue;
+    
+    // Take the sum of the last error. dt is in the I gain
+    pidParameter->IntergralError = PIDFixed_SaturateQ31((int64_t)pidParameter->IntergralError + CurrentError);
+    
+    // Calculate the new adjust PWM
+    Result =    PIDFixed_Multiply(pidParameter->P, pidParameter->PShift, CurrentError) +
+                PIDFixed_Multiply(pidParameter->I, pidParameter->IShift, pidParameter->IntergralError) +
+                PIDFixed_Multiply(pidParameter->D, pidParameter->DShift, CurrentError - pidParameter->LastError);
+    
+    // Now update the last error
+    pidParameter->LastError = CurrentError;
+    
+    // Lets make sure that the Result are within limits
+    if(Result > pidParameter->Limit)
+    {
+        Result = pidParameter->Limit;
+    }
+    else if(Result <= pidParameter->Minimum)
+    {
+        Result = pidParameter->Minimum;
+    }
+    
+    // Q31 to Q15, rounded. The limits are already scaled by MaximunOuput
+    Result = (Result + 0x8000) >> 16;
+    
+    if(Result > INT16_MAX)
+    {
+        Result = INT16_MAX;
+    }
+    
+    return (int16_t)Result;
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Work out the velocity form coefficients, so the process is three
+/// multiplies for the change in output
+/// \param pidParameter the pid parameter with its gains and range set
+///////////////////////////////////////////////////////////////////////////
+static void PIDVelocity_Coefficients(PIDVelocityType *pidParameter)
+{
+    float DerivativeGain = pidParameter->D / pidParameter->SamplingRate;
+    float TrackingGain = pidParameter->TrackingGain;
+    
+    pidParameter->ErrorGain = pidParameter->P + (pidParameter->I * pidParameter->SamplingRate) + DerivativeGain;
+    pidParameter->LastErrorGain = -(pidParameter->P + (2.0f * DerivativeGain));
+    pidParameter->PreviousErrorGain = DerivativeGain;
+    
+    if((TrackingGain <= 0) && (pidParameter->P != 0))
+    {
+        TrackingGain = pidParameter->I / pidParameter->P;
+    }
+    
+    pidParameter->Tracking = TrackingGain * pidParameter->SamplingRate;
+    
+    // Tracking more than the whole gap in one step would overshoot it and
+    // no tracking at all would wind up, both end up as plain clamping
+    if((pidParameter->Tracking > 1.0f) || (pidParameter->Tracking <= 0))
+    {
+        pidParameter->Tracking = 1.0f;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Setup a velocity form PID controller with the file defaults
+/// for the sampling rate and output range, and clamping anti-windup.
+/// \param pidParameter the pid parameter to setup
+/// \param p the P gain, same as PIDType
+/// \param i the I gain, same as PIDType
+/// \param d the D gain, same as PIDType
+///////////////////////////////////////////////////////////////////////////
+void PIDVelocity_Init(PIDVelocityType *pidParameter, const float p, const float i, const float d)
+{
+    pidParameter->P = p;
+    pidParameter->I = i;
+    pidParameter->D = d;
+    pidParameter->AntiWindup = PID_Clamping;
+    pidParameter->TrackingGain = 0;
+    pidParameter->LastError = 0;
+    pidParameter->PreviousError = 0;
+    
+    PIDVelocity_Configure(pidParameter, SamplingRateMs, MinimumOuput, LimitOuput, MaximunOuput);
+    
+    // Start from zero like PID_Process(), within the limits
+    pidParameter->Output = 0;
+    
+    if(pidParameter->Output > pidParameter->Limit)
+    {
+        pidParameter->Output = pidParameter->Limit;
+    }
+    else if(pidParameter->Output <= pidParameter->Minimum)
+    {
+        pidParameter->Output = pidParameter->Minimum;
+    }
+    
+    pidParameter->Unsaturated = pidParameter->Output;
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Give a velocity form controller its own sampling rate and output
+/// range. Call it again whenever the gains change, the state is kept so
+/// the output doesn't jump
+/// \param pidParameter the pid parameter set up by PIDVelocity_Init()
+/// \param samplingRate dt, the time between PIDVelocity_Process() calls
+/// \param minimum lowest output before scaling
+/// \param limit highest output before scaling
+/// \param maximum the output is divided by this. ie. the PWM full scale
+///////////////////////////////////////////////////////////////////////////
+void PIDVelocity_Configure(PIDVelocityType *pidParameter, const float samplingRate, const float minimum, const float limit, const float maximum)
+{
+    pidParameter->SamplingRate = samplingRate;
+    pidParameter->Minimum = minimum;
+    pidParameter->Limit = limit;
+    pidParameter->InverseMaximum = 1.0f / maximum;
+    
+    PIDVelocity_Coefficients(pidParameter);
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Pick how the controller stops winding up
+/// \param pidParameter the pid parameter set up by PIDVelocity_Init()
+/// \param mode PID_Clamping or PID_BackCalculation
+/// \param trackingGain only used by PID_BackCalculation. How fast the
+/// unclamped output is pulled back to the limits, in 1 over the sampling
+/// rate units. 0 picks I over P. When it times dt is 1 or more it is the
+/// same as PID_Clamping
+///////////////////////////////////////////////////////////////////////////
+void PIDVelocity_AntiWindup(PIDVelocityType *pidParameter, const PIDAntiWindupEnum mode, const float trackingGain)
+{
+    pidParameter->AntiWindup = (uint8_t)mode;
+    pidParameter->TrackingGain = trackingGain;
+    pidParameter->Unsaturated = pidParameter->Output;
+    
+    PIDVelocity_Coefficients(pidParameter);
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Velocity form PID process controller. re-entry. Adds the change
+/// in output to the last output, so nothing grows while the output is
+/// held at a limit. Same output as PID_Process() while within the limits
+/// \param pidParameter the pid parameter set up by PIDVelocity_Init()
+/// \param targetValue the target value to which the PID will aim for
+/// \param actualValue the reading from the temperature sensor
+///
+/// \return return heater PWM value
+///////////////////////////////////////////////////////////////////////////
+float PIDVelocity_Process(PIDVelocityType *pidParameter, const float targetValue, const float actualValue)
+{
+    float Result;
+    float CurrentError = (targetValue - actualValue);
+    
+    // Change in output. The I term is the error times dt and the D term 
+    // the change in the error difference
+    float Delta =   (pidParameter->ErrorGain * CurrentError) +
+                    (pidParameter->LastErrorGain * pidParameter->LastError) +
+                    (pidParameter->PreviousErrorGain * pidParameter->PreviousError);
+    
+    pidParameter->PreviousError = pidParameter->LastError;
+    pidParameter->LastError = CurrentError;
+    
+    if(pidParameter->AntiWindup == PID_BackCalculation)
+    {
+        // Let the output run past the limit but pull it back by the 
+        // tracking gain, so it comes off the limit soon after the error turns
+        Result = pidParameter->Unsaturated + Delta + (pidParameter->Tracking * (pidParameter->Output - pidParameter->Unsaturated));
+    }
+    else
+    {
+        Result = pidParameter->Output + Delta;
+    }
+    
+    pidParameter->Unsaturated = Result;
+    
+    // Lets make sure that the Result are within limits
+    if(Result > pidParameter->Limit)
+    {
+        Result = pidParameter->Limit;
+    }
+    else if(Result <= pidParameter->Minimum)
+    {
+        Result = pidParameter->Minimum;
+    }
+    
+    pidParameter->Output = Result;
+    
+    return (Result * pidParameter->InverseMaximum);
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Setup an empty bank of controllers
+/// \param bank the bank
+/// \param samplingRate dt, the time between PID_ProcessBatch() calls
+/// \param minimum lowest output before scaling
+/// \param limit highest output before scaling
+/// \param maximum the outputs are divided by this. ie. the PWM full scale
+///////////////////////////////////////////////////////////////////////////
+void PID_BankInit(PIDBankType *bank, const float samplingRate, const float minimum, const float limit, const float maximum)
+{
+    bank->Count = 0;
+    bank->Minimum = minimum;
+    bank->Limit = limit;
+    bank->SamplingRate = samplingRate;
+    bank->InverseMaximum = 1.0f / maximum;
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Add a controller to the bank
+/// \param bank the bank
+/// \param p the P gain
+/// \param i the I gain
+/// \param d the D gain
+///
+/// \return the controller index in the bank or -1 if it's full
+///////////////////////////////////////////////////////////////////////////
+int16_t PID_BankAdd(PIDBankType *bank, const float p, const float i, const float d)
+{
+    uint16_t Index = bank->Count;
+    
+    if(Index >= PID_BANK_SIZE)
+    {
+        return -1;
+    }
+    
+    // Same coefficients as PID_Configure()
+    bank->P[Index] = p;
+    bank->IntegralGain[Index] = i * bank->SamplingRate;
+    bank->DerivativeGain[Index] = d / bank->SamplingRate;
+    bank->LastError[Index] = 0;
+    bank->IntergralError[Index] = 0;
+    bank->Count++;
+    
+    return (int16_t)Index;
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Run one controller of the bank. The operations are in the same
+/// order as PID_Process() so the results are the same to the bit
+/// \param bank the bank
+/// \param index the controller
+/// \param targetValue the target value
+/// \param actualValue the reading
+///
+/// \return return heater PWM value
+///////////////////////////////////////////////////////////////////////////
+static float PID_BatchOne(PIDBankType *bank, const uint16_t index, const float targetValue, const float actualValue)
+{
+    float Result;
+    float CurrentError = (targetValue - actualValue);
+    float DerivedError = (CurrentError - bank->LastError[index]);
+    
+    bank->IntergralError[index] += CurrentError;
+    
+    Result =    (bank->P[index] * CurrentError) +
+                (bank->IntegralGain[index] * bank->IntergralError[index]) +
+                (bank->DerivativeGain[index] * DerivedError);
+    
+    bank->LastError[index] = CurrentError;
+    
+    if(Result > bank->Limit)
+    {
+        Result = bank->Limit;
+    }
+    else if(Result <= bank->Minimum)
+    {
+        Result = bank->Minimum;
+    }
+    
+    return (Result * bank->InverseMaximum);
+}
+
+#if PID_BATCH_SIMD && defined(__AVX__)
+///////////////////////////////////////////////////////////////////////////
+/// \brief Width of the vector path
+///////////////////////////////////////////////////////////////////////////
+#define PID_BATCH_WIDTH 8
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Run 8 controllers of the bank with AVX. Same per lane 
+/// operations as PID_BatchOne()
+///////////////////////////////////////////////////////////////////////////
+static void PID_BatchVector(PIDBankType *bank, const uint16_t index, const float *targetValues, const float *actualValues, float *outputs)
+{
+    __m256 Error = _mm256_sub_ps(_mm256_loadu_ps(&targetValues[index]), _mm256_loadu_ps(&actualValues[index]));
+    __m256 Derived = _mm256_sub_ps(Error, _mm256_loadu_ps(&bank->LastError[index]));
+    __m256 Integral = _mm256_add_ps(_mm256_loadu_ps(&bank->IntergralError[index]), Error);
+    __m256 Limit = _mm256_set1_ps(bank->Limit);
+    __m256 Minimum = _mm256_set1_ps(bank->Minimum);
+    __m256 Over;
+    __m256 Result;
+    
+    Result =    _mm256_add_ps(_mm256_add_ps(
+                _mm256_mul_ps(_mm256_loadu_ps(&bank->P[index]), Error),
+                _mm256_mul_ps(_mm256_loadu_ps(&bank->IntegralGain[index]), Integral)),
+                _mm256_mul_ps(_mm256_loadu_ps(&bank->DerivativeGain[index]), Derived));
+    
+    _mm256_storeu_ps(&bank->IntergralError[index], Integral);
+    _mm256_storeu_ps(&bank->LastError[index], Error);
+    
+    // Above the limit wins over at or below the minimum, like the scalar code
+    Over = _mm256_cmp_ps(Result, Limit, _CMP_GT_OQ);
+    Result = _mm256_blendv_ps(Result, Minimum, _mm256_cmp_ps(Result, Minimum, _CMP_LE_OQ));
+    Result = _mm256_blendv_ps(Result, Limit, Over);
+    
+    _mm256_storeu_ps(&outputs[index], _mm256_mul_ps(Result, _mm256_set1_ps(bank->InverseMaximum)));
+}
+
+#elif PID_BATCH_SIMD && (defined(__SSE__) || defined(_M_X64))
+///////////////////////////////////////////////////////////////////////////
+/// \brief Width of the vector path
+///////////////////////////////////////////////////////////////////////////
+#define PID_BATCH_WIDTH 4
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Run 4 controllers of the bank with SSE. Same per lane 
+/// operations as PID_BatchOne()
+///////////////////////////////////////////////////////////////////////////
+static void PID_BatchVector(PIDBankType *bank, const uint16_t index, const float *targetValues, const float *actualValues, float *outputs)
+{
+    __m128 Error = _mm_sub_ps(_mm_loadu_ps(&targetValues[index]), _mm_loadu_ps(&actualValues[index]));
+    __m128 Derived = _mm_sub_ps(Error, _mm_loadu_ps(&bank->LastError[index]));
+    __m128 Integral = _mm_add_ps(_mm_loadu_ps(&bank->IntergralError[index]), Error);
+    __m128 Limit = _mm_set1_ps(bank->Limit);
+    __m128 Minimum = _mm_set1_ps(bank->Minimum);
+    __m128 Over;
+    __m128 Under;
+    __m128 Result;
+    
+    Result =    _mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(_mm_loadu_ps(&bank->P[index]), Error),
+                _mm_mul_ps(_mm_loadu_ps(&bank->IntegralGain[index]), Integral)),
+                _mm_mul_ps(_mm_loadu_ps(&bank->DerivativeGain[index]), Derived));
+    
+    _mm_storeu_ps(&bank->IntergralError[index], Integral);
+    _mm_storeu_ps(&bank->LastError[index], Error);
+    
+    // SSE has no blend, so select with masks. Above the limit wins over at
+    // or below the minimum, like the scalar code
+    Over = _mm_cmpgt_ps(Result, Limit);
+    Under = _mm_andnot_ps(Over, _mm_cmple_ps(Result, Minimum));
+    Result = _mm_or_ps(_mm_andnot_ps(_mm_or_ps(Over, Under), Result),
+             _mm_or_ps(_mm_and_ps(Over, Limit), _mm_and_ps(Under, Minimum)));
+    
+    _mm_storeu_ps(&outputs[index], _mm_mul_ps(Result, _mm_set1_ps(bank->InverseMaximum)));
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////
+/// \brief Run every controller in the bank once. Call it every
+/// SamplingRate. Uses AVX or SSE on the host and CMSIS-DSP on a Cortex-M4/M7
+/// target, the left over controllers and every other target take the
+/// scalar path. All paths do the same single precision operations in the
+/// same order as PID_Process(), so a bank controller gives the same output
+/// to the bit as a PIDType set up with the same PID_Configure() values.
+/// That needs fused multiply add contraction off, the top of this file
+/// turns it off whatever the build flags.
+///
+/// \param bank the bank
+/// \param targetValues the target value of each controller
+/// \param actualValues the reading of each controller
+/// \param outputs returns the heater PWM value of each controller
+///////////////////////////////////////////////////////////////////////////
+void PID_ProcessBatch(PIDBankType *bank, const float *targetValues, const float *actualValues, float *outputs)
+{
+    uint16_t Index = 0;
+    uint16_t Count = bank->Count;
+    
+#if PID_BATCH_SIMD && defined(PID_BATCH_WIDTH)
+    for( ; (uint16_t)(Index + PID_BATCH_WIDTH) <= Count; Index += PID_BATCH_WIDTH)
+    {
+        PID_BatchVector(bank, Index, targetValues, actualValues, outputs);
+    }
+#elif PID_BATCH_SIMD && (defined(ARM_MATH_CM4) || defined(ARM_MATH_CM7))
+    float Error[PID_BANK_SIZE];
+    float Derived[PID_BANK_SIZE];
+    float Term[PID_BANK_SIZE];
+    
+    // The M4 SIMD instructions are integer only, single precision goes
+    // through the FPU either way. CMSIS-DSP still unrolls the loops and
+    // keeps the pipeline full
+    arm_sub_f32((float32_t *)targetValues, (float32_t *)actualValues, Error, Count);
+    arm_sub_f32(Error, bank->LastError, Derived, Count);
+    arm_add_f32(bank->IntergralError, Error, bank->IntergralError, Count);
+    arm_copy_f32(Error, bank->LastError, Count);
+    
+    arm_mult_f32(bank->P, Error, outputs, Count);
+    arm_mult_f32(bank->IntegralGain, bank->IntergralError, Term, Count);
+    arm_add_f32(outputs, Term, outputs, Count);
+    arm_mult_f32(bank->DerivativeGain, Derived, Term, Count);
+    arm_add_f32(outputs, Term, outputs, Count);
+    
+    for( ; Index < Count; Index++)
+    {
+        if(outputs[Index] > bank->Limit)
+        {
+            outputs[Index] = bank->Limit;
+        }
+        else if(outputs[Index] <= bank->Minimum)
+        {
+            outputs[Index] = bank->Minimum;
+        }
+    }
+    
+    arm_scale_f32(outputs, bank->InverseMaximum, outputs, Count);
+#endif
+    
+    for( ; Index < Count; Index++)
+    {
+        outputs[Index] = PID_BatchOne(bank, Index, targetValues[Index], actualValues[Index]);
+    }
 }
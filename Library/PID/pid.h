@@ -29,6 +29,7 @@
 ///////////////////////////////////////////////////////////////////////////
 #ifndef     __PID_H__
 #define     __PID_H__
+    #include <stdint.h>
 
 
     ///////////////////////////////////////////////////////////////////////////
@@ -41,11 +42,130 @@
         float D;				///< P gain
         float LastError;		///< Last calculated  Error. Internal use only
         float IntergralError; 	///< Intergral error. Internal use only
+        float SamplingRate;		///< dt. Set by PID_Configure()
+        float Minimum;			///< Lowest output before scaling. Set by PID_Configure()
+        float Limit;			///< Highest output before scaling. Set by PID_Configure()
+        float Maximum;			///< Output scaling, the output is divided by it. Set by PID_Configure()
+        float IntegralGain;		///< I times dt. Internal use only
+        float DerivativeGain;	///< D over dt. Internal use only
+        float InverseMaximum;	///< 1 over Maximum. Internal use only
+        uint8_t Configured;		///< 1 once PID_Configure() was called. Internal use only
         
     }PIDType;
     
+    ///////////////////////////////////////////////////////////////////////////
+    /// \brief fixed point PID data type. The gains are kept as a Q31 
+    /// mantissa and a power of two exponent so small and large gains keep
+    /// the same precision. Set it up with PIDFixed_Init()
+    ///////////////////////////////////////////////////////////////////////////
+    typedef struct
+    {
+        int32_t P; 				///< P gain mantissa, Q31
+        int32_t I;				///< I gain times dt mantissa, Q31
+        int32_t D;				///< D gain over dt mantissa, Q31
+        int8_t PShift;			///< P gain exponent. Internal use only
+        int8_t IShift;			///< I gain exponent. Internal use only
+        int8_t DShift;			///< D gain exponent. Internal use only
+        int32_t Limit;			///< Highest output, Q31. Internal use only
+        int32_t Minimum;		///< Lowest output, Q31. Internal use only
+        int32_t LastError;		///< Last calculated  Error, Q15. Internal use only
+        int32_t IntergralError; 	///< Sum of the errors, Q15. Internal use only
+        
+    }PIDFixedType;
+    
+    ///////////////////////////////////////////////////////////////////////////
+    /// \brief how PIDVelocity_Process() keeps the output from winding up
+    ///////////////////////////////////////////////////////////////////////////
+    typedef enum
+    {
+        PID_Clamping = 0,			///< The output is clamped and the clamped value is the state
+        PID_BackCalculation			///< The unclamped output is pulled back to the limits by the tracking gain
+    }PIDAntiWindupEnum;
+    
+    ///////////////////////////////////////////////////////////////////////////
+    /// \brief velocity form PID data type. Works out the change in output
+    /// each step instead of summing the error, so the state is only the
+    /// last two errors and the last output. Set it up with 
+    /// PIDVelocity_Init()
+    ///////////////////////////////////////////////////////////////////////////
+    typedef struct
+    {
+        float P; 				///< P gain
+        float I;				///< I gain
+        float D;				///< D gain
+        float TrackingGain;		///< Back calculation gain, 1 over the tracking time. Set by PIDVelocity_AntiWindup()
+        uint8_t AntiWindup;		///< PIDAntiWindupEnum. Set by PIDVelocity_AntiWindup()
+        float SamplingRate;		///< dt. Set by PIDVelocity_Configure()
+        float Minimum;			///< Lowest output before scaling. Set by PIDVelocity_Configure()
+        float Limit;			///< Highest output before scaling. Set by PIDVelocity_Configure()
+        float InverseMaximum;	///< 1 over the output scaling. Internal use only
+        float ErrorGain;		///< P + I times dt + D over dt. Internal use only
+        float LastErrorGain;	///< -(P + 2 D over dt). Internal use only
+        float PreviousErrorGain;	///< D over dt. Internal use only
+        float Tracking;			///< TrackingGain times dt. Internal use only
+        float LastError;		///< Last calculated  Error. Internal use only
+        float PreviousError;	///< The error before LastError. Internal use only
+        float Output;			///< Last output before scaling, always within the limits. Internal use only
+        float Unsaturated;		///< Last output before the clamp. Internal use only
+        
+    }PIDVelocityType;
+    
+    ///////////////////////////////////////////////////////////////////////////
+    /// \brief how many controllers a PIDBankType holds
+    ///////////////////////////////////////////////////////////////////////////
+    #ifndef PID_BANK_SIZE
+        #define PID_BANK_SIZE 32
+    #endif
+    
+    ///////////////////////////////////////////////////////////////////////////
+    /// \brief set to 0 to build PID_ProcessBatch() without SSE, AVX or
+    /// CMSIS-DSP
+    ///////////////////////////////////////////////////////////////////////////
+    #ifndef PID_BATCH_SIMD
+        #define PID_BATCH_SIMD 1
+    #endif
+    
+    ///////////////////////////////////////////////////////////////////////////
+    /// \brief a bank of controllers that share a sampling rate and output
+    /// range, ie. a set of zone heaters. Each value is kept in its own array
+    /// so PID_ProcessBatch() can work on several controllers at a time. Set
+    /// it up with PID_BankInit() and PID_BankAdd()
+    ///////////////////////////////////////////////////////////////////////////
+    typedef struct
+    {
+        uint16_t Count;								///< Controllers in the bank
+        float Minimum;								///< Lowest output before scaling
+        float Limit;								///< Highest output before scaling
+        float SamplingRate;							///< dt
+        float InverseMaximum;						///< 1 over the output scaling. Internal use only
+        float P[PID_BANK_SIZE];						///< P gains
+        float IntegralGain[PID_BANK_SIZE];			///< I times dt. Internal use only
+        float DerivativeGain[PID_BANK_SIZE];		///< D over dt. Internal use only
+        float LastError[PID_BANK_SIZE];				///< Last calculated  Error. Internal use only
+        float IntergralError[PID_BANK_SIZE];		///< Intergral error. Internal use only
+        
+    }PIDBankType;
+    
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+    
     void PID_Init(void);
+    void PID_Configure(PIDType *pidParameter, const float samplingRate, const float minimum, const float limit, const float maximum);
     float PID_Process(PIDType *pidParameter, const float targetValue, const float actualValue);
+    void PIDFixed_Init(PIDFixedType *pidParameter, const float p, const float i, const float d, const float scale);
+    int16_t PIDFixed_Process(PIDFixedType *pidParameter, const int16_t targetValue, const int16_t actualValue);
+    void PIDVelocity_Init(PIDVelocityType *pidParameter, const float p, const float i, const float d);
+    void PIDVelocity_Configure(PIDVelocityType *pidParameter, const float samplingRate, const float minimum, const float limit, const float maximum);
+    void PIDVelocity_AntiWindup(PIDVelocityType *pidParameter, const PIDAntiWindupEnum mode, const float trackingGain);
+    float PIDVelocity_Process(PIDVelocityType *pidParameter, const float targetValue, const float actualValue);
+    void PID_BankInit(PIDBankType *bank, const float samplingRate, const float minimum, const float limit, const float maximum);
+    int16_t PID_BankAdd(PIDBankType *bank, const float p, const float i, const float d);
+    void PID_ProcessBatch(PIDBankType *bank, const float *targetValues, const float *actualValues, float *outputs);
+    
+    #ifdef __cplusplus
+    }
+    #endif
     
     
 #endif
@@ -0,0 +1,326 @@
+///////////////////////////////////////////////////////////////////////////
+/// \file pid.hpp
+/// \brief Header only C++ PID controller for loops with a fixed tuning.
+/// The gains, sampling rate and output range are compile time constants so
+/// the coefficients and the clamp limits fold in to immediates. The C
+/// PID_Process() and PIDFixed_Process() are untouched, this is a separate
+/// controller that gives the same results.
+///
+/// PIDController repeats the PID_Process() and PIDFixed_Process() algorithms
+/// instead of calling them. Any change to either in pid.c has to be made
+/// here as well. Test/pidhppbench.cpp checks the two still match to the bit
+/// and times them. The float match needs the caller built without fused
+/// multiply add (-ffp-contract=off), pid.c turns it off itself.
+///
+///	Author: Ronald Alexander Nobrega De Sousa (Opticalworm)
+///	Website: www.HashDefineElectronics.com
+///
+///	Licences:
+///
+///		Copyright (c) 2014 Ronald Alexander Nobrega De Sousa
+///
+///		Permission is hereby granted, free of charge, to any person obtaining a copy
+///		of this software and associated documentation files (the "Software"), to deal
+///		in the Software without restriction, including without limitation the rights
+///		to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+///		copies of the Software, and to permit persons to whom the Software is
+///		furnished to do so, subject to the following conditions:
+///
+///		The above copyright notice and this permission notice shall be included in
+///		all copies or substantial portions of the Software.
+///
+///		THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///		IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///		FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///		AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///		LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///		OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///		THE SOFTWARE.
+///
+///
+///	Fixed Tuning Code Example:
+///	\code
+///	#include "pid.hpp"
+///
+///	// Floating point template arguments need C++20 so the tuning is a struct
+///	struct ZoneTuning
+///	{
+///	    static constexpr double P = 2.0;
+///	    static constexpr double I = 0.5;
+///	    static constexpr double D = 0.01;
+///	    static constexpr double SamplingRate = 0.01;
+///	    static constexpr double Minimum = 0;
+///	    static constexpr double Limit = 5;
+///	    static constexpr double Maximum = 10;
+///	    static constexpr double Scale = 128;		// only used by the int16_t Q15 controller
+///	};
+///
+///	PIDController<float, ZoneTuning> Zone;
+///	PIDController<int16_t, ZoneTuning> ZoneQ15;
+///
+///	void Heater_Interrupt(void) // every 10ms
+///	{
+///	    PWM_Set(Zone.Process(Target, Reading));
+///	}
+///	\endcode
+///////////////////////////////////////////////////////////////////////////
+#ifndef     __PID_HPP__
+#define     __PID_HPP__
+    #include <stdint.h>
+    #include <type_traits>
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// \brief PID controller with a compile time tuning. Same as PIDType set
+    /// up by PID_Configure(), down to the bit for float.
+    /// \tparam ValueType float or double. int16_t picks the Q15 controller
+    /// \tparam Tuning a struct with static constexpr P, I, D, SamplingRate,
+    /// Minimum, Limit and Maximum. See the example above
+    ///////////////////////////////////////////////////////////////////////////
+    template<typename ValueType, typename Tuning>
+    class PIDController
+    {
+        static_assert(std::is_floating_point<ValueType>::value, "PIDController is float, double or int16_t (Q15)");
+        static_assert(Tuning::SamplingRate > 0, "PIDController sampling rate must be above 0");
+        static_assert(Tuning::Maximum != 0, "PIDController maximum can't be 0");
+
+    public:
+        static constexpr ValueType P = ValueType(Tuning::P);                                                    ///< P gain
+        static constexpr ValueType IntegralGain = ValueType(Tuning::I) * ValueType(Tuning::SamplingRate);       ///< I times dt
+        static constexpr ValueType DerivativeGain = ValueType(Tuning::D) / ValueType(Tuning::SamplingRate);     ///< D over dt
+        static constexpr ValueType Minimum = ValueType(Tuning::Minimum);                                        ///< Lowest output before scaling
+        static constexpr ValueType Limit = ValueType(Tuning::Limit);                                            ///< Highest output before scaling
+        static constexpr ValueType InverseMaximum = ValueType(1) / ValueType(Tuning::Maximum);                  ///< 1 over the output scaling
+
+        constexpr PIDController() : LastError(0), IntergralError(0)
+        {
+        }
+
+        ///////////////////////////////////////////////////////////////////////////
+        /// \brief Clear the last error and the integral
+        ///////////////////////////////////////////////////////////////////////////
+        void Reset(void)
+        {
+            LastError = 0;
+            IntergralError = 0;
+        }
+
+        ///////////////////////////////////////////////////////////////////////////
+        /// \brief PID process controller. Same as PID_Process()
+        /// \param targetValue the target value to which the PID will aim for
+        /// \param actualValue the reading from the temperature sensor
+        ///
+        /// \return return heater PWM value
+        ///////////////////////////////////////////////////////////////////////////
+        ValueType Process(const ValueType targetValue, const ValueType actualValue)
+        {
+            ValueType Result;
+            ValueType CurrentError = (targetValue - actualValue);
+            ValueType DerivedError = (CurrentError - LastError);
+
+            IntergralError += CurrentError;
+
+            Result =    (P * CurrentError) +
+                        (IntegralGain * IntergralError) +
+                        (DerivativeGain * DerivedError);
+
+            LastError = CurrentError;
+
+            if(Result > Limit)
+            {
+                Result = Limit;
+            }
+            else if(Result <= Minimum)
+            {
+                Result = Minimum;
+            }
+
+            return (Result * InverseMaximum);
+        }
+
+    private:
+        ValueType LastError;                ///< Last calculated  Error
+        ValueType IntergralError;           ///< Intergral error
+    };
+
+    template<typename ValueType, typename Tuning> constexpr ValueType PIDController<ValueType, Tuning>::P;
+    template<typename ValueType, typename Tuning> constexpr ValueType PIDController<ValueType, Tuning>::IntegralGain;
+    template<typename ValueType, typename Tuning> constexpr ValueType PIDController<ValueType, Tuning>::DerivativeGain;
+    template<typename ValueType, typename Tuning> constexpr ValueType PIDController<ValueType, Tuning>::Minimum;
+    template<typename ValueType, typename Tuning> constexpr ValueType PIDController<ValueType, Tuning>::Limit;
+    template<typename ValueType, typename Tuning> constexpr ValueType PIDController<ValueType, Tuning>::InverseMaximum;
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// \brief Compile time versions of the PIDFixed_Init() helpers. C++11
+    /// constexpr functions are a single return so the loops are recursion.
+    /// Internal use only
+    ///////////////////////////////////////////////////////////////////////////
+    namespace PIDFixedConstant
+    {
+        /// \brief the gain magnitude, float like PIDFixed_Gain()
+        constexpr float Magnitude(const float gain)
+        {
+            return (gain < 0) ? -gain : gain;
+        }
+
+        /// \brief exponent that puts the magnitude between 0.5 and 1
+        constexpr int Exponent(const float magnitude, const int exponent)
+        {
+            return (magnitude == 0) ? 0 :
+                   (magnitude >= 1.0f) ? Exponent(magnitude * 0.5f, exponent + 1) :
+                   (magnitude < 0.5f) ? Exponent(magnitude * 2.0f, exponent - 1) : exponent;
+        }
+
+        /// \brief scale by a power of two, exact
+        constexpr float Power(const float value, const int exponent)
+        {
+            return (exponent > 0) ? Power(value * 0.5f, exponent - 1) :
+                   (exponent < 0) ? Power(value * 2.0f, exponent + 1) : value;
+        }
+
+        /// \brief the Q31 mantissa
+        constexpr int32_t Mantissa(const float gain)
+        {
+            return (gain < 0) ? -(int32_t)(Power(Magnitude(gain), Exponent(Magnitude(gain), 0)) * 2147483648.0f) :
+                                 (int32_t)(Power(Magnitude(gain), Exponent(Magnitude(gain), 0)) * 2147483648.0f);
+        }
+
+        /// \brief the shift that lines a Q15 value times the mantissa up with Q31
+        constexpr int8_t Shift(const float gain)
+        {
+            return (Magnitude(gain) == 0) ? 0 : (int8_t)(Exponent(Magnitude(gain), 0) - 15);
+        }
+
+        /// \brief same as PIDFixed_ToQ31()
+        constexpr int32_t ToQ31(const float value)
+        {
+            return (value >= 1.0f) ? INT32_MAX : ((value <= -1.0f) ? INT32_MIN : (int32_t)(value * 2147483648.0f));
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// \brief Q15 PID controller with a compile time tuning. Same as
+    /// PIDFixedType set up by PIDFixed_Init(), down to the bit, with the
+    /// tuning's sampling rate and output range in place of the pid.c
+    /// defaults. Tuning also needs a static constexpr Scale, the value that
+    /// maps to 1.0 in Q15.
+    ///////////////////////////////////////////////////////////////////////////
+    template<typename Tuning>
+    class PIDController<int16_t, Tuning>
+    {
+        static_assert(Tuning::SamplingRate > 0, "PIDController sampling rate must be above 0");
+        static_assert(Tuning::Maximum != 0, "PIDController maximum can't be 0");
+
+        // Worked out in float, in the same order as PIDFixed_Init()
+        static constexpr float PGain = (float)Tuning::P * (float)Tuning::Scale / (float)Tuning::Maximum;
+        static constexpr float IGain = (float)Tuning::I * (float)Tuning::SamplingRate * (float)Tuning::Scale / (float)Tuning::Maximum;
+        static constexpr float DGain = (float)Tuning::D * (float)Tuning::Scale / ((float)Tuning::SamplingRate * (float)Tuning::Maximum);
+
+    public:
+        static constexpr int32_t P = PIDFixedConstant::Mantissa(PGain);                                 ///< P gain mantissa
+        static constexpr int8_t PShift = PIDFixedConstant::Shift(PGain);                                ///< P gain exponent
+        static constexpr int32_t I = PIDFixedConstant::Mantissa(IGain);                                 ///< I gain mantissa, dt folded in
+        static constexpr int8_t IShift = PIDFixedConstant::Shift(IGain);                                ///< I gain exponent
+        static constexpr int32_t D = PIDFixedConstant::Mantissa(DGain);                                 ///< D gain mantissa, dt folded in
+        static constexpr int8_t DShift = PIDFixedConstant::Shift(DGain);                                ///< D gain exponent
+        static constexpr int32_t Limit = PIDFixedConstant::ToQ31((float)Tuning::Limit / (float)Tuning::Maximum);        ///< Highest output in Q31
+        static constexpr int32_t Minimum = PIDFixedConstant::ToQ31((float)Tuning::Minimum / (float)Tuning::Maximum);    ///< Lowest output in Q31
+
+        constexpr PIDController() : LastError(0), IntergralError(0)
+        {
+        }
+
+        ///////////////////////////////////////////////////////////////////////////
+        /// \brief Clear the last error and the integral
+        ///////////////////////////////////////////////////////////////////////////
+        void Reset(void)
+        {
+            LastError = 0;
+            IntergralError = 0;
+        }
+
+        ///////////////////////////////////////////////////////////////////////////
+        /// \brief PID process controller. Same as PIDFixed_Process()
+        /// \param targetValue the target value in Q15, see Scale
+        /// \param actualValue the reading from the temperature sensor in Q15
+        ///
+        /// \return return heater PWM value in Q15
+        ///////////////////////////////////////////////////////////////////////////
+        int16_t Process(const int16_t targetValue, const int16_t actualValue)
+        {
+            int64_t Result;
+            int64_t Integral;
+            int32_t CurrentError = (int32_t)targetValue - actualValue;
+
+            Integral = (int64_t)IntergralError + CurrentError;
+            IntergralError = (Integral > INT32_MAX) ? INT32_MAX : ((Integral < INT32_MIN) ? INT32_MIN : (int32_t)Integral);
+
+            Result =    Multiply(P, PShift, CurrentError) +
+                        Multiply(I, IShift, IntergralError) +
+                        Multiply(D, DShift, CurrentError - LastError);
+
+            LastError = CurrentError;
+
+            if(Result > Limit)
+            {
+                Result = Limit;
+            }
+            else if(Result <= Minimum)
+            {
+                Result = Minimum;
+            }
+
+            Result = (Result + 0x8000) >> 16;
+
+            if(Result > INT16_MAX)
+            {
+                Result = INT16_MAX;
+            }
+
+            return (int16_t)Result;
+        }
+
+    private:
+        ///////////////////////////////////////////////////////////////////////////
+        /// \brief Same as PIDFixed_Multiply(). The shift is a constant so only
+        /// one branch is left after inlining
+        ///////////////////////////////////////////////////////////////////////////
+        static int64_t Multiply(const int32_t mantissa, const int8_t shift, const int32_t value)
+        {
+            const int64_t TermMax = INT64_MAX >> 2;
+            int64_t Result = (int64_t)mantissa * value;
+
+            if(shift >= 0)
+            {
+                if((shift > 61) || (Result > (TermMax >> shift)) || (Result < -(TermMax >> shift)))
+                {
+                    return (Result > 0) ? TermMax : ((Result < 0) ? -TermMax : 0);
+                }
+
+                return Result * ((int64_t)1 << shift);
+            }
+
+            if(shift < -62)
+            {
+                return 0;
+            }
+
+            return (Result + ((int64_t)1 << (-shift - 1))) >> -shift;
+        }
+
+        int32_t LastError;                  ///< Last calculated  Error in Q15
+        int32_t IntergralError;             ///< Intergral error in Q15
+    };
+
+    template<typename Tuning> constexpr float PIDController<int16_t, Tuning>::PGain;
+    template<typename Tuning> constexpr float PIDController<int16_t, Tuning>::IGain;
+    template<typename Tuning> constexpr float PIDController<int16_t, Tuning>::DGain;
+    template<typename Tuning> constexpr int32_t PIDController<int16_t, Tuning>::P;
+    template<typename Tuning> constexpr int8_t PIDController<int16_t, Tuning>::PShift;
+    template<typename Tuning> constexpr int32_t PIDController<int16_t, Tuning>::I;
+    template<typename Tuning> constexpr int8_t PIDController<int16_t, Tuning>::IShift;
+    template<typename Tuning> constexpr int32_t PIDController<int16_t, Tuning>::D;
+    template<typename Tuning> constexpr int8_t PIDController<int16_t, Tuning>::DShift;
+    template<typename Tuning> constexpr int32_t PIDController<int16_t, Tuning>::Limit;
+    template<typename Tuning> constexpr int32_t PIDController<int16_t, Tuning>::Minimum;
+
+#endif